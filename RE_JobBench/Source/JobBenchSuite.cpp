@@ -0,0 +1,664 @@
+#include "stdio.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "JobSystem/JobSystem.h"
+#include "JobSystem/Fiber.h"
+#include "JobBenchSuite.h"
+
+struct JobBenchResult
+{
+	const char* name = 0;
+	int64_t opCount = 0;
+	double seconds = 0;
+	// microseconds
+	REArray<double> samples;
+	bool bPassed = true;
+};
+
+struct JobBenchSuiteData
+{
+	REArray<JobBenchResult> results;
+};
+
+__forceinline int64_t GetBenchTimeNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// nearest rank, samples must be sorted
+double GetPercentile(const REArray<double>& samples, double percentile)
+{
+	if (samples.empty())
+		return 0;
+	int rank = (int)(percentile / 100.0 * samples.size() + 0.5);
+	rank = std::min(std::max(rank, 1), (int)samples.size());
+	return samples[rank - 1];
+}
+
+void BusyWaitNs(int64_t durationNs)
+{
+	int64_t endTime = GetBenchTimeNs() + durationNs;
+	while (GetBenchTimeNs() < endTime)
+		;
+}
+
+JOB_ENTRY_POINT(EmptyJob)
+{
+}
+
+std::atomic<int64_t> gBenchJobCount(0);
+
+JOB_ENTRY_POINT(CountJob)
+{
+	gBenchJobCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+// -- empty job throughput: batches of empty jobs, sample is one batch from RunJobs to WaitOnCounter return
+
+void RunEmptyJobTest(JobBenchResult& result)
+{
+	const int batchSize = 1024;
+	const int batchCount = 256;
+	REArray<JobDescriptor> jobDescs(batchSize, JobDescriptor(&EmptyJob, 0, EJobPriority::Normal, gJobSmallStackSize));
+
+	int64_t startTime = GetBenchTimeNs();
+	for (int i = 0; i < batchCount; ++i)
+	{
+		int64_t batchStartTime = GetBenchTimeNs();
+		JobWaitingCounter counter;
+		RunJobs(jobDescs.data(), batchSize, &counter);
+		WaitOnCounter(&counter);
+		result.samples.push_back((GetBenchTimeNs() - batchStartTime) / 1000.0);
+	}
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+	result.opCount = (int64_t)batchSize * batchCount;
+}
+
+// -- fan-out/fan-in: one job spawns children and waits on them, sample is the whole parent
+
+const int gFanOutCount = 64;
+
+JOB_ENTRY_POINT(FanOutJob)
+{
+	JobDescriptor jobDescs[gFanOutCount];
+	for (int i = 0; i < gFanOutCount; ++i)
+		jobDescs[i] = JobDescriptor(&CountJob, 0, EJobPriority::Normal, gJobSmallStackSize);
+	JobWaitingCounter counter;
+	RunJobs(jobDescs, gFanOutCount, &counter);
+	WaitOnCounter(&counter);
+}
+
+void RunFanOutTest(JobBenchResult& result)
+{
+	const int sampleCount = 1000;
+	gBenchJobCount = 0;
+
+	int64_t startTime = GetBenchTimeNs();
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		int64_t sampleStartTime = GetBenchTimeNs();
+		JobDescriptor jobDesc(&FanOutJob);
+		JobWaitingCounter counter;
+		RunJobs(&jobDesc, 1, &counter);
+		WaitOnCounter(&counter);
+		result.samples.push_back((GetBenchTimeNs() - sampleStartTime) / 1000.0);
+	}
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+	result.opCount = (int64_t)sampleCount * (gFanOutCount + 1);
+	result.bPassed = (gBenchJobCount == (int64_t)sampleCount * gFanOutCount);
+}
+
+// -- nested waits: binary tree of jobs, every inner job waits on its two children
+
+const int gNestedDepth = 8;
+
+JOB_ENTRY_POINT(NestedJob)
+{
+	int depth = (int)(intptr_t)customDataPtr;
+	gBenchJobCount.fetch_add(1, std::memory_order_relaxed);
+	if (depth <= 1)
+		return;
+	JobDescriptor jobDescs[2] = {
+		JobDescriptor(&NestedJob, (void*)(intptr_t)(depth - 1), EJobPriority::Normal, gJobSmallStackSize),
+		JobDescriptor(&NestedJob, (void*)(intptr_t)(depth - 1), EJobPriority::Normal, gJobSmallStackSize),
+	};
+	JobWaitingCounter counter;
+	RunJobs(jobDescs, 2, &counter);
+	WaitOnCounter(&counter);
+}
+
+void RunNestedWaitTest(JobBenchResult& result)
+{
+	const int sampleCount = 200;
+	const int64_t treeJobCount = (1 << gNestedDepth) - 1;
+	gBenchJobCount = 0;
+
+	int64_t startTime = GetBenchTimeNs();
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		int64_t sampleStartTime = GetBenchTimeNs();
+		JobDescriptor jobDesc(&NestedJob, (void*)(intptr_t)gNestedDepth, EJobPriority::Normal, gJobSmallStackSize);
+		JobWaitingCounter counter;
+		RunJobs(&jobDesc, 1, &counter);
+		WaitOnCounter(&counter);
+		result.samples.push_back((GetBenchTimeNs() - sampleStartTime) / 1000.0);
+	}
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+	result.opCount = treeJobCount * sampleCount;
+	result.bPassed = (gBenchJobCount == treeJobCount * sampleCount);
+}
+
+// -- priority inversion: every worker is busy with long low priority jobs when one of them submits a high priority job
+// sample is how long the high priority job waits to start, bounded by a low job if priorities are honored
+
+const int64_t gLowJobDurationNs = 100 * 1000;
+
+JOB_ENTRY_POINT(LowPriorityJob)
+{
+	BusyWaitNs(gLowJobDurationNs);
+}
+
+struct PriorityInversionData
+{
+	JobWaitingCounter* counterPtr = 0;
+	int64_t submitTime = 0;
+	int64_t startTime = 0;
+};
+
+JOB_ENTRY_POINT(HighPriorityJob)
+{
+	PriorityInversionData* testData = (PriorityInversionData*)customDataPtr;
+	testData->startTime = GetBenchTimeNs();
+}
+
+JOB_ENTRY_POINT(PriorityInversionTriggerJob)
+{
+	PriorityInversionData* testData = (PriorityInversionData*)customDataPtr;
+	BusyWaitNs(gLowJobDurationNs / 4);
+	// same counter, it can't reach 0 before we return
+	JobDescriptor jobDesc(&HighPriorityJob, testData, EJobPriority::High, gJobSmallStackSize);
+	testData->submitTime = GetBenchTimeNs();
+	RunJobs(&jobDesc, 1, testData->counterPtr);
+	BusyWaitNs(gLowJobDurationNs * 3 / 4);
+}
+
+void RunPriorityInversionTest(JobBenchResult& result)
+{
+	const int sampleCount = 200;
+	// enough to keep every worker busy for a few rounds
+	const int lowJobCount = gJobSystemWorkerThreadCount * 4;
+	REArray<JobDescriptor> jobDescs(lowJobCount, JobDescriptor(&LowPriorityJob, 0, EJobPriority::Low, gJobSmallStackSize));
+	jobDescs.push_back(JobDescriptor(&PriorityInversionTriggerJob, 0, EJobPriority::Low, gJobSmallStackSize));
+
+	int64_t startTime = GetBenchTimeNs();
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		JobWaitingCounter counter;
+		PriorityInversionData testData;
+		testData.counterPtr = &counter;
+		jobDescs.back().dataPtr = &testData;
+		RunJobs(jobDescs.data(), (int)jobDescs.size(), &counter);
+		WaitOnCounter(&counter);
+		result.samples.push_back((testData.startTime - testData.submitTime) / 1000.0);
+	}
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+	result.opCount = (int64_t)sampleCount * (lowJobCount + 2);
+}
+
+// -- starvation: every worker is flooded with high priority jobs that keep resubmitting themselves, low priority jobs still have
+// to start before the flood ends (gJobPriorityWeights), sample is how long one low priority job waits to start
+
+const int64_t gFloodDurationNs = 100 * 1000 * 1000;
+const int64_t gFloodJobDurationNs = 20 * 1000;
+
+struct StarvationData
+{
+	JobWaitingCounter* floodCounterPtr = 0;
+	int64_t floodEndTime = 0;
+};
+
+JOB_ENTRY_POINT(FloodJob)
+{
+	StarvationData* testData = (StarvationData*)customDataPtr;
+	BusyWaitNs(gFloodJobDurationNs);
+	if (GetBenchTimeNs() < testData->floodEndTime)
+	{
+		JobDescriptor jobDesc(&FloodJob, testData, EJobPriority::High, gJobSmallStackSize);
+		RunJobs(&jobDesc, 1, testData->floodCounterPtr);
+	}
+}
+
+JOB_ENTRY_POINT(StarvedJob)
+{
+	*(int64_t*)customDataPtr = GetBenchTimeNs();
+}
+
+void RunStarvationTest(JobBenchResult& result)
+{
+	const int maxSampleCount = 200;
+	JobWaitingCounter floodCounter;
+	StarvationData testData;
+	testData.floodCounterPtr = &floodCounter;
+	testData.floodEndTime = GetBenchTimeNs() + gFloodDurationNs;
+
+	// a few chains per worker so the high queues are never empty
+	int64_t startTime = GetBenchTimeNs();
+	REArray<JobDescriptor> floodJobDescs(gJobSystemWorkerThreadCount * 4, JobDescriptor(&FloodJob, &testData, EJobPriority::High, gJobSmallStackSize));
+	RunJobs(floodJobDescs.data(), (int)floodJobDescs.size(), &floodCounter);
+
+	int starvedCount = 0;
+	while ((int)result.samples.size() < maxSampleCount && GetBenchTimeNs() < testData.floodEndTime)
+	{
+		int64_t jobStartTime = 0;
+		JobDescriptor jobDesc(&StarvedJob, &jobStartTime, EJobPriority::Low, gJobSmallStackSize);
+		int64_t submitTime = GetBenchTimeNs();
+		JobWaitingCounter counter;
+		RunJobs(&jobDesc, 1, &counter);
+		WaitOnCounter(&counter);
+		if (jobStartTime >= testData.floodEndTime)
+			++starvedCount;
+		result.samples.push_back((jobStartTime - submitTime) / 1000.0);
+	}
+	WaitOnCounter(&floodCounter);
+
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+	result.opCount = (int64_t)result.samples.size();
+	// the last one can be unlucky and get submitted right before the flood ends
+	result.bPassed = (result.samples.size() > 1 && starvedCount <= 1);
+}
+
+// -- cooperative yield: same as priority inversion, but the low priority jobs call JobYield between short slices,
+// so the high priority job should start after a slice instead of a whole low job
+
+const int gYieldSliceCount = 10;
+
+JOB_ENTRY_POINT(YieldingLowPriorityJob)
+{
+	for (int i = 0; i < gYieldSliceCount; ++i)
+	{
+		BusyWaitNs(gLowJobDurationNs / gYieldSliceCount);
+		JobYield();
+	}
+	gBenchJobCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+JOB_ENTRY_POINT(YieldTriggerJob)
+{
+	PriorityInversionData* testData = (PriorityInversionData*)customDataPtr;
+	BusyWaitNs(gLowJobDurationNs / 4);
+	JobDescriptor jobDesc(&HighPriorityJob, testData, EJobPriority::High, gJobSmallStackSize);
+	testData->submitTime = GetBenchTimeNs();
+	RunJobs(&jobDesc, 1, testData->counterPtr);
+	YieldingLowPriorityJob(0);
+}
+
+void RunYieldTest(JobBenchResult& result)
+{
+	const int sampleCount = 200;
+	const int lowJobCount = gJobSystemWorkerThreadCount * 4;
+	REArray<JobDescriptor> jobDescs(lowJobCount, JobDescriptor(&YieldingLowPriorityJob, 0, EJobPriority::Low, gJobSmallStackSize));
+	jobDescs.push_back(JobDescriptor(&YieldTriggerJob, 0, EJobPriority::Low, gJobSmallStackSize));
+	gBenchJobCount = 0;
+
+	int64_t startTime = GetBenchTimeNs();
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		JobWaitingCounter counter;
+		PriorityInversionData testData;
+		testData.counterPtr = &counter;
+		jobDescs.back().dataPtr = &testData;
+		RunJobs(jobDescs.data(), (int)jobDescs.size(), &counter);
+		WaitOnCounter(&counter);
+		result.samples.push_back((testData.startTime - testData.submitTime) / 1000.0);
+	}
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+	result.opCount = (int64_t)sampleCount * (lowJobCount + 2);
+	result.bPassed = (gBenchJobCount == (int64_t)sampleCount * (lowJobCount + 1));
+}
+
+// -- cancellation: a big batch of low priority jobs is cancelled shortly after it's queued, the rest must be dropped
+// without running, sample is from Cancel to the batch counter reaching 0
+
+const int gCancelBatchSize = 4096;
+
+JOB_ENTRY_POINT(CancellableJob)
+{
+	BusyWaitNs(5 * 1000);
+	gBenchJobCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RunCancelTest(JobBenchResult& result)
+{
+	const int sampleCount = 50;
+	REArray<JobDescriptor> jobDescs(gCancelBatchSize, JobDescriptor(&CancellableJob, 0, EJobPriority::Low, gJobSmallStackSize));
+	gBenchJobCount = 0;
+#if JOB_STATS
+	REArray<JobPriorityStats> startStats;
+	GetJobPriorityStats(startStats);
+#endif
+
+	int64_t startTime = GetBenchTimeNs();
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		JobCancellationToken token;
+		for (int jobIdx = 0; jobIdx < gCancelBatchSize; ++jobIdx)
+			jobDescs[jobIdx].cancellationTokenPtr = &token;
+		JobWaitingCounter counter;
+		RunJobs(jobDescs.data(), gCancelBatchSize, &counter);
+		BusyWaitNs(gLowJobDurationNs);
+		int64_t cancelTime = GetBenchTimeNs();
+		token.Cancel();
+		WaitOnCounter(&counter);
+		result.samples.push_back((GetBenchTimeNs() - cancelTime) / 1000.0);
+	}
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+	result.opCount = (int64_t)sampleCount * gCancelBatchSize;
+	// every batch was cut short, and every job either ran or was dropped
+	int64_t ranCount = gBenchJobCount;
+	result.bPassed = (ranCount < result.opCount);
+#if JOB_STATS
+	REArray<JobPriorityStats> endStats;
+	GetJobPriorityStats(endStats);
+	int64_t cancelledCount = endStats[(int)EJobPriority::Low].cancelledCount - startStats[(int)EJobPriority::Low].cancelledCount;
+	result.bPassed &= (ranCount + cancelledCount == result.opCount);
+#endif
+}
+
+// -- scratch arena: jobs build many small temporary arrays from their fiber's arena, every 16th also a big one that
+// doesn't fit the first block, the inline run shares the waiting fiber's arena, sample is one batch
+
+const int gScratchBatchSize = 256;
+const int gScratchArrayCount = 16;
+const int gScratchSmallCount = 64;
+const int gScratchBigCount = 16 * 1024;
+
+std::atomic<int64_t> gScratchErrorCount(0);
+
+struct ScratchVector
+{
+	float v[4];
+};
+
+template<class TArray>
+void FillScratchArray(TArray& values, int count)
+{
+	for (int i = 0; i < count; ++i)
+		values.push_back(i);
+}
+
+JOB_ENTRY_POINT(ScratchJob)
+{
+	if (!GetCurrentJobScratchArena())
+		gScratchErrorCount.fetch_add(1, std::memory_order_relaxed);
+
+	int64_t sum = 0;
+	int64_t expectedSum = 0;
+	for (int arrayIdx = 0; arrayIdx < gScratchArrayCount; ++arrayIdx)
+	{
+		REScratchArray<int> values;
+		FillScratchArray(values, gScratchSmallCount);
+		REScratchArray<ScratchVector, 16> vectors(values.size());
+		if (((uintptr_t)vectors.data() & 15) != 0)
+			gScratchErrorCount.fetch_add(1, std::memory_order_relaxed);
+		for (int i = 0; i < (int)values.size(); ++i)
+			sum += values[i];
+		expectedSum += (int64_t)gScratchSmallCount * (gScratchSmallCount - 1) / 2;
+	}
+	if (((intptr_t)customDataPtr % 16) == 0)
+	{
+		REScratchArray<int> values;
+		FillScratchArray(values, gScratchBigCount);
+		for (int i = 0; i < (int)values.size(); ++i)
+			sum += values[i];
+		expectedSum += (int64_t)gScratchBigCount * (gScratchBigCount - 1) / 2;
+	}
+	if (sum != expectedSum)
+		gScratchErrorCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RunScratchTest(JobBenchResult& result)
+{
+	const int sampleCount = 100;
+	REArray<JobDescriptor> jobDescs;
+	for (int i = 0; i < gScratchBatchSize; ++i)
+		jobDescs.push_back(JobDescriptor(&ScratchJob, (void*)(intptr_t)i, EJobPriority::Normal, gJobSmallStackSize));
+	gScratchErrorCount = 0;
+
+	int64_t startTime = GetBenchTimeNs();
+	for (int i = 0; i < sampleCount; ++i)
+	{
+		int64_t sampleStartTime = GetBenchTimeNs();
+		JobWaitingCounter counter;
+		RunJobs(jobDescs.data(), gScratchBatchSize, &counter);
+		WaitOnCounter(&counter);
+		result.samples.push_back((GetBenchTimeNs() - sampleStartTime) / 1000.0);
+	}
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+	result.opCount = (int64_t)sampleCount * gScratchBatchSize;
+	result.bPassed = (gScratchErrorCount == 0);
+}
+
+// -- contention: many producers call RunJobs at once, workers as jobs and threads outside the job system
+// sample is a single RunJobs call
+
+const int gProducerJobCount = 4096;
+const int gProducerThreadCount = 2;
+
+struct ProducerData
+{
+	JobWaitingCounter* counterPtr = 0;
+	REArray<double> samples;
+};
+
+void RunProducer(ProducerData* producerData)
+{
+	JobDescriptor jobDesc(&CountJob, 0, EJobPriority::Normal, gJobSmallStackSize);
+	producerData->samples.reserve(gProducerJobCount);
+	for (int i = 0; i < gProducerJobCount; ++i)
+	{
+		int64_t callStartTime = GetBenchTimeNs();
+		RunJobs(&jobDesc, 1, producerData->counterPtr);
+		producerData->samples.push_back((GetBenchTimeNs() - callStartTime) / 1000.0);
+	}
+}
+
+JOB_ENTRY_POINT(ProducerJob)
+{
+	RunProducer((ProducerData*)customDataPtr);
+}
+
+void RunContentionTest(JobBenchResult& result)
+{
+	int producerJobCount = gJobSystemWorkerThreadCount;
+	int producerCount = producerJobCount + gProducerThreadCount;
+	REArray<ProducerData> producerDataList(producerCount);
+	gBenchJobCount = 0;
+
+	JobWaitingCounter counter;
+	for (int i = 0; i < producerCount; ++i)
+		producerDataList[i].counterPtr = &counter;
+
+	int64_t startTime = GetBenchTimeNs();
+
+	// threads first, they only finish their pushes, the jobs they push are on the counter
+	REArray<std::thread*> producerThreads;
+	for (int i = 0; i < gProducerThreadCount; ++i)
+		producerThreads.push_back(new std::thread(&RunProducer, &producerDataList[producerJobCount + i]));
+
+	REArray<JobDescriptor> producerJobDescs(producerJobCount);
+	for (int i = 0; i < producerJobCount; ++i)
+		producerJobDescs[i] = JobDescriptor(&ProducerJob, &producerDataList[i]);
+	JobWaitingCounter producerCounter;
+	RunJobs(producerJobDescs.data(), producerJobCount, &producerCounter);
+	WaitOnCounter(&producerCounter);
+
+	// joining blocks this worker, fine, it's short and the others keep running
+	for (int i = 0; i < gProducerThreadCount; ++i)
+	{
+		producerThreads[i]->join();
+		delete producerThreads[i];
+	}
+	WaitOnCounter(&counter);
+
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+	result.opCount = (int64_t)producerCount * gProducerJobCount;
+	for (int i = 0; i < producerCount; ++i)
+		result.samples.insert(result.samples.end(), producerDataList[i].samples.begin(), producerDataList[i].samples.end());
+	result.bPassed = (gBenchJobCount == result.opCount);
+}
+
+// -- reader writer lock: every worker reads a pair of values that writers keep equal, one write every few reads
+// readers must never see a half done write, sample is one lock acquire (every 16th)
+
+struct RWLockTestValue
+{
+	int64_t first = 0;
+	int64_t second = 0;
+};
+
+const int gRWLockOpCount = 20000;
+const int gRWLockReadsPerWrite = 8;
+
+struct RWLockTestData
+{
+	ThreadProtected<RWLockTestValue, SpinLockReaderWriter> value;
+	std::atomic<int64_t> tornReadCount = 0;
+	ThreadProtected<REArray<double>, SpinLock> samples;
+};
+
+JOB_ENTRY_POINT(RWLockJob)
+{
+	RWLockTestData* testData = (RWLockTestData*)customDataPtr;
+	REArray<double> samples;
+	samples.reserve(gRWLockOpCount / 16);
+	for (int i = 0; i < gRWLockOpCount; ++i)
+	{
+		int64_t acquireStartTime = GetBenchTimeNs();
+		int64_t acquireTime = 0;
+		if (i % gRWLockReadsPerWrite == 0)
+		{
+			RWLockTestValue& value = testData->value.AcquireReadWrite();
+			acquireTime = GetBenchTimeNs() - acquireStartTime;
+			++value.first;
+			++value.second;
+			testData->value.ReleaseReadWrite();
+		}
+		else
+		{
+			const RWLockTestValue& value = testData->value.AcquireReadOnly();
+			acquireTime = GetBenchTimeNs() - acquireStartTime;
+			if (value.first != value.second)
+				testData->tornReadCount.fetch_add(1, std::memory_order_relaxed);
+			testData->value.ReleaseReadOnly();
+		}
+		if (i % 16 == 0)
+			samples.push_back(acquireTime / 1000.0);
+	}
+	SCOPED_READ_WRITE_REF(testData->samples, sampleListRef)
+	sampleListRef.insert(sampleListRef.end(), samples.begin(), samples.end());
+}
+
+void RunRWLockTest(JobBenchResult& result)
+{
+	RWLockTestData testData;
+	REArray<JobDescriptor> jobDescs(gJobSystemWorkerThreadCount, JobDescriptor(&RWLockJob, &testData, EJobPriority::Normal, gJobSmallStackSize));
+
+	int64_t startTime = GetBenchTimeNs();
+	JobWaitingCounter counter;
+	RunJobs(jobDescs.data(), (int)jobDescs.size(), &counter);
+	WaitOnCounter(&counter);
+	result.seconds = (GetBenchTimeNs() - startTime) / 1e9;
+
+	result.opCount = (int64_t)jobDescs.size() * gRWLockOpCount;
+	SCOPED_READ_WRITE_REF(testData.samples, sampleListRef)
+	result.samples.swap(sampleListRef);
+	const RWLockTestValue& value = testData.value.AcquireReadOnly();
+	int64_t writeCount = (int64_t)jobDescs.size() * ((gRWLockOpCount + gRWLockReadsPerWrite - 1) / gRWLockReadsPerWrite);
+	result.bPassed = (testData.tornReadCount == 0 && value.first == writeCount && value.second == writeCount);
+	testData.value.ReleaseReadOnly();
+}
+
+typedef void(*JobBenchTestFunc)(JobBenchResult& result);
+
+struct JobBenchTest
+{
+	const char* name;
+	JobBenchTestFunc func;
+};
+
+const JobBenchTest gJobBenchTests[] =
+{
+	{ "empty_job", &RunEmptyJobTest },
+	{ "fan_out_in", &RunFanOutTest },
+	{ "nested_wait", &RunNestedWaitTest },
+	{ "priority_inversion", &RunPriorityInversionTest },
+	{ "starvation", &RunStarvationTest },
+	{ "yield", &RunYieldTest },
+	{ "cancel", &RunCancelTest },
+	{ "scratch", &RunScratchTest },
+	{ "contention", &RunContentionTest },
+	{ "rw_lock", &RunRWLockTest },
+};
+
+JOB_ENTRY_POINT(JobBenchSuiteMain)
+{
+	JobBenchSuiteData* suiteData = (JobBenchSuiteData*)customDataPtr;
+
+	for (int i = 0; i < (int)(sizeof(gJobBenchTests) / sizeof(gJobBenchTests[0])); ++i)
+	{
+		JobBenchResult result;
+		result.name = gJobBenchTests[i].name;
+		gJobBenchTests[i].func(result);
+		std::sort(result.samples.begin(), result.samples.end());
+		suiteData->results.push_back(result);
+	}
+
+	StopJobSystem();
+}
+
+bool RunJobBenchSuite(EJobBenchOutput output, int workerCount, FILE* file)
+{
+	JobBenchSuiteData suiteData;
+	JobDescriptor startJobDesc(&JobBenchSuiteMain, &suiteData);
+	RunJobSystem(&startJobDesc, workerCount);
+
+	bool bPassed = true;
+	if (output == EJobBenchOutput::CSV)
+	{
+		fprintf(file, "test, backend, workers, ops, seconds, ops/sec, samples, p50 us, p99 us, max us, passed\n");
+	}
+	else
+	{
+		fprintf(file, "{\n\t\"backend\": \"%s\",\n\t\"workers\": %d,\n\t\"results\": [\n", FIBER_BACKEND_NAME, workerCount);
+	}
+
+	for (int i = 0, ni = (int)suiteData.results.size(); i < ni; ++i)
+	{
+		const JobBenchResult& result = suiteData.results[i];
+		double opsPerSec = (result.seconds > 0) ? result.opCount / result.seconds : 0;
+		double maxSample = result.samples.empty() ? 0 : result.samples.back();
+		bPassed &= result.bPassed;
+
+		if (output == EJobBenchOutput::CSV)
+		{
+			fprintf(file, "%s, %s, %d, %lld, %f, %.0f, %d, %.2f, %.2f, %.2f, %d\n", result.name, FIBER_BACKEND_NAME, workerCount,
+				(long long)result.opCount, result.seconds, opsPerSec, (int)result.samples.size(),
+				GetPercentile(result.samples, 50), GetPercentile(result.samples, 99), maxSample, result.bPassed ? 1 : 0);
+		}
+		else
+		{
+			fprintf(file, "\t\t{ \"test\": \"%s\", \"ops\": %lld, \"seconds\": %f, \"ops_per_sec\": %.0f, \"samples\": %d, "
+				"\"p50_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f, \"passed\": %s }%s\n",
+				result.name, (long long)result.opCount, result.seconds, opsPerSec, (int)result.samples.size(),
+				GetPercentile(result.samples, 50), GetPercentile(result.samples, 99), maxSample, result.bPassed ? "true" : "false",
+				(i + 1 < ni) ? "," : "");
+		}
+	}
+
+	if (output == EJobBenchOutput::JSON)
+		fprintf(file, "\t]\n}\n");
+
+	return bPassed;
+}
\ No newline at end of file
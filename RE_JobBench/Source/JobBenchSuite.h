@@ -0,0 +1,15 @@
+#pragma once
+
+#include "stdio.h"
+
+// scheduler benchmark/stress suite, no window or GL needed so it runs on a headless box
+// every test collects latency samples, reported as p50/p99/max
+enum class EJobBenchOutput
+{
+	CSV,
+	JSON,
+};
+
+// results go to file, workers print their start up lines to stderr so stdout is only the results
+// returns false if a test didn't get the expected result (lost or duplicated jobs)
+extern bool RunJobBenchSuite(EJobBenchOutput output, int workerCount, FILE* file);
\ No newline at end of file
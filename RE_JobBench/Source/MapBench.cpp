@@ -0,0 +1,228 @@
+#include "stdio.h"
+#include <chrono>
+#include <random>
+#include <string>
+
+#include "Containers/Containers.h"
+#include "MapBench.h"
+
+struct MapBenchResult
+{
+	double seconds = 0;
+	// sum of what was found, must be the same for every container
+	double checkSum = 0;
+};
+
+// roughly the names ScopedProfileTimerCPU builds, long shared prefixes
+static void MakeProfilerNames(int keyCount, REArray<std::string>& names)
+{
+	char name[256];
+	for (int i = 0; i < keyCount; ++i)
+	{
+		snprintf(name, sizeof(name), "/Frame/Render/Pass%d/SubPass%d/Job%d", i % 17, i % 5, i);
+		names.push_back(name);
+	}
+}
+
+template<class TMap, class TLookup>
+MapBenchResult RunMapLookup(TMap& map, int lookupCount, const TLookup& lookup)
+{
+	MapBenchResult result;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < lookupCount; ++i)
+	{
+		auto it = lookup(map, i);
+		if (it != map.end())
+			result.checkSum += it->second;
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	result.seconds = std::chrono::duration<double>(end - start).count();
+	return result;
+}
+
+template<class TMap>
+bool RunStringMapBench(const char* mapName, const REArray<std::string>& names, const REArray<std::string>& missingNames, int roundCount, const double* expectedSums)
+{
+	int keyCount = (int)names.size();
+	int lookupCount = keyCount * roundCount;
+	TMap map;
+	MapBenchResult results[5];
+
+	// insert, fresh map every round so the table grows like the first frame
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int round = 0; round < roundCount; ++round)
+	{
+		TMap insertMap;
+		for (int i = 0; i < keyCount; ++i)
+			insertMap.emplace(names[i], (double)i);
+		results[0].checkSum += (double)insertMap.size();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	results[0].seconds = std::chrono::duration<double>(end - start).count();
+
+	for (int i = 0; i < keyCount; ++i)
+		map.emplace(names[i], (double)i);
+
+	results[1] = RunMapLookup(map, lookupCount, [&](TMap& map, int i) { return map.find(names[i % keyCount]); });
+	// const char* makes REMap build a std::string for every lookup
+	results[2] = RunMapLookup(map, lookupCount, [&](TMap& map, int i) { return map.find(names[i % keyCount].c_str()); });
+	results[3] = RunMapLookup(map, lookupCount, [&](TMap& map, int i) { return map.find(missingNames[i % keyCount]); });
+
+	// what ~ScopedProfileTimerCPU does every scope
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < lookupCount; ++i)
+		map[names[i % keyCount].c_str()] += 1.0;
+	end = std::chrono::high_resolution_clock::now();
+	results[4].seconds = std::chrono::duration<double>(end - start).count();
+	for (auto it = map.begin(); it != map.end(); ++it)
+		results[4].checkSum += it->second;
+
+	const char* operationNames[] = { "insert", "find_string", "find_cstr", "find_miss", "accumulate_cstr" };
+	bool bPassed = true;
+	for (int i = 0; i < 5; ++i)
+	{
+		bool bOpPassed = results[i].checkSum == expectedSums[i];
+		printf("%s, string, %s, %d, %f, %.1f, %d\n", mapName, operationNames[i], lookupCount, results[i].seconds, results[i].seconds * 1e9 / lookupCount, bOpPassed ? 1 : 0);
+		bPassed &= bOpPassed;
+	}
+	return bPassed;
+}
+
+template<class TMap>
+bool RunIntMapBench(const char* mapName, const REArray<uint64_t>& keys, int roundCount, const double* expectedSums)
+{
+	int keyCount = (int)keys.size();
+	int lookupCount = keyCount * roundCount;
+	TMap map;
+	MapBenchResult results[2];
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int round = 0; round < roundCount; ++round)
+	{
+		TMap insertMap;
+		for (int i = 0; i < keyCount; ++i)
+			insertMap.emplace(keys[i], (double)i);
+		results[0].checkSum += (double)insertMap.size();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	results[0].seconds = std::chrono::duration<double>(end - start).count();
+
+	for (int i = 0; i < keyCount; ++i)
+		map.emplace(keys[i], (double)i);
+	results[1] = RunMapLookup(map, lookupCount, [&](TMap& map, int i) { return map.find(keys[(i * 7) % keyCount]); });
+
+	const char* operationNames[] = { "insert", "find" };
+	bool bPassed = true;
+	for (int i = 0; i < 2; ++i)
+	{
+		bool bOpPassed = results[i].checkSum == expectedSums[i];
+		printf("%s, uint64, %s, %d, %f, %.1f, %d\n", mapName, operationNames[i], lookupCount, results[i].seconds, results[i].seconds * 1e9 / lookupCount, bOpPassed ? 1 : 0);
+		bPassed &= bOpPassed;
+	}
+	return bPassed;
+}
+
+// random operations on a small key range, lots of erases so tombstones and same size rehashes happen
+static bool RunFlatMapFuzz(int opCount)
+{
+	std::mt19937 random(1234);
+	REMap<uint64_t, int> referenceMap;
+	REFlatMap<uint64_t, int> flatMap;
+	RESet<std::string> referenceSet;
+	REFlatSet<std::string> flatSet;
+	char name[32];
+
+	for (int i = 0; i < opCount; ++i)
+	{
+		uint64_t key = random() % 2048;
+		int op = random() % 4;
+		if (op == 0 || op == 1)
+		{
+			auto referencePair = referenceMap.emplace(key, i);
+			auto flatPair = flatMap.emplace(key, i);
+			if (referencePair.second != flatPair.second || referencePair.first->second != flatPair.first->second)
+				return false;
+			snprintf(name, sizeof(name), "name%d", (int)key);
+			if (referenceSet.insert(name).second != flatSet.insert((const char*)name).second)
+				return false;
+		}
+		else if (op == 2)
+		{
+			if (referenceMap.erase(key) != flatMap.erase(key))
+				return false;
+			snprintf(name, sizeof(name), "name%d", (int)key);
+			if (referenceSet.erase(name) != flatSet.erase((const char*)name))
+				return false;
+		}
+		else
+		{
+			auto referenceIt = referenceMap.find(key);
+			auto flatIt = flatMap.find(key);
+			if ((referenceIt == referenceMap.end()) != (flatIt == flatMap.end()))
+				return false;
+			if (referenceIt != referenceMap.end() && referenceIt->second != flatIt->second)
+				return false;
+		}
+		if (referenceMap.size() != flatMap.size() || referenceSet.size() != flatSet.size())
+			return false;
+		// sometimes start over, clear keeps the memory
+		if (random() % 50000 == 0)
+		{
+			referenceMap.clear();
+			flatMap.clear();
+		}
+	}
+
+	// iteration sees every element once, copies are equal
+	REFlatMap<uint64_t, int> flatMapCopy = flatMap;
+	size_t iteratedCount = 0;
+	for (auto it = flatMapCopy.begin(); it != flatMapCopy.end(); ++it)
+	{
+		auto referenceIt = referenceMap.find(it->first);
+		if (referenceIt == referenceMap.end() || referenceIt->second != it->second)
+			return false;
+		++iteratedCount;
+	}
+	for (const std::string& setName : flatSet)
+	{
+		if (!referenceSet.count(setName))
+			return false;
+	}
+	return iteratedCount == referenceMap.size();
+}
+
+bool RunMapBench(int keyCount)
+{
+	const int roundCount = 1024;
+
+	REArray<std::string> names;
+	REArray<std::string> missingNames;
+	MakeProfilerNames(keyCount, names);
+	for (int i = 0; i < keyCount; ++i)
+		missingNames.push_back(names[i] + "/Missing");
+
+	double keySum = (double)keyCount * (keyCount - 1) / 2;
+	const double stringSums[] = { (double)keyCount * roundCount, keySum * roundCount, keySum * roundCount, 0, keySum + (double)keyCount * roundCount };
+
+	REArray<uint64_t> keys;
+	std::mt19937_64 random(42);
+	RESet<uint64_t> usedKeys;
+	while ((int)keys.size() < keyCount)
+	{
+		uint64_t key = random();
+		if (usedKeys.insert(key).second)
+			keys.push_back(key);
+	}
+	const double intSums[] = { (double)keyCount * roundCount, keySum * roundCount };
+
+	printf("map, key, operation, count, seconds, ns/op, passed\n");
+	bool bPassed = true;
+	bPassed &= RunStringMapBench<REMap<std::string, double>>("REMap", names, missingNames, roundCount, stringSums);
+	bPassed &= RunStringMapBench<REFlatMap<std::string, double>>("REFlatMap", names, missingNames, roundCount, stringSums);
+	bPassed &= RunIntMapBench<REMap<uint64_t, double>>("REMap", keys, roundCount, intSums);
+	bPassed &= RunIntMapBench<REFlatMap<uint64_t, double>>("REFlatMap", keys, roundCount, intSums);
+
+	bool bFuzzPassed = RunFlatMapFuzz(1000 * 1000);
+	printf("REFlatMap, uint64, fuzz, %d, 0, 0, %d\n", 1000 * 1000, bFuzzPassed ? 1 : 0);
+	return bPassed && bFuzzPassed;
+}
\ No newline at end of file
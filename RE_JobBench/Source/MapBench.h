@@ -0,0 +1,7 @@
+#pragma once
+
+// hash map benchmark, REMap/RESet (std::unordered_map) against REFlatMap/REFlatSet
+// string keys shaped like profiler names, looked up by std::string and by const char* (the profiler path), and integer keys
+// also runs random insert/erase/find against REMap and checks both give the same answers
+// returns false if a flat container disagreed with REMap
+extern bool RunMapBench(int keyCount);
\ No newline at end of file
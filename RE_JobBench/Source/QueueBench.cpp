@@ -0,0 +1,210 @@
+#include "stdio.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "Containers/Containers.h"
+#include "JobSystem/Locks.h"
+#include "Engine/spsc.h"
+#include "Engine/mpmc.h"
+#include "QueueBench.h"
+
+// every queue behind the same interface, push and pop as many as they can, return how many
+class SPSCBenchQueue
+{
+public:
+	static const bool bMultiProducer = false;
+
+	size_t Push(const uint64_t* values, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+			queue.enqueue(values[i]);
+		return count;
+	}
+
+	size_t Pop(uint64_t* values, size_t maxCount)
+	{
+		size_t count = 0;
+		while (count < maxCount && queue.dequeue(values[count]))
+			++count;
+		return count;
+	}
+
+protected:
+	spsc_queue<uint64_t> queue;
+};
+
+class MPMCBenchQueue
+{
+public:
+	static const bool bMultiProducer = true;
+
+	MPMCBenchQueue() : queue(4096) {}
+
+	size_t Push(const uint64_t* values, size_t count)
+	{
+		if (count == 1)
+			return queue.enqueue(values[0]) ? 1 : 0;
+		return queue.enqueue_bulk(values, count);
+	}
+
+	size_t Pop(uint64_t* values, size_t maxCount)
+	{
+		if (maxCount == 1)
+			return queue.dequeue(values[0]) ? 1 : 0;
+		return queue.dequeue_bulk(values, maxCount);
+	}
+
+protected:
+	mpmc_bounded_queue<uint64_t> queue;
+};
+
+class LockedBenchQueue
+{
+public:
+	static const bool bMultiProducer = true;
+
+	size_t Push(const uint64_t* values, size_t count)
+	{
+		SCOPED_READ_WRITE_REF(queue, queueRef)
+		for (size_t i = 0; i < count; ++i)
+			queueRef.push(values[i]);
+		return count;
+	}
+
+	size_t Pop(uint64_t* values, size_t maxCount)
+	{
+		SCOPED_READ_WRITE_REF(queue, queueRef)
+		size_t count = 0;
+		while (count < maxCount && !queueRef.empty())
+		{
+			values[count++] = queueRef.front();
+			queueRef.pop();
+		}
+		return count;
+	}
+
+protected:
+	ThreadProtected<REQueue<uint64_t>, SpinLock> queue;
+};
+
+struct QueueBenchCase
+{
+	const char* name;
+	int producerCount;
+	int consumerCount;
+	int batchSize;
+};
+
+template<class TQueue>
+bool RunQueueBenchCase(const QueueBenchCase& benchCase, int itemCount)
+{
+	TQueue* queue = new TQueue();
+	int itemsPerProducer = itemCount / benchCase.producerCount;
+	int64_t totalItemCount = (int64_t)itemsPerProducer * benchCase.producerCount;
+	std::atomic<int64_t> poppedCount(0);
+	std::atomic<uint64_t> poppedSum(0);
+
+	REArray<std::thread*> threads;
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int producerIdx = 0; producerIdx < benchCase.producerCount; ++producerIdx)
+	{
+		threads.push_back(new std::thread([=]()
+		{
+			uint64_t values[64];
+			int pushedCount = 0;
+			while (pushedCount < itemsPerProducer)
+			{
+				int count = std::min(benchCase.batchSize, itemsPerProducer - pushedCount);
+				for (int i = 0; i < count; ++i)
+					values[i] = (uint64_t)(pushedCount + i + 1);
+				// full, back off until a consumer made room (yields eventually, fewer cores than threads is fine)
+				size_t offset = 0;
+				LockBackoff backoff;
+				while (offset < (size_t)count)
+				{
+					size_t pushed = queue->Push(values + offset, count - offset);
+					if (pushed == 0)
+						backoff.Pause();
+					offset += pushed;
+				}
+				pushedCount += count;
+			}
+		}));
+	}
+
+	for (int consumerIdx = 0; consumerIdx < benchCase.consumerCount; ++consumerIdx)
+	{
+		threads.push_back(new std::thread([=, &poppedCount, &poppedSum]()
+		{
+			uint64_t values[64];
+			uint64_t sum = 0;
+			LockBackoff backoff;
+			while (poppedCount.load(std::memory_order_relaxed) < totalItemCount)
+			{
+				size_t popped = queue->Pop(values, benchCase.batchSize);
+				if (popped == 0)
+				{
+					backoff.Pause();
+					continue;
+				}
+				backoff = LockBackoff();
+				for (size_t i = 0; i < popped; ++i)
+					sum += values[i];
+				poppedCount.fetch_add(popped, std::memory_order_relaxed);
+			}
+			poppedSum.fetch_add(sum, std::memory_order_relaxed);
+		}));
+	}
+
+	for (int i = 0; i < (int)threads.size(); ++i)
+	{
+		threads[i]->join();
+		delete threads[i];
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	delete queue;
+
+	uint64_t expectedSum = (uint64_t)itemsPerProducer * (itemsPerProducer + 1) / 2 * benchCase.producerCount;
+	bool bPassed = (poppedCount == totalItemCount && poppedSum == expectedSum);
+	printf("%s, %d, %d, %d, %lld, %f, %.0f, %d\n", benchCase.name, benchCase.producerCount, benchCase.consumerCount, benchCase.batchSize,
+		(long long)totalItemCount, seconds, totalItemCount / seconds, bPassed ? 1 : 0);
+	return bPassed;
+}
+
+bool RunQueueBench(int itemCount)
+{
+	const QueueBenchCase spscCases[] =
+	{
+		{ "spsc_queue", 1, 1, 1 },
+		{ "spsc_queue", 1, 1, 32 },
+	};
+	const QueueBenchCase mpmcCases[] =
+	{
+		{ "mpmc_bounded_queue", 1, 1, 1 },
+		{ "mpmc_bounded_queue", 1, 1, 32 },
+		{ "mpmc_bounded_queue", 2, 2, 1 },
+		{ "mpmc_bounded_queue", 2, 2, 32 },
+		{ "mpmc_bounded_queue", 4, 4, 1 },
+		{ "mpmc_bounded_queue", 4, 4, 32 },
+	};
+	const QueueBenchCase lockedCases[] =
+	{
+		{ "spin_locked_queue", 1, 1, 1 },
+		{ "spin_locked_queue", 4, 4, 1 },
+		{ "spin_locked_queue", 4, 4, 32 },
+	};
+
+	printf("queue, producers, consumers, batch, items, seconds, items/sec, passed\n");
+	bool bPassed = true;
+	for (int i = 0; i < (int)(sizeof(spscCases) / sizeof(spscCases[0])); ++i)
+		bPassed &= RunQueueBenchCase<SPSCBenchQueue>(spscCases[i], itemCount);
+	for (int i = 0; i < (int)(sizeof(mpmcCases) / sizeof(mpmcCases[0])); ++i)
+		bPassed &= RunQueueBenchCase<MPMCBenchQueue>(mpmcCases[i], itemCount);
+	for (int i = 0; i < (int)(sizeof(lockedCases) / sizeof(lockedCases[0])); ++i)
+		bPassed &= RunQueueBenchCase<LockedBenchQueue>(lockedCases[i], itemCount);
+	return bPassed;
+}
\ No newline at end of file
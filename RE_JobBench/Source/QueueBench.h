@@ -0,0 +1,6 @@
+#pragma once
+
+// queue throughput benchmark, spsc_queue (the file watcher queue) against mpmc_bounded_queue and a spin locked std::queue
+// every case moves the same number of items from producer threads to consumer threads, checks nothing was lost
+// returns false if a case lost or duplicated items
+extern bool RunQueueBench(int itemCount);
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <chrono>
+#include <new>
+
+#include "JobSystem/JobSystem.h"
+#include "JobSystem/Fiber.h"
+#include "JobBenchSuite.h"
+#include "QueueBench.h"
+#include "MapBench.h"
+
+// job system scaling benchmark
+// runs the same amount of tiny jobs with different worker counts, prints jobs/sec for each
+// "switch" argument runs the fiber context switch benchmark instead, build with different FIBER_BACKEND to compare
+// "alloc" argument checks inline jobs (and their scratch arrays) don't allocate once the job system is warm, exits with failure if they do
+// "suite [csv|json] [workers] [file]" runs the scheduler benchmark/stress suite (JobBenchSuite.cpp), exits with failure if a test lost jobs
+// "queue [items]" runs the queue throughput benchmark (QueueBench.cpp), exits with failure if a queue lost items
+// "map [keys]" runs the hash map benchmark (MapBench.cpp), exits with failure if REFlatMap disagreed with REMap
+// only needs a C++ compiler and threads, on Linux:
+// g++ -std=c++17 -O2 -I Source RE_JobBench/Source/*.cpp Source/JobSystem/JobSystem.cpp Source/JobSystem/JobTrace.cpp Source/JobSystem/Fiber.cpp -pthread -o RE_JobBench
+
+// every global operator new is counted, container allocations go through it too
+std::atomic<int64_t> gAllocCount(0);
+
+void* operator new(size_t size)
+{
+	gAllocCount.fetch_add(1, std::memory_order_relaxed);
+	void* ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+// the compiler calls this one for complete objects, has to match ours
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+struct ScalingBenchData
+{
+	int jobCount = 0;
+	int batchSize = 0;
+	double seconds = 0;
+	// averaged over workers
+	double idleRatio = 0;
+	double wakeLatencyUs = 0;
+};
+
+// roughly the cost of LightMoveData::UpdateOneLight with a small loop count
+JOB_ENTRY_POINT(TinyJob)
+{
+	volatile float value = 1.f;
+	for (int i = 0; i < 64; ++i)
+	{
+		value = value * 1.0001f + 0.5f;
+	}
+}
+
+JOB_ENTRY_POINT(ScalingBenchMain)
+{
+	ScalingBenchData* benchData = (ScalingBenchData*)customDataPtr;
+
+	REArray<JobDescriptor> jobDescs(benchData->batchSize, JobDescriptor(&TinyJob, 0, EJobPriority::Normal, gJobSmallStackSize));
+
+	// warm up, let every worker touch its queues
+	{
+		JobWaitingCounter counter;
+		RunJobs(jobDescs.data(), benchData->batchSize, &counter);
+		WaitOnCounter(&counter);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int jobIdx = 0; jobIdx < benchData->jobCount; jobIdx += benchData->batchSize)
+	{
+		JobWaitingCounter counter;
+		RunJobs(jobDescs.data(), benchData->batchSize, &counter);
+		WaitOnCounter(&counter);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	benchData->seconds = std::chrono::duration<double>(end - start).count();
+
+	REArray<JobWorkerStats> workerStats;
+	GetJobWorkerStats(workerStats);
+	int64_t wakeCount = 0;
+	int64_t totalWakeLatencyNs = 0;
+	for (int i = 0; i < (int)workerStats.size(); ++i)
+	{
+		benchData->idleRatio += (double)workerStats[i].idleTimeNs / (double)workerStats[i].runTimeNs / workerStats.size();
+		wakeCount += workerStats[i].wakeCount;
+		totalWakeLatencyNs += workerStats[i].totalWakeLatencyNs;
+	}
+	benchData->wakeLatencyUs = wakeCount ? totalWakeLatencyNs / 1000.0 / wakeCount : 0;
+
+	StopJobSystem();
+}
+
+// ping pong between the thread fiber and one job fiber
+struct SwitchBenchData
+{
+	JobFiber* threadFiber = 0;
+	JobFiber* pingPongFiber = 0;
+	int switchCount = 0;
+};
+
+void SwitchBenchFiberFunc(void* fiberDataPtr)
+{
+	SwitchBenchData* benchData = (SwitchBenchData*)fiberDataPtr;
+	while (true)
+	{
+		SwitchToJobFiber(benchData->threadFiber);
+	}
+}
+
+void RunSwitchBench(int switchCount)
+{
+	SwitchBenchData benchData;
+	benchData.threadFiber = ConvertThreadToJobFiber(&benchData);
+	benchData.pingPongFiber = CreateJobFiber(0, &SwitchBenchFiberFunc, &benchData);
+
+	// warm up, first switch touches the new stack
+	SwitchToJobFiber(benchData.pingPongFiber);
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int i = 0; i < switchCount; ++i)
+	{
+		SwitchToJobFiber(benchData.pingPongFiber);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+
+	DeleteJobFiber(benchData.pingPongFiber);
+	ConvertJobFiberToThread();
+
+	// two switches per iteration
+	printf("backend, switches, seconds, ns/switch\n");
+	printf("%s, %d, %f, %.2f\n", FIBER_BACKEND_NAME, switchCount * 2, seconds, seconds * 1e9 / (switchCount * 2.0));
+}
+
+struct AllocTestData
+{
+	int roundCount = 0;
+	int jobCount = 0;
+	int64_t allocCount = 0;
+	int64_t expectedSum = 0;
+	int64_t sum = 0;
+};
+
+void RunAllocTestRound(AllocTestData* testData, std::atomic<int64_t>& sum)
+{
+	JobWaitingCounter counter;
+	for (int i = 0; i < testData->jobCount; ++i)
+	{
+		// a few captures, like the loading jobs in Texture2D
+		int64_t value = i;
+		void* extraPtr = testData;
+		RUN_INLINE_JOB(EJobPriority::Normal, &counter, 0, {
+			// temporaries come from the fiber's scratch arena, no heap either
+			REScratchArray<int64_t> values;
+			values.push_back(value);
+			values.push_back(extraPtr ? 1 : 0);
+			sum.fetch_add(values[0] + values[1], std::memory_order_relaxed);
+		}, &sum);
+	}
+	WaitOnCounter(&counter);
+
+	for (int i = 0; i < 16; ++i)
+	{
+		int64_t value = i;
+		RUN_INLINE_RENDER_JOB({
+			sum.fetch_add(value, std::memory_order_relaxed);
+		}, &sum);
+	}
+	WaitOnCounter(&gRenderFrameSyncCounter);
+}
+
+JOB_ENTRY_POINT(AllocTestMain)
+{
+	AllocTestData* testData = (AllocTestData*)customDataPtr;
+	std::atomic<int64_t> sum(0);
+
+	// warm up, fiber pools, queues and payload blocks grow to what we need
+	for (int round = 0; round < 4; ++round)
+	{
+		RunAllocTestRound(testData, sum);
+	}
+	sum = 0;
+
+	int64_t startAllocCount = gAllocCount.load();
+	for (int round = 0; round < testData->roundCount; ++round)
+	{
+		RunAllocTestRound(testData, sum);
+	}
+	testData->allocCount = gAllocCount.load() - startAllocCount;
+	testData->sum = sum.load();
+
+	int64_t roundSum = (int64_t)testData->jobCount * (testData->jobCount - 1) / 2 + testData->jobCount + 16 * 15 / 2;
+	testData->expectedSum = roundSum * testData->roundCount;
+
+	StopJobSystem();
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && strcmp(argv[1], "switch") == 0)
+	{
+		RunSwitchBench((argc > 2) ? atoi(argv[2]) : 10 * 1000 * 1000);
+		return EXIT_SUCCESS;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "suite") == 0)
+	{
+		EJobBenchOutput output = (argc > 2 && strcmp(argv[2], "json") == 0) ? EJobBenchOutput::JSON : EJobBenchOutput::CSV;
+		int workerCount = (argc > 3) ? atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+		if (workerCount < 2)
+		{
+			fprintf(stderr, "suite needs at least 2 workers, %d requested\n", workerCount);
+			workerCount = 2;
+		}
+		fprintf(stderr, "suite: %d workers\n", workerCount);
+		FILE* file = stdout;
+		if (argc > 4)
+		{
+#if defined(_MSC_VER)
+			// fopen is an error with SDL checks on
+			if (fopen_s(&file, argv[4], "w") != 0)
+				file = 0;
+#else
+			file = fopen(argv[4], "w");
+#endif
+			if (!file)
+			{
+				fprintf(stderr, "can't open %s\n", argv[4]);
+				return EXIT_FAILURE;
+			}
+		}
+		bool bPassed = RunJobBenchSuite(output, workerCount, file);
+		if (file != stdout)
+			fclose(file);
+		return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "queue") == 0)
+	{
+		bool bPassed = RunQueueBench((argc > 2) ? atoi(argv[2]) : 4 * 1024 * 1024);
+		return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "map") == 0)
+	{
+		bool bPassed = RunMapBench((argc > 2) ? atoi(argv[2]) : 256);
+		return bPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (argc > 1 && strcmp(argv[1], "alloc") == 0)
+	{
+		AllocTestData testData;
+		testData.roundCount = (argc > 2) ? atoi(argv[2]) : 100;
+		testData.jobCount = 1024;
+
+		JobDescriptor startJobDesc(&AllocTestMain, &testData);
+		// always resume on the same worker after waiting, so the jobs go to one deque,
+		// another worker's deque would grow the first time it holds a whole round
+		startJobDesc.fixedProcessor = 0;
+		RunJobSystem(&startJobDesc, 4);
+
+		printf("jobs, allocations, allocations/job\n");
+		int64_t jobCount = (int64_t)testData.roundCount * (testData.jobCount + 16);
+		printf("%lld, %lld, %f\n", (long long)jobCount, (long long)testData.allocCount, (double)testData.allocCount / jobCount);
+		if (testData.sum != testData.expectedSum)
+		{
+			printf("FAILED: jobs didn't all run (%lld, expected %lld)\n", (long long)testData.sum, (long long)testData.expectedSum);
+			return EXIT_FAILURE;
+		}
+		if (testData.allocCount != 0)
+		{
+			printf("FAILED: inline jobs allocated\n");
+			return EXIT_FAILURE;
+		}
+		printf("PASSED\n");
+		return EXIT_SUCCESS;
+	}
+
+	const int workerCounts[] = { 2, 4, 8, 16, 32, 64 };
+	const int jobCount = (argc > 1) ? atoi(argv[1]) : 1024 * 1024;
+	const int batchSize = 1024;
+
+	printf("workers, jobs, seconds, jobs/sec, idle %%, avg wake us\n");
+
+	for (int i = 0; i < (int)(sizeof(workerCounts) / sizeof(workerCounts[0])); ++i)
+	{
+		ScalingBenchData benchData;
+		benchData.jobCount = jobCount;
+		benchData.batchSize = batchSize;
+
+		JobDescriptor startJobDesc(&ScalingBenchMain, &benchData);
+		RunJobSystem(&startJobDesc, workerCounts[i]);
+
+		printf("%d, %d, %f, %.0f, %.1f, %.1f\n", workerCounts[i], jobCount, benchData.seconds, (double)jobCount / benchData.seconds,
+			benchData.idleRatio * 100.0, benchData.wakeLatencyUs);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "Math/REMath.h"
+#include "Math/MathCulling.h"
+#include "Engine/Bounds.h"
+#include "Containers/Containers.h"
+
+// frustum culling of mesh components, components as objects (AoS) against the engine's gMeshCullData layout (SoA)
+
+// same fields and size as MeshComponent, culling only reads OBB and writes the visibility
+struct CullBenchComponent
+{
+	void* vtable;
+	Vector4_3 position;
+	Vector4_3 rotation;
+	Vector4_3 scale;
+	Matrix4 prevModelMat;
+	Matrix4 modelMat;
+	BoxBounds bounds;
+	OrientedBoxBounds OBB;
+	bool bRenderVisible;
+	bool bRenderTransformDirty;
+	bool bHasCachedRenderTransform;
+	RESmallArray<void*, 2> meshList;
+};
+
+enum ECullBenchField
+{
+	CullBenchOBB,
+	CullBenchModelMat,
+	CullBenchBounds,
+	CullBenchRenderVisible,
+};
+
+typedef RESoAArray<EMemoryTag::Default, OrientedBoxBounds, Matrix4, BoxBounds, char> CullBenchSoA;
+
+__declspec(noinline)
+int CullAoS(CullBenchComponent* components, int count, Plane* planes)
+{
+	int visibleCount = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		components[i].bRenderVisible = IsOBBIntersectFrustum(components[i].OBB.permutedAxisCenter, components[i].OBB.extent, planes, 6);
+		visibleCount += components[i].bRenderVisible;
+	}
+	return visibleCount;
+}
+
+__declspec(noinline)
+int CullSoA(CullBenchSoA& soa, Plane* planes)
+{
+	int visibleCount = 0;
+	const OrientedBoxBounds* OBBs = soa.Field<CullBenchOBB>();
+	char* renderVisible = soa.Field<CullBenchRenderVisible>();
+	for (int i = 0, ni = soa.size(); i < ni; ++i)
+	{
+		renderVisible[i] = IsOBBIntersectFrustum(OBBs[i].permutedAxisCenter, OBBs[i].extent, planes, 6);
+		visibleCount += renderVisible[i];
+	}
+	return visibleCount;
+}
+
+__declspec(noinline)
+int CullSoABatch(CullBenchSoA& soa, Plane* planes, REArray<uint32_t>& visibleMask)
+{
+	const OrientedBoxBounds* OBBs = soa.Field<CullBenchOBB>();
+	char* renderVisible = soa.Field<CullBenchRenderVisible>();
+	int count = soa.size();
+	visibleMask.resize(GetCullingMaskSize(count));
+	OBBIntersectFrustumBatch(OBBs[0].permutedAxisCenter, &OBBs[0].extent, sizeof(OrientedBoxBounds), count, planes, 6, visibleMask.data());
+	int visibleCount = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		renderVisible[i] = IsCullingMaskVisible(visibleMask.data(), i);
+		visibleCount += renderVisible[i];
+	}
+	return visibleCount;
+}
+
+// every batch path against IsOBBIntersectFrustum and IsSphereIntersectFrustum, the results have to be the same bit for bit
+// counts that aren't a multiple of the batch test the tails, thin and flat boxes land right on the planes
+// returns the number of mismatches
+int CullingBatchTest(int objectCount = 1021, int frustumCount = 64)
+{
+	ECullingISA supportedISA = GetSupportedCullingISA();
+	printf("culling batch test, %s supported\n", GetCullingISAName(supportedISA));
+
+	REArray<OrientedBoxBounds> OBBs(objectCount);
+	REArray<Vector4> spheres(objectCount);
+	REArray<uint32_t> visibleMask;
+	int failedCount = 0;
+
+	for (int frustumIdx = 0; frustumIdx < frustumCount; ++frustumIdx)
+	{
+		Plane planes[6];
+		float halfWidth = RandRangeF(0.1f, 4.f);
+		GetFrustumPlanes(RandTransformMatrix(-100.f, 100.f, 1.f, 1.f), halfWidth, halfWidth * RandRangeF(0.5f, 1.f), 0.1f, RandRangeF(50.f, 500.f), planes);
+
+		for (int i = 0; i < objectCount; ++i)
+		{
+			BoxBounds bounds;
+			Vector4_3 extent(RandRangeF(0.f, 20.f), RandRangeF(0.f, 20.f), (i % 7) == 0 ? 0.f : RandRangeF(0.f, 20.f));
+			bounds.SetCenterAndExtent(Vector4_3::Zero(), extent);
+			Matrix4 modelMat = RandTransformMatrix(-300.f, 300.f, 0.1f, 10.f);
+			Vector4_3 scale(modelMat.mLine[0].Size3(), modelMat.mLine[1].Size3(), modelMat.mLine[2].Size3());
+			OBBs[i].SetBounds(bounds, modelMat, scale);
+			spheres[i] = Vector4(RandRangeF(-300.f, 300.f), RandRangeF(-300.f, 300.f), RandRangeF(-300.f, 300.f), RandRangeF(0.f, 50.f));
+		}
+
+		// every other sphere just touches a plane from outside, distance == -radius exactly with the scalar math
+		// a kernel with fused multiply adds rounds differently and culls some of them
+		for (int i = 1; i < objectCount; i += 2)
+		{
+			const Plane& plane = planes[i % 6];
+			Vector4 point = spheres[i];
+			for (int tryIdx = 0; tryIdx < 64 && !IsSphereIntersectFrustum(point, 0.f, planes, 6); ++tryIdx)
+				point = Vector4(RandRangeF(-300.f, 300.f), RandRangeF(-300.f, 300.f), RandRangeF(-300.f, 300.f), 0.f);
+			float offset = (PointToPlaneDist(point, plane) + RandRangeF(0.01f, 10.f)) / plane.Dot3(plane);
+			Vector4 center = point - plane * offset;
+			spheres[i] = Vector4(center.x, center.y, center.z, -PointToPlaneDist(center, plane));
+		}
+
+		// sub ranges starting anywhere so the batches don't always start on the same objects
+		int beginIndex = frustumIdx % 17;
+		int count = objectCount - beginIndex - frustumIdx % 31;
+		visibleMask.resize(GetCullingMaskSize(count));
+
+		for (int isa = 0; isa <= (int)supportedISA; ++isa)
+		{
+			SetCullingISA((ECullingISA)isa);
+
+			OBBIntersectFrustumBatch(OBBs[beginIndex].permutedAxisCenter, &OBBs[beginIndex].extent, sizeof(OrientedBoxBounds), count, planes, 6, visibleMask.data());
+			for (int i = 0; i < count; ++i)
+			{
+				const OrientedBoxBounds& OBB = OBBs[beginIndex + i];
+				if (IsCullingMaskVisible(visibleMask.data(), i) != IsOBBIntersectFrustum(OBB.permutedAxisCenter, OBB.extent, planes, 6))
+				{
+					printf("FAILED: %s OBB %d of frustum %d\n", GetCullingISAName((ECullingISA)isa), beginIndex + i, frustumIdx);
+					++failedCount;
+				}
+			}
+
+			SphereIntersectFrustumBatch(&spheres[beginIndex], sizeof(Vector4), count, planes, 6, visibleMask.data());
+			for (int i = 0; i < count; ++i)
+			{
+				const Vector4& sphere = spheres[beginIndex + i];
+				if (IsCullingMaskVisible(visibleMask.data(), i) != IsSphereIntersectFrustum(sphere, sphere.w, planes, 6))
+				{
+					printf("FAILED: %s sphere %d of frustum %d\n", GetCullingISAName((ECullingISA)isa), beginIndex + i, frustumIdx);
+					++failedCount;
+				}
+			}
+		}
+	}
+	SetCullingISA(supportedISA);
+
+	printf("culling batch test %s, %d mismatches\n", failedCount ? "FAILED" : "passed", failedCount);
+	return failedCount;
+}
+
+// prints ns per component for both layouts, the scene is bigger than the caches so every round streams from memory
+void CullingBench(int componentCount = 100000, int roundCount = 20)
+{
+	LARGE_INTEGER performFreq;
+	QueryPerformanceFrequency(&performFreq);
+	double InvPerformanceFreq = (double)1.0 / (double)(performFreq.QuadPart);
+
+	CullBenchComponent* components = (CullBenchComponent*)_aligned_malloc(sizeof(CullBenchComponent) * componentCount, 16);
+	CullBenchSoA soa;
+	soa.resize(componentCount);
+
+	BoxBounds unitBounds;
+	unitBounds.SetCenterAndExtent(Vector4_3::Zero(), Vector4_3(1));
+	for (int i = 0; i < componentCount; ++i)
+	{
+		CullBenchComponent* comp = new (&components[i]) CullBenchComponent();
+		comp->scale = Vector4_3(1);
+		comp->modelMat = RandTransformMatrix(-500.f, 500.f, 1.f, 1.f);
+		comp->bounds = unitBounds;
+		comp->OBB.SetBounds(comp->bounds, comp->modelMat, comp->scale);
+
+		soa.Get<CullBenchOBB>(i) = comp->OBB;
+		soa.Get<CullBenchModelMat>(i) = comp->modelMat;
+		soa.Get<CullBenchBounds>(i) = comp->bounds;
+	}
+
+	// 90 degrees fov, looking down -z from the origin
+	Plane planes[6];
+	GetFrustumPlanes(Matrix4::Identity(), 1.f, 1.f, 0.1f, 500.f, planes);
+
+	LARGE_INTEGER pc0, pc1, pc2, pc3;
+	int visibleAoS = 0, visibleSoA = 0;
+
+	QueryPerformanceCounter(&pc0);
+	for (int round = 0; round < roundCount; ++round)
+		visibleAoS = CullAoS(components, componentCount, planes);
+	QueryPerformanceCounter(&pc1);
+	for (int round = 0; round < roundCount; ++round)
+		visibleSoA = CullSoA(soa, planes);
+	QueryPerformanceCounter(&pc2);
+
+	double pt0 = (double)(pc1.QuadPart - pc0.QuadPart) * InvPerformanceFreq;
+	double pt1 = (double)(pc2.QuadPart - pc1.QuadPart) * InvPerformanceFreq;
+
+	printf("culling %d components (%d bytes each), %d visible\n", componentCount, (int)sizeof(CullBenchComponent), visibleSoA);
+	printf("AoS \t= %f s \t %.2f ns/component\n", pt0, pt0 * 1e9 / ((double)componentCount * roundCount));
+	printf("SoA \t= %f s \t %.2f ns/component\n", pt1, pt1 * 1e9 / ((double)componentCount * roundCount));
+	if (visibleAoS != visibleSoA)
+		printf("FAILED: AoS found %d visible, SoA %d\n", visibleAoS, visibleSoA);
+
+	// batch kernels on the same SoA, one line per instruction set
+	ECullingISA supportedISA = GetSupportedCullingISA();
+	REArray<uint32_t> visibleMask;
+	for (int isa = 0; isa <= (int)supportedISA; ++isa)
+	{
+		SetCullingISA((ECullingISA)isa);
+		int visibleBatch = 0;
+		QueryPerformanceCounter(&pc2);
+		for (int round = 0; round < roundCount; ++round)
+			visibleBatch = CullSoABatch(soa, planes, visibleMask);
+		QueryPerformanceCounter(&pc3);
+		double pt2 = (double)(pc3.QuadPart - pc2.QuadPart) * InvPerformanceFreq;
+		printf("SoA %s \t= %f s \t %.2f ns/component\n", GetCullingISAName((ECullingISA)isa), pt2, pt2 * 1e9 / ((double)componentCount * roundCount));
+		if (visibleBatch != visibleSoA)
+			printf("FAILED: SoA found %d visible, %s batch %d\n", visibleSoA, GetCullingISAName((ECullingISA)isa), visibleBatch);
+	}
+	SetCullingISA(supportedISA);
+
+	for (int i = 0; i < componentCount; ++i)
+		components[i].~CullBenchComponent();
+	_aligned_free(components);
+}
\ No newline at end of file
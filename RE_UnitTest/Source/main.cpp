@@ -6,6 +6,7 @@
 #include "../../3rdparty/glm/glm/glm.hpp"
 
 #include "UnitTest.h"
+#include "UT_Culling.h"
 
 #include "Windows.h"
 
@@ -414,6 +415,9 @@ int main(int argc, char **argv)
 	//Vec128 mantisa = VecLog2(test);
 	//PrintValue(Vector4(mantisa));
 
+	CullingBatchTest();
+	CullingBench();
+
 	Matrix4 mat = MakeMatrixFromForward(Vector4(1.f, 0.f, 0.f));
 	PrintValue(mat);
 
@@ -9,6 +9,9 @@
 #include <queue>
 
 #include "Memory/Memory.h"
+#include "Containers/FlatMap.h"
+#include "Containers/SmallArray.h"
+#include "Containers/SoAArray.h"
 
 /* we don't use this, leave as a reference
 #define REPODArray std::vector
@@ -33,20 +36,21 @@ using REArray = typename REArrayType<T, Alignment>::type;
 */
 
 // template alias
-template<class T, int Alignment = 0>
-using REArray = std::vector<T, REAllocator<T, Alignment>>;
+// Tag is who gets the memory in the memory stats (GetMemoryTagStats)
+template<class T, int Alignment = 0, EMemoryTag Tag = EMemoryTag::Default>
+using REArray = std::vector<T, REAllocator<T, Alignment, Tag>>;
 
-template<class TKey, class TValue, int Alignment = 0>
-using REMap = std::unordered_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>, REAllocator<std::pair<const TKey, TValue>, Alignment>>;
+template<class TKey, class TValue, int Alignment = 0, EMemoryTag Tag = EMemoryTag::Default>
+using REMap = std::unordered_map<TKey, TValue, std::hash<TKey>, std::equal_to<TKey>, REAllocator<std::pair<const TKey, TValue>, Alignment, Tag>>;
 
-template<class TKey, class TValue, int Alignment = 0>
-using RESortedMap = std::map<TKey, TValue, std::less<TKey>, REAllocator<std::pair<const TKey, TValue>, Alignment>>;
+template<class TKey, class TValue, int Alignment = 0, EMemoryTag Tag = EMemoryTag::Default>
+using RESortedMap = std::map<TKey, TValue, std::less<TKey>, REAllocator<std::pair<const TKey, TValue>, Alignment, Tag>>;
 
-template<class T, int Alignment = 0>
-using RESet = std::unordered_set<T, std::hash<T>, std::equal_to<T>, REAllocator<T, Alignment>>;
+template<class T, int Alignment = 0, EMemoryTag Tag = EMemoryTag::Default>
+using RESet = std::unordered_set<T, std::hash<T>, std::equal_to<T>, REAllocator<T, Alignment, Tag>>;
 
-template<class T, int Alignment = 0>
-using RESortedSet = std::set<T, std::less<T>, REAllocator<T, Alignment>>;
+template<class T, int Alignment = 0, EMemoryTag Tag = EMemoryTag::Default>
+using RESortedSet = std::set<T, std::less<T>, REAllocator<T, Alignment, Tag>>;
 
-template<class T, int Alignment = 0>
-using REQueue = std::queue<T, std::deque<T, REAllocator<T, Alignment>>>;
\ No newline at end of file
+template<class T, int Alignment = 0, EMemoryTag Tag = EMemoryTag::Default>
+using REQueue = std::queue<T, std::deque<T, REAllocator<T, Alignment, Tag>>>;
\ No newline at end of file
@@ -0,0 +1,651 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <string>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLAT_MAP_SSE2 1
+#include <emmintrin.h>
+#else
+#define FLAT_MAP_SSE2 0
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>	/* for _BitScanForward */
+#endif
+
+#include "Memory/Memory.h"
+
+// open addressing hash table, SwissTable layout (https://abseil.io/about/design/swisstables)
+// one control byte per slot: empty, deleted or the low 7 bits of the hash when full
+// slots are probed 16 at a time, one SSE2 compare finds every candidate of a group, keys are only compared on a 7 bit match
+// elements live in one flat array, pointers and iterators are invalidated when an insert grows the table (unlike REMap)
+
+inline uint64_t LoadBytes8(const unsigned char* bytes)
+{
+	uint64_t word;
+	memcpy(&word, bytes, 8);
+	return word;
+}
+
+inline uint64_t LoadBytes4(const unsigned char* bytes)
+{
+	uint32_t word;
+	memcpy(&word, bytes, 4);
+	return word;
+}
+
+// 64 bit hash of a byte range, std::string and const char* hash the same
+// two independent multiply chains over 16 bytes per step, profiler names are long
+// the tail is read with overlapping loads, copying it to a buffer first stalls the load on the copy
+inline uint64_t HashBytes(const void* data, size_t size)
+{
+	const uint64_t mul0 = 0x9E3779B97F4A7C15ull;
+	const uint64_t mul1 = 0xC2B2AE3D27D4EB4Full;
+	const unsigned char* bytes = (const unsigned char*)data;
+	const unsigned char* bytesEnd = bytes + size;
+	uint64_t hash0 = 0xCBF29CE484222325ull ^ size;
+	uint64_t hash1 = 0x165667B19E3779F9ull;
+	while (bytesEnd - bytes > 16)
+	{
+		hash0 = (hash0 ^ LoadBytes8(bytes)) * mul0;
+		hash1 = (hash1 ^ LoadBytes8(bytes + 8)) * mul1;
+		hash0 ^= hash0 >> 29;
+		hash1 ^= hash1 >> 31;
+		bytes += 16;
+	}
+	// last 1 to 16 bytes
+	size_t tailSize = bytesEnd - bytes;
+	uint64_t word0 = 0;
+	uint64_t word1 = 0;
+	if (size >= 16)
+	{
+		word0 = LoadBytes8(bytesEnd - 16);
+		word1 = LoadBytes8(bytesEnd - 8);
+	}
+	else if (size >= 8)
+	{
+		word0 = LoadBytes8(bytes);
+		word1 = LoadBytes8(bytesEnd - 8);
+	}
+	else if (size >= 4)
+	{
+		word0 = LoadBytes4(bytes) | (LoadBytes4(bytesEnd - 4) << 32);
+	}
+	else if (size > 0)
+	{
+		word0 = bytes[0] | ((uint64_t)bytes[tailSize / 2] << 8) | ((uint64_t)bytes[tailSize - 1] << 16);
+	}
+	hash0 = (hash0 ^ word0) * mul0;
+	hash1 = (hash1 ^ word1) * mul1;
+	uint64_t hash = (hash0 ^ (hash1 >> 32) ^ (hash1 << 32)) * mul0;
+	return hash ^ (hash >> 32);
+}
+
+// default hasher, std::hash except for strings
+template<class TKey>
+struct REFlatHash : std::hash<TKey> {};
+
+// transparent, find("name") doesn't build a std::string
+template<>
+struct REFlatHash<std::string>
+{
+	typedef void is_transparent;
+
+	size_t operator()(const std::string& key) const { return (size_t)HashBytes(key.data(), key.size()); }
+	size_t operator()(const char* key) const { return (size_t)HashBytes(key, strlen(key)); }
+};
+
+template<class TKey>
+struct REFlatEqual : std::equal_to<TKey> {};
+
+template<>
+struct REFlatEqual<std::string>
+{
+	typedef void is_transparent;
+
+	bool operator()(const std::string& left, const std::string& right) const { return left.size() == right.size() && memcmp(left.data(), right.data(), left.size()) == 0; }
+	bool operator()(const std::string& left, const char* right) const { return left.compare(right) == 0; }
+};
+
+// what the slot of a map and of a set hold, and where the key is
+template<class TKey, class TValue>
+struct REFlatMapPolicy
+{
+	typedef std::pair<TKey, TValue> slot_type;
+	static const TKey& GetKey(const slot_type& slot) { return slot.first; }
+};
+
+template<class TKey>
+struct REFlatSetPolicy
+{
+	typedef TKey slot_type;
+	static const TKey& GetKey(const slot_type& slot) { return slot; }
+};
+
+template<class TKey, class TPolicy, class THash, class TEqual, EMemoryTag Tag>
+class REFlatTable
+{
+public:
+	typedef typename TPolicy::slot_type value_type;
+	typedef size_t size_type;
+
+	static const int GROUP_WIDTH = 16;
+
+	template<bool bConst>
+	class Iterator
+	{
+	public:
+		typedef typename std::conditional<bConst, const value_type, value_type>::type element_type;
+
+		Iterator() : table(0), index(0) {}
+		Iterator(const REFlatTable* inTable, size_t inIndex) : table(inTable), index(inIndex) {}
+		// iterator converts to const_iterator
+		Iterator(const Iterator<false>& other) : table(other.table), index(other.index) {}
+
+		element_type& operator*() const { return table->slots[index]; }
+		element_type* operator->() const { return &table->slots[index]; }
+
+		Iterator& operator++()
+		{
+			index = table->SkipEmpty(index + 1);
+			return *this;
+		}
+
+		bool operator==(const Iterator& other) const { return index == other.index; }
+		bool operator!=(const Iterator& other) const { return index != other.index; }
+
+		const REFlatTable* table;
+		size_t index;
+	};
+
+	typedef Iterator<false> iterator;
+	typedef Iterator<true> const_iterator;
+
+	REFlatTable() {}
+
+	REFlatTable(const REFlatTable& other)
+	{
+		CopyFrom(other);
+	}
+
+	REFlatTable(REFlatTable&& other) noexcept
+	{
+		Steal(other);
+	}
+
+	~REFlatTable()
+	{
+		Release();
+	}
+
+	REFlatTable& operator=(const REFlatTable& other)
+	{
+		if (this != &other)
+		{
+			Release();
+			CopyFrom(other);
+		}
+		return *this;
+	}
+
+	REFlatTable& operator=(REFlatTable&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			Steal(other);
+		}
+		return *this;
+	}
+
+	iterator begin() { return iterator(this, SkipEmpty(0)); }
+	iterator end() { return iterator(this, capacity); }
+	const_iterator begin() const { return const_iterator(this, SkipEmpty(0)); }
+	const_iterator end() const { return const_iterator(this, capacity); }
+
+	size_t size() const { return elementCount; }
+	bool empty() const { return elementCount == 0; }
+	size_t bucket_count() const { return capacity; }
+
+	// destroys the elements, keeps the memory (like REMap)
+	void clear()
+	{
+		if (elementCount == 0 && growthLeft == GetMaxCount(capacity))
+			return;
+		DestroySlots();
+		memset(ctrl, CTRL_EMPTY, capacity);
+		elementCount = 0;
+		growthLeft = GetMaxCount(capacity);
+	}
+
+	// room for inCount elements without growing
+	void reserve(size_t inCount)
+	{
+		if (inCount > GetMaxCount(capacity) || inCount > elementCount + growthLeft)
+			Rehash(GetCapacityFor(inCount));
+	}
+
+	// any key type the hasher and comparer take (const char* for std::string keys)
+	template<class K>
+	iterator find(const K& key)
+	{
+		return iterator(this, FindIndex(key));
+	}
+
+	template<class K>
+	const_iterator find(const K& key) const
+	{
+		return const_iterator(this, FindIndex(key));
+	}
+
+	template<class K>
+	size_t count(const K& key) const
+	{
+		return FindIndex(key) != capacity ? 1 : 0;
+	}
+
+	template<class K>
+	bool contains(const K& key) const
+	{
+		return FindIndex(key) != capacity;
+	}
+
+	void erase(const_iterator it)
+	{
+		EraseIndex(it.index);
+	}
+
+	template<class K>
+	size_t erase(const K& key)
+	{
+		size_t index = FindIndex(key);
+		if (index == capacity)
+			return 0;
+		EraseIndex(index);
+		return 1;
+	}
+
+protected:
+	// full control bytes are 0..127 (h2), the others have the high bit set
+	static const int8_t CTRL_EMPTY = -128;
+	static const int8_t CTRL_DELETED = -2;
+
+	static const size_t MIN_CAPACITY = GROUP_WIDTH;
+
+	// bit i set if control byte i of the group matches
+	struct Group
+	{
+		explicit Group(const int8_t* inCtrl) : groupCtrl(inCtrl) {}
+
+#if FLAT_MAP_SSE2
+		uint32_t Match(int8_t h2) const
+		{
+			__m128i bytes = _mm_load_si128((const __m128i*)groupCtrl);
+			return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), bytes));
+		}
+
+		uint32_t MatchEmpty() const
+		{
+			return Match(CTRL_EMPTY);
+		}
+
+		// empty or deleted, the sign bit
+		uint32_t MatchEmptyOrDeleted() const
+		{
+			return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)groupCtrl));
+		}
+#else
+		uint32_t Match(int8_t h2) const
+		{
+			uint32_t mask = 0;
+			for (int i = 0; i < GROUP_WIDTH; ++i)
+				mask |= (groupCtrl[i] == h2 ? 1u : 0u) << i;
+			return mask;
+		}
+
+		uint32_t MatchEmpty() const
+		{
+			return Match(CTRL_EMPTY);
+		}
+
+		uint32_t MatchEmptyOrDeleted() const
+		{
+			uint32_t mask = 0;
+			for (int i = 0; i < GROUP_WIDTH; ++i)
+				mask |= (groupCtrl[i] < 0 ? 1u : 0u) << i;
+			return mask;
+		}
+#endif
+
+		const int8_t* groupCtrl;
+	};
+
+	static int LowestBit(uint32_t mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (int)index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	// std::hash of an integer or pointer can be the value itself, mix so h1 and h2 use every bit
+	static uint64_t MixHash(size_t hash)
+	{
+		uint64_t mixed = (uint64_t)hash * 0x9E3779B97F4A7C15ull;
+		return mixed ^ (mixed >> 32);
+	}
+
+	static size_t H1(uint64_t hash) { return (size_t)(hash >> 7); }
+	static int8_t H2(uint64_t hash) { return (int8_t)(hash & 0x7F); }
+
+	// 7/8 load factor
+	static size_t GetMaxCount(size_t inCapacity) { return inCapacity - inCapacity / 8; }
+
+	static size_t GetCapacityFor(size_t inCount)
+	{
+		size_t newCapacity = MIN_CAPACITY;
+		while (GetMaxCount(newCapacity) < inCount)
+			newCapacity *= 2;
+		return newCapacity;
+	}
+
+	// every slot past the last full one gives capacity (end)
+	size_t SkipEmpty(size_t index) const
+	{
+		while (index < capacity && ctrl[index] < 0)
+			++index;
+		return index;
+	}
+
+	// groups are probed with triangular steps, every group is visited once for a power of 2 group count
+	template<class K>
+	size_t FindIndex(const K& key) const
+	{
+		if (elementCount == 0)
+			return capacity;
+		return FindIndex(key, MixHash(hasher(key)));
+	}
+
+	template<class K>
+	size_t FindIndex(const K& key, uint64_t hash) const
+	{
+		int8_t h2 = H2(hash);
+		size_t groupMask = capacity / GROUP_WIDTH - 1;
+		size_t groupIndex = H1(hash) & groupMask;
+		for (size_t step = 1; ; ++step)
+		{
+			Group group(ctrl + groupIndex * GROUP_WIDTH);
+			for (uint32_t match = group.Match(h2); match; match &= match - 1)
+			{
+				size_t index = groupIndex * GROUP_WIDTH + LowestBit(match);
+				if (equal(TPolicy::GetKey(slots[index]), key))
+					return index;
+			}
+			// an empty byte means the key was never pushed further
+			if (group.MatchEmpty())
+				return capacity;
+			groupIndex = (groupIndex + step) & groupMask;
+		}
+	}
+
+	// first empty or deleted slot on the key's probe sequence, there is always one
+	size_t FindInsertIndex(uint64_t hash) const
+	{
+		size_t groupMask = capacity / GROUP_WIDTH - 1;
+		size_t groupIndex = H1(hash) & groupMask;
+		for (size_t step = 1; ; ++step)
+		{
+			uint32_t match = Group(ctrl + groupIndex * GROUP_WIDTH).MatchEmptyOrDeleted();
+			if (match)
+				return groupIndex * GROUP_WIDTH + LowestBit(match);
+			groupIndex = (groupIndex + step) & groupMask;
+		}
+	}
+
+	// index of the key, constructs the slot with makeSlot(void* memory) if it's not there, bool is true if it was added
+	template<class K, class TMakeSlot>
+	std::pair<size_t, bool> FindOrInsert(const K& key, const TMakeSlot& makeSlot)
+	{
+		uint64_t hash = MixHash(hasher(key));
+		if (capacity > 0)
+		{
+			size_t index = FindIndex(key, hash);
+			if (index != capacity)
+				return std::make_pair(index, false);
+		}
+
+		if (growthLeft == 0)
+		{
+			// only tombstones in the way, same size cleans them up
+			Rehash(elementCount * 2 < GetMaxCount(capacity) ? (capacity ? capacity : MIN_CAPACITY) : GetCapacityFor(elementCount + 1));
+		}
+		size_t index = FindInsertIndex(hash);
+		makeSlot((void*)&slots[index]);
+		if (ctrl[index] == CTRL_EMPTY)
+			--growthLeft;
+		ctrl[index] = H2(hash);
+		++elementCount;
+		return std::make_pair(index, true);
+	}
+
+	void EraseIndex(size_t index)
+	{
+		assert(index < capacity && ctrl[index] >= 0);
+		slots[index].~value_type();
+		--elementCount;
+		// a group with an empty byte already stops every probe, no tombstone needed
+		if (Group(ctrl + (index & ~(size_t)(GROUP_WIDTH - 1))).MatchEmpty())
+		{
+			ctrl[index] = CTRL_EMPTY;
+			++growthLeft;
+		}
+		else
+		{
+			ctrl[index] = CTRL_DELETED;
+		}
+	}
+
+	void Rehash(size_t newCapacity)
+	{
+		int8_t* oldCtrl = ctrl;
+		value_type* oldSlots = slots;
+		size_t oldCapacity = capacity;
+
+		Allocate(newCapacity);
+		for (size_t i = 0; i < oldCapacity; ++i)
+		{
+			if (oldCtrl[i] < 0)
+				continue;
+			uint64_t hash = MixHash(hasher(TPolicy::GetKey(oldSlots[i])));
+			size_t index = FindInsertIndex(hash);
+			::new ((void*)&slots[index]) value_type(std::move(oldSlots[i]));
+			oldSlots[i].~value_type();
+			ctrl[index] = H2(hash);
+		}
+		growthLeft -= elementCount;
+
+		if (oldCtrl)
+			FreeMemory(oldCtrl, oldCapacity);
+	}
+
+	// control bytes then slots, one block
+	static size_t GetSlotOffset(size_t inCapacity)
+	{
+		const size_t slotAlignment = alignof(value_type) > GROUP_WIDTH ? alignof(value_type) : GROUP_WIDTH;
+		return (inCapacity + slotAlignment - 1) & ~(slotAlignment - 1);
+	}
+
+	static size_t GetMemorySize(size_t inCapacity)
+	{
+		return GetSlotOffset(inCapacity) + inCapacity * sizeof(value_type);
+	}
+
+	// table is empty after this, elementCount stays for Rehash
+	void Allocate(size_t newCapacity)
+	{
+		const size_t alignment = alignof(value_type) > GROUP_WIDTH ? alignof(value_type) : GROUP_WIDTH;
+		char* memory = (char*)_Aligned_Allocate(GetMemorySize(newCapacity), 1, alignment);
+		TrackMemoryTag(Tag, (int64_t)GetMemorySize(newCapacity));
+		ctrl = (int8_t*)memory;
+		slots = (value_type*)(memory + GetSlotOffset(newCapacity));
+		capacity = newCapacity;
+		growthLeft = GetMaxCount(newCapacity);
+		memset(ctrl, CTRL_EMPTY, capacity);
+	}
+
+	static void FreeMemory(int8_t* memory, size_t inCapacity)
+	{
+		TrackMemoryTag(Tag, -(int64_t)GetMemorySize(inCapacity));
+		_Aligned_Deallocate(memory);
+	}
+
+	void DestroySlots()
+	{
+		if (!std::is_trivially_destructible<value_type>::value)
+		{
+			for (size_t i = 0; i < capacity; ++i)
+				if (ctrl[i] >= 0)
+					slots[i].~value_type();
+		}
+	}
+
+	void Release()
+	{
+		if (!ctrl)
+			return;
+		DestroySlots();
+		FreeMemory(ctrl, capacity);
+		ctrl = 0;
+		slots = 0;
+		capacity = 0;
+		elementCount = 0;
+		growthLeft = 0;
+	}
+
+	void CopyFrom(const REFlatTable& other)
+	{
+		if (other.elementCount == 0)
+			return;
+		Allocate(other.capacity);
+		// same capacity, same hash, every element goes to the same slot
+		for (size_t i = 0; i < other.capacity; ++i)
+		{
+			if (other.ctrl[i] >= 0)
+				::new ((void*)&slots[i]) value_type(other.slots[i]);
+			ctrl[i] = other.ctrl[i];
+		}
+		elementCount = other.elementCount;
+		growthLeft = other.growthLeft;
+	}
+
+	void Steal(REFlatTable& other)
+	{
+		ctrl = other.ctrl;
+		slots = other.slots;
+		capacity = other.capacity;
+		elementCount = other.elementCount;
+		growthLeft = other.growthLeft;
+		other.ctrl = 0;
+		other.slots = 0;
+		other.capacity = 0;
+		other.elementCount = 0;
+		other.growthLeft = 0;
+	}
+
+	int8_t* ctrl = 0;
+	value_type* slots = 0;
+	size_t capacity = 0;
+	size_t elementCount = 0;
+	// inserts into empty slots before the next rehash, tombstones don't give it back
+	size_t growthLeft = 0;
+
+	THash hasher;
+	TEqual equal;
+};
+
+// REMap without the nodes, for lookups on hot paths (profiler names, shader reload)
+// elements move when the table grows, don't keep pointers to them across inserts
+// keys aren't const so they can move, never change it->first
+// Tag is who gets the memory in the memory stats (GetMemoryTagStats)
+template<class TKey, class TValue, EMemoryTag Tag = EMemoryTag::Default, class THash = REFlatHash<TKey>, class TEqual = REFlatEqual<TKey>>
+class REFlatMap : public REFlatTable<TKey, REFlatMapPolicy<TKey, TValue>, THash, TEqual, Tag>
+{
+	typedef REFlatTable<TKey, REFlatMapPolicy<TKey, TValue>, THash, TEqual, Tag> Super;
+
+public:
+	typedef TKey key_type;
+	typedef TValue mapped_type;
+	typedef typename Super::value_type value_type;
+	typedef typename Super::iterator iterator;
+	typedef typename Super::const_iterator const_iterator;
+
+	// the key is only converted to TKey when it's added, map["name"] doesn't allocate once "name" is in
+	template<class K>
+	TValue& operator[](const K& key)
+	{
+		return try_emplace(key).first->second;
+	}
+
+	template<class K, class... TArgs>
+	std::pair<iterator, bool> try_emplace(const K& key, TArgs&&... args)
+	{
+		std::pair<size_t, bool> result = this->FindOrInsert(key, [&](void* memory)
+		{
+			::new (memory) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<TArgs>(args)...));
+		});
+		return std::make_pair(iterator(this, result.first), result.second);
+	}
+
+	template<class K, class... TArgs>
+	std::pair<iterator, bool> emplace(const K& key, TArgs&&... args)
+	{
+		return try_emplace(key, std::forward<TArgs>(args)...);
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)
+	{
+		return try_emplace(value.first, value.second);
+	}
+};
+
+// RESet without the nodes
+template<class TKey, EMemoryTag Tag = EMemoryTag::Default, class THash = REFlatHash<TKey>, class TEqual = REFlatEqual<TKey>>
+class REFlatSet : public REFlatTable<TKey, REFlatSetPolicy<TKey>, THash, TEqual, Tag>
+{
+	typedef REFlatTable<TKey, REFlatSetPolicy<TKey>, THash, TEqual, Tag> Super;
+
+public:
+	typedef TKey key_type;
+	typedef typename Super::value_type value_type;
+	typedef typename Super::const_iterator iterator;
+	typedef typename Super::const_iterator const_iterator;
+
+	// keys can't change in place, iterate as const
+	const_iterator begin() const { return Super::begin(); }
+	const_iterator end() const { return Super::end(); }
+
+	template<class K>
+	std::pair<const_iterator, bool> insert(const K& key)
+	{
+		std::pair<size_t, bool> result = this->FindOrInsert(key, [&](void* memory)
+		{
+			::new (memory) value_type(key);
+		});
+		return std::make_pair(const_iterator(this, result.first), result.second);
+	}
+
+	template<class K>
+	const_iterator find(const K& key) const
+	{
+		return Super::find(key);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <cstdint>
+#include <cassert>
+#include <new>
+#include <utility>
+
+#include "Containers/Containers.h"
+
+// handle to an element of a slot map: the slot and the generation of the slot when the element was made
+// destroying an element bumps the generation, old handles then find nothing instead of whatever reuses the slot
+// a default handle (generation 0) is null
+template<class T>
+struct SlotHandle
+{
+	uint32_t index;
+	uint32_t generation;
+
+	SlotHandle() : index(0), generation(0) {}
+	SlotHandle(uint32_t inIndex, uint32_t inGeneration) : index(inIndex), generation(inGeneration) {}
+
+	bool IsNull() const { return generation == 0; }
+
+	bool operator==(const SlotHandle& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+// one per slot, generation is odd while the slot holds an element and even while it's free
+struct SlotMapSlot
+{
+	// dense index when used, next free slot when free
+	uint32_t indexOrNextFree;
+	uint32_t generation;
+};
+
+static const uint32_t SLOT_MAP_NO_FREE_SLOT = 0xFFFFFFFF;
+
+// slot map with dense storage, elements sit packed in one array in no particular order
+// destroy moves the last element into the hole, iterating is a plain loop over [0, size())
+// pointers to elements change on Create and Destroy, keep a SlotHandle to find one again
+template<class T, EMemoryTag Tag = EMemoryTag::Default>
+class RESlotMap
+{
+public:
+	typedef SlotHandle<T> Handle;
+
+	template<class... TArgs>
+	Handle Create(TArgs&&... args)
+	{
+		uint32_t slotIndex = AllocateSlot();
+		SlotMapSlot& slot = slots[slotIndex];
+		slot.indexOrNextFree = (uint32_t)dense.size();
+		dense.emplace_back(std::forward<TArgs>(args)...);
+		denseToSlot.push_back(slotIndex);
+		return Handle(slotIndex, slot.generation);
+	}
+
+	// returns false if the handle was already destroyed
+	bool Destroy(Handle handle)
+	{
+		if (!Get(handle))
+			return false;
+		SlotMapSlot& slot = slots[handle.index];
+		uint32_t denseIndex = slot.indexOrNextFree;
+		uint32_t lastIndex = (uint32_t)dense.size() - 1;
+		if (denseIndex != lastIndex)
+		{
+			dense[denseIndex] = std::move(dense[lastIndex]);
+			denseToSlot[denseIndex] = denseToSlot[lastIndex];
+			slots[denseToSlot[denseIndex]].indexOrNextFree = denseIndex;
+		}
+		dense.pop_back();
+		denseToSlot.pop_back();
+		FreeSlot(handle.index);
+		return true;
+	}
+
+	// 0 if the element was destroyed
+	T* Get(Handle handle)
+	{
+		if (handle.IsNull() || handle.index >= slots.size() || slots[handle.index].generation != handle.generation)
+			return 0;
+		return &dense[slots[handle.index].indexOrNextFree];
+	}
+
+	const T* Get(Handle handle) const
+	{
+		return const_cast<RESlotMap*>(this)->Get(handle);
+	}
+
+	Handle GetHandle(int denseIndex) const
+	{
+		uint32_t slotIndex = denseToSlot[denseIndex];
+		return Handle(slotIndex, slots[slotIndex].generation);
+	}
+
+	Handle GetHandle(const T* element) const
+	{
+		return GetHandle((int)(element - dense.data()));
+	}
+
+	void Clear()
+	{
+		while (!dense.empty())
+			Destroy(GetHandle((int)dense.size() - 1));
+	}
+
+	void Reserve(int count)
+	{
+		dense.reserve(count);
+		denseToSlot.reserve(count);
+		slots.reserve(count);
+	}
+
+	int size() const { return (int)dense.size(); }
+	bool empty() const { return dense.empty(); }
+	T& operator[](int denseIndex) { return dense[denseIndex]; }
+	const T& operator[](int denseIndex) const { return dense[denseIndex]; }
+	T* data() { return dense.data(); }
+	T* begin() { return dense.data(); }
+	T* end() { return dense.data() + dense.size(); }
+	const T* begin() const { return dense.data(); }
+	const T* end() const { return dense.data() + dense.size(); }
+
+protected:
+	uint32_t AllocateSlot()
+	{
+		uint32_t slotIndex = freeHead;
+		if (slotIndex == SLOT_MAP_NO_FREE_SLOT)
+		{
+			slotIndex = (uint32_t)slots.size();
+			SlotMapSlot slot = { 0, 0 };
+			slots.push_back(slot);
+		}
+		else
+		{
+			freeHead = slots[slotIndex].indexOrNextFree;
+		}
+		++slots[slotIndex].generation;
+		return slotIndex;
+	}
+
+	void FreeSlot(uint32_t slotIndex)
+	{
+		SlotMapSlot& slot = slots[slotIndex];
+		++slot.generation;
+		slot.indexOrNextFree = freeHead;
+		freeHead = slotIndex;
+	}
+
+	REArray<T, 0, Tag> dense;
+	REArray<uint32_t, 0, Tag> denseToSlot;
+	REArray<SlotMapSlot, 0, Tag> slots;
+	uint32_t freeHead = SLOT_MAP_NO_FREE_SLOT;
+};
+
+// slot map whose elements never move, for things referenced by pointer all over (meshes, materials, mesh data)
+// elements are made in place in pages of PageSize, a destroyed element's slot is reused by the next Create
+// iterating walks the pages in order and skips free slots
+template<class T, EMemoryTag Tag = EMemoryTag::Default, int PageSize = 64>
+class REStableSlotMap
+{
+public:
+	typedef SlotHandle<T> Handle;
+
+	class Iterator
+	{
+	public:
+		Iterator(REStableSlotMap* inMap, uint32_t inIndex) : map(inMap), index(inIndex) {}
+
+		T& operator*() const { return *map->GetElement(index); }
+		T* operator->() const { return map->GetElement(index); }
+
+		Iterator& operator++()
+		{
+			index = map->SkipFree(index + 1);
+			return *this;
+		}
+
+		bool operator==(const Iterator& other) const { return index == other.index; }
+		bool operator!=(const Iterator& other) const { return index != other.index; }
+
+	private:
+		REStableSlotMap* map;
+		uint32_t index;
+	};
+
+	REStableSlotMap() {}
+
+	~REStableSlotMap()
+	{
+		Clear();
+		for (int i = 0, ni = (int)pages.size(); i < ni; ++i)
+		{
+			TrackMemoryTag(Tag, -(int64_t)(sizeof(T) * PageSize));
+			_Aligned_Deallocate(pages[i]);
+		}
+	}
+
+	// returns the element, its address stays the same until it's destroyed
+	template<class... TArgs>
+	T* Create(TArgs&&... args)
+	{
+		uint32_t slotIndex = AllocateSlot();
+		T* element = ::new ((void*)GetElement(slotIndex)) T(std::forward<TArgs>(args)...);
+		++count;
+		return element;
+	}
+
+	bool Destroy(Handle handle)
+	{
+		T* element = Get(handle);
+		if (!element)
+			return false;
+		element->~T();
+		FreeSlot(handle.index);
+		--count;
+		return true;
+	}
+
+	bool Destroy(T* element)
+	{
+		return Destroy(GetHandle(element));
+	}
+
+	// 0 if the element was destroyed
+	T* Get(Handle handle)
+	{
+		if (handle.IsNull() || handle.index >= slots.size() || slots[handle.index].generation != handle.generation)
+			return 0;
+		return GetElement(handle.index);
+	}
+
+	const T* Get(Handle handle) const
+	{
+		return const_cast<REStableSlotMap*>(this)->Get(handle);
+	}
+
+	// null handle if the element isn't in this map, looks through the pages
+	Handle GetHandle(const T* element) const
+	{
+		for (int pageIdx = 0, ni = (int)pages.size(); pageIdx < ni; ++pageIdx)
+		{
+			if (element >= pages[pageIdx] && element < pages[pageIdx] + PageSize)
+			{
+				uint32_t slotIndex = (uint32_t)(pageIdx * PageSize + (element - pages[pageIdx]));
+				if (slots[slotIndex].generation & 1)
+					return Handle(slotIndex, slots[slotIndex].generation);
+				break;
+			}
+		}
+		return Handle();
+	}
+
+	// destroys every element, keeps the pages
+	void Clear()
+	{
+		for (uint32_t i = 0, ni = (uint32_t)slots.size(); i < ni; ++i)
+		{
+			if (slots[i].generation & 1)
+			{
+				GetElement(i)->~T();
+				FreeSlot(i);
+			}
+		}
+		count = 0;
+	}
+
+	int size() const { return count; }
+	bool empty() const { return count == 0; }
+	Iterator begin() { return Iterator(this, SkipFree(0)); }
+	Iterator end() { return Iterator(this, (uint32_t)slots.size()); }
+
+protected:
+	T* GetElement(uint32_t slotIndex)
+	{
+		return pages[slotIndex / PageSize] + slotIndex % PageSize;
+	}
+
+	uint32_t SkipFree(uint32_t slotIndex) const
+	{
+		while (slotIndex < slots.size() && !(slots[slotIndex].generation & 1))
+			++slotIndex;
+		return slotIndex;
+	}
+
+	uint32_t AllocateSlot()
+	{
+		uint32_t slotIndex = freeHead;
+		if (slotIndex == SLOT_MAP_NO_FREE_SLOT)
+		{
+			slotIndex = (uint32_t)slots.size();
+			if (slotIndex % PageSize == 0)
+			{
+				pages.push_back((T*)_Aligned_Allocate(PageSize, sizeof(T), alignof(T)));
+				TrackMemoryTag(Tag, (int64_t)(sizeof(T) * PageSize));
+			}
+			SlotMapSlot slot = { 0, 0 };
+			slots.push_back(slot);
+		}
+		else
+		{
+			freeHead = slots[slotIndex].indexOrNextFree;
+		}
+		++slots[slotIndex].generation;
+		return slotIndex;
+	}
+
+	void FreeSlot(uint32_t slotIndex)
+	{
+		SlotMapSlot& slot = slots[slotIndex];
+		++slot.generation;
+		slot.indexOrNextFree = freeHead;
+		freeHead = slotIndex;
+	}
+
+	REArray<T*, 0, Tag> pages;
+	REArray<SlotMapSlot, 0, Tag> slots;
+	uint32_t freeHead = SLOT_MAP_NO_FREE_SLOT;
+	int count = 0;
+
+private:
+	REStableSlotMap(const REStableSlotMap&);
+	REStableSlotMap& operator=(const REStableSlotMap&);
+};
\ No newline at end of file
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <initializer_list>
+
+#include "Memory/Memory.h"
+
+// REArray with room for N elements inside the object, only goes to the heap when it grows past N
+// the elements of a small array live in the cache lines of whatever holds it (a component's mesh list)
+// same interface as REArray for what we use, moving an inline array moves the elements one by one
+template<class T, int N, int Alignment = 0, EMemoryTag Tag = EMemoryTag::Default>
+class RESmallArray
+{
+public:
+	static_assert(N > 0, "use REArray without inline storage");
+
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef size_t size_type;
+	typedef T& reference;
+	typedef const T& const_reference;
+
+	RESmallArray() : dataPtr(GetInlineData()), count(0), capacityCount(N) {}
+
+	RESmallArray(std::initializer_list<T> values) : RESmallArray()
+	{
+		assign(values.begin(), values.end());
+	}
+
+	RESmallArray(const RESmallArray& other) : RESmallArray()
+	{
+		assign(other.begin(), other.end());
+	}
+
+	RESmallArray(RESmallArray&& other) : RESmallArray()
+	{
+		MoveFrom(other);
+	}
+
+	~RESmallArray()
+	{
+		clear();
+		FreeHeap();
+	}
+
+	RESmallArray& operator=(const RESmallArray& other)
+	{
+		if (this != &other)
+			assign(other.begin(), other.end());
+		return *this;
+	}
+
+	RESmallArray& operator=(RESmallArray&& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	template<class TIterator>
+	void assign(TIterator first, TIterator last)
+	{
+		clear();
+		reserve((int)std::distance(first, last));
+		for (; first != last; ++first)
+			::new ((void*)(dataPtr + count++)) T(*first);
+	}
+
+	void push_back(const T& value)
+	{
+		if (count == capacityCount)
+		{
+			// value may be one of ours
+			T copy(value);
+			Grow(count + 1);
+			::new ((void*)(dataPtr + count++)) T(std::move(copy));
+			return;
+		}
+		::new ((void*)(dataPtr + count++)) T(value);
+	}
+
+	void push_back(T&& value)
+	{
+		if (count == capacityCount)
+		{
+			T moved(std::move(value));
+			Grow(count + 1);
+			::new ((void*)(dataPtr + count++)) T(std::move(moved));
+			return;
+		}
+		::new ((void*)(dataPtr + count++)) T(std::move(value));
+	}
+
+	template<class... TArgs>
+	T& emplace_back(TArgs&&... args)
+	{
+		if (count == capacityCount)
+		{
+			// args may refer to our elements, construct before they move
+			T value(std::forward<TArgs>(args)...);
+			Grow(count + 1);
+			T* element = ::new ((void*)(dataPtr + count)) T(std::move(value));
+			++count;
+			return *element;
+		}
+		T* element = ::new ((void*)(dataPtr + count)) T(std::forward<TArgs>(args)...);
+		++count;
+		return *element;
+	}
+
+	void pop_back()
+	{
+		assert(count > 0);
+		dataPtr[--count].~T();
+	}
+
+	iterator erase(const_iterator position)
+	{
+		return erase(position, position + 1);
+	}
+
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		T* eraseBegin = dataPtr + (first - dataPtr);
+		T* eraseEnd = dataPtr + (last - dataPtr);
+		T* newEnd = std::move(eraseEnd, end(), eraseBegin);
+		for (T* it = newEnd; it != end(); ++it)
+			it->~T();
+		count = (int)(newEnd - dataPtr);
+		return eraseBegin;
+	}
+
+	void resize(int newCount)
+	{
+		if (newCount > capacityCount)
+			Grow(newCount);
+		while (count < newCount)
+			::new ((void*)(dataPtr + count++)) T();
+		while (count > newCount)
+			dataPtr[--count].~T();
+	}
+
+	void resize(int newCount, const T& value)
+	{
+		if (newCount > capacityCount)
+		{
+			T copy(value);
+			Grow(newCount);
+			while (count < newCount)
+				::new ((void*)(dataPtr + count++)) T(copy);
+		}
+		while (count < newCount)
+			::new ((void*)(dataPtr + count++)) T(value);
+		while (count > newCount)
+			dataPtr[--count].~T();
+	}
+
+	void reserve(int newCapacity)
+	{
+		if (newCapacity > capacityCount)
+			Grow(newCapacity);
+	}
+
+	// keeps the heap buffer, like REArray
+	void clear()
+	{
+		for (int i = 0; i < count; ++i)
+			dataPtr[i].~T();
+		count = 0;
+	}
+
+	// still in the inline storage
+	bool is_inline() const { return dataPtr == GetInlineData(); }
+
+	size_t size() const { return (size_t)count; }
+	size_t capacity() const { return (size_t)capacityCount; }
+	bool empty() const { return count == 0; }
+	T* data() { return dataPtr; }
+	const T* data() const { return dataPtr; }
+	iterator begin() { return dataPtr; }
+	iterator end() { return dataPtr + count; }
+	const_iterator begin() const { return dataPtr; }
+	const_iterator end() const { return dataPtr + count; }
+	T& front() { return dataPtr[0]; }
+	const T& front() const { return dataPtr[0]; }
+	T& back() { return dataPtr[count - 1]; }
+	const T& back() const { return dataPtr[count - 1]; }
+	T& operator[](size_t index) { return dataPtr[index]; }
+	const T& operator[](size_t index) const { return dataPtr[index]; }
+
+protected:
+	static const size_t STORAGE_ALIGNMENT = (Alignment > (int)alignof(T)) ? (size_t)Alignment : alignof(T);
+	typedef REAllocator<T, Alignment, Tag> HeapAllocator;
+
+	T* GetInlineData() { return reinterpret_cast<T*>(&inlineStorage); }
+	const T* GetInlineData() const { return reinterpret_cast<const T*>(&inlineStorage); }
+
+	// to the heap, at least doubling
+	RE_NOINLINE void Grow(int minCapacity)
+	{
+		int newCapacity = capacityCount * 2 > minCapacity ? capacityCount * 2 : minCapacity;
+		T* newData = HeapAllocator().allocate(newCapacity);
+		for (int i = 0; i < count; ++i)
+		{
+			::new ((void*)(newData + i)) T(std::move(dataPtr[i]));
+			dataPtr[i].~T();
+		}
+		FreeHeap();
+		dataPtr = newData;
+		capacityCount = newCapacity;
+	}
+
+	void FreeHeap()
+	{
+		if (!is_inline())
+			HeapAllocator().deallocate(dataPtr, capacityCount);
+		dataPtr = GetInlineData();
+		capacityCount = N;
+	}
+
+	// this is empty
+	void MoveFrom(RESmallArray& other)
+	{
+		if (other.is_inline())
+		{
+			for (int i = 0; i < other.count; ++i)
+				::new ((void*)(dataPtr + i)) T(std::move(other.dataPtr[i]));
+			count = other.count;
+			other.clear();
+			return;
+		}
+		// take the heap buffer
+		FreeHeap();
+		dataPtr = other.dataPtr;
+		count = other.count;
+		capacityCount = other.capacityCount;
+		other.dataPtr = other.GetInlineData();
+		other.count = 0;
+		other.capacityCount = N;
+	}
+
+	T* dataPtr;
+	int count;
+	int capacityCount;
+	typename std::aligned_storage<sizeof(T) * N, STORAGE_ALIGNMENT>::type inlineStorage;
+};
\ No newline at end of file
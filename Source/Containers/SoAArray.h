@@ -0,0 +1,270 @@
+#pragma once
+
+#include <cassert>
+#include <new>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+#include "Memory/Memory.h"
+
+// structure of arrays, one array per field in TFields, field I of element i is Field<I>()[i]
+// a loop that needs two fields of every element streams those two arrays instead of whole objects
+// fields are picked by index, give them names with an enum next to the array (see gMeshCullData)
+// every array starts on its own cache line
+template<EMemoryTag Tag, class... TFields>
+class RESoAArray
+{
+public:
+	static const int FIELD_COUNT = sizeof...(TFields);
+	static_assert(FIELD_COUNT > 0, "no fields");
+
+	template<int I>
+	using FieldType = typename std::tuple_element<I, std::tuple<TFields...>>::type;
+
+	// one element, Get<I>() is its field I
+	template<bool bConst>
+	class ElementRef
+	{
+	public:
+		typedef typename std::conditional<bConst, const RESoAArray, RESoAArray>::type ArrayType;
+
+		ElementRef(ArrayType* inArray, int inIndex) : array(inArray), index(inIndex) {}
+
+		template<int I>
+		typename std::conditional<bConst, const FieldType<I>, FieldType<I>>::type& Get() const
+		{
+			return array->template Field<I>()[index];
+		}
+
+		int GetIndex() const { return index; }
+
+	private:
+		ArrayType* array;
+		int index;
+	};
+
+	typedef ElementRef<false> Reference;
+	typedef ElementRef<true> ConstReference;
+
+	// walks [begin, end) of an array and gives an ElementRef for each index, for a job's chunk of a ParallelForChunked
+	template<bool bConst>
+	class View
+	{
+	public:
+		typedef typename ElementRef<bConst>::ArrayType ArrayType;
+
+		class Iterator
+		{
+		public:
+			Iterator(ArrayType* inArray, int inIndex) : array(inArray), index(inIndex) {}
+
+			ElementRef<bConst> operator*() const { return ElementRef<bConst>(array, index); }
+			Iterator& operator++() { ++index; return *this; }
+			bool operator==(const Iterator& other) const { return index == other.index; }
+			bool operator!=(const Iterator& other) const { return index != other.index; }
+
+		private:
+			ArrayType* array;
+			int index;
+		};
+
+		View(ArrayType* inArray, int inBegin, int inEnd) : array(inArray), beginIndex(inBegin), endIndex(inEnd) {}
+
+		Iterator begin() const { return Iterator(array, beginIndex); }
+		Iterator end() const { return Iterator(array, endIndex); }
+		int size() const { return endIndex - beginIndex; }
+		ElementRef<bConst> operator[](int index) const { return ElementRef<bConst>(array, beginIndex + index); }
+
+	private:
+		ArrayType* array;
+		int beginIndex;
+		int endIndex;
+	};
+
+	RESoAArray() : count(0), capacityCount(0) {}
+
+	~RESoAArray()
+	{
+		clear();
+		FreeFields(std::index_sequence_for<TFields...>());
+	}
+
+	void push_back(const TFields&... values)
+	{
+		if (count == capacityCount)
+			Grow(count + 1);
+		ConstructFields(std::index_sequence_for<TFields...>(), count, values...);
+		++count;
+	}
+
+	void pop_back()
+	{
+		assert(count > 0);
+		--count;
+		DestroyFields(std::index_sequence_for<TFields...>(), count, count + 1);
+	}
+
+	// moves the last element into index, order isn't kept
+	void RemoveSwap(int index)
+	{
+		assert(index >= 0 && index < count);
+		if (index != count - 1)
+			MoveFields(std::index_sequence_for<TFields...>(), count - 1, index);
+		pop_back();
+	}
+
+	// new elements are default constructed
+	void resize(int newCount)
+	{
+		if (newCount > capacityCount)
+			Grow(newCount);
+		if (newCount > count)
+			DefaultConstructFields(std::index_sequence_for<TFields...>(), count, newCount);
+		else
+			DestroyFields(std::index_sequence_for<TFields...>(), newCount, count);
+		count = newCount;
+	}
+
+	void reserve(int newCapacity)
+	{
+		if (newCapacity > capacityCount)
+			Grow(newCapacity);
+	}
+
+	// keeps the memory
+	void clear()
+	{
+		DestroyFields(std::index_sequence_for<TFields...>(), 0, count);
+		count = 0;
+	}
+
+	template<int I>
+	FieldType<I>* Field() { return std::get<I>(fields); }
+
+	template<int I>
+	const FieldType<I>* Field() const { return std::get<I>(fields); }
+
+	template<int I>
+	FieldType<I>& Get(int index) { return std::get<I>(fields)[index]; }
+
+	template<int I>
+	const FieldType<I>& Get(int index) const { return std::get<I>(fields)[index]; }
+
+	Reference operator[](int index) { return Reference(this, index); }
+	ConstReference operator[](int index) const { return ConstReference(this, index); }
+
+	View<false> GetView(int beginIndex, int endIndex) { return View<false>(this, beginIndex, endIndex); }
+	View<true> GetView(int beginIndex, int endIndex) const { return View<true>(this, beginIndex, endIndex); }
+	View<false> GetView() { return GetView(0, count); }
+	View<true> GetView() const { return GetView(0, count); }
+
+	int size() const { return count; }
+	int capacity() const { return capacityCount; }
+	bool empty() const { return count == 0; }
+
+protected:
+	static const size_t FIELD_ALIGNMENT = 64;
+
+	// calls the expression once per field, there are no fold expressions in VS2015
+	#define SOA_FOR_EACH_FIELD(expression) { int expand[] = { 0, ((expression), 0)... }; (void)expand; }
+
+	template<class T>
+	static T* AllocateField(int fieldCapacity)
+	{
+		TrackMemoryTag(Tag, (int64_t)(sizeof(T) * fieldCapacity));
+		return (T*)_Aligned_Allocate(fieldCapacity, sizeof(T), alignof(T) > FIELD_ALIGNMENT ? alignof(T) : FIELD_ALIGNMENT);
+	}
+
+	template<class T>
+	static void FreeField(T* field, int fieldCapacity)
+	{
+		if (!field)
+			return;
+		TrackMemoryTag(Tag, -(int64_t)(sizeof(T) * fieldCapacity));
+		_Aligned_Deallocate(field);
+	}
+
+	// moves the elements to a new array of newCapacity
+	template<class T>
+	static void GrowField(T*& field, int elementCount, int oldCapacity, int newCapacity)
+	{
+		T* newField = AllocateField<T>(newCapacity);
+		for (int i = 0; i < elementCount; ++i)
+		{
+			::new ((void*)(newField + i)) T(std::move(field[i]));
+			field[i].~T();
+		}
+		FreeField(field, oldCapacity);
+		field = newField;
+	}
+
+	template<class T>
+	static void DefaultConstructRange(T* field, int beginIndex, int endIndex)
+	{
+		for (int i = beginIndex; i < endIndex; ++i)
+			::new ((void*)(field + i)) T();
+	}
+
+	template<class T>
+	static void DestroyRange(T* field, int beginIndex, int endIndex)
+	{
+		for (int i = beginIndex; i < endIndex; ++i)
+			field[i].~T();
+	}
+
+	template<size_t... Is>
+	RE_NOINLINE void Grow(int minCapacity, std::index_sequence<Is...>)
+	{
+		int newCapacity = capacityCount * 2 > minCapacity ? capacityCount * 2 : minCapacity;
+		SOA_FOR_EACH_FIELD(GrowField(std::get<Is>(fields), count, capacityCount, newCapacity));
+		capacityCount = newCapacity;
+	}
+
+	void Grow(int minCapacity)
+	{
+		Grow(minCapacity, std::index_sequence_for<TFields...>());
+	}
+
+	template<size_t... Is>
+	void FreeFields(std::index_sequence<Is...>)
+	{
+		SOA_FOR_EACH_FIELD(FreeField(std::get<Is>(fields), capacityCount));
+		fields = std::tuple<TFields*...>();
+		capacityCount = 0;
+	}
+
+	template<size_t... Is>
+	void ConstructFields(std::index_sequence<Is...>, int index, const TFields&... values)
+	{
+		SOA_FOR_EACH_FIELD(::new ((void*)(std::get<Is>(fields) + index)) TFields(values));
+	}
+
+	template<size_t... Is>
+	void DefaultConstructFields(std::index_sequence<Is...>, int beginIndex, int endIndex)
+	{
+		SOA_FOR_EACH_FIELD(DefaultConstructRange(std::get<Is>(fields), beginIndex, endIndex));
+	}
+
+	template<size_t... Is>
+	void DestroyFields(std::index_sequence<Is...>, int beginIndex, int endIndex)
+	{
+		SOA_FOR_EACH_FIELD(DestroyRange(std::get<Is>(fields), beginIndex, endIndex));
+	}
+
+	template<size_t... Is>
+	void MoveFields(std::index_sequence<Is...>, int fromIndex, int toIndex)
+	{
+		SOA_FOR_EACH_FIELD(std::get<Is>(fields)[toIndex] = std::move(std::get<Is>(fields)[fromIndex]));
+	}
+
+	#undef SOA_FOR_EACH_FIELD
+
+	std::tuple<TFields*...> fields;
+	int count;
+	int capacityCount;
+
+private:
+	RESoAArray(const RESoAArray&);
+	RESoAArray& operator=(const RESoAArray&);
+};
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "Containers/Containers.h"
+
+#include "GPUMemory.h"
+
+struct GLMemoryAllocation
+{
+	EMemoryTag tag;
+	int64_t bytes;
+};
+
+// GL object name to what it was counted as, textures, buffers and renderbuffers have their own names
+static REFlatMap<GLuint, GLMemoryAllocation> gTrackedGLTextures;
+static REFlatMap<GLuint, GLMemoryAllocation> gTrackedGLBuffers;
+static REFlatMap<GLuint, GLMemoryAllocation> gTrackedGLRenderbuffers;
+
+static void TrackGLObject(REFlatMap<GLuint, GLMemoryAllocation>& trackedObjects, GLuint object, EMemoryTag tag, int64_t bytes)
+{
+	auto it = trackedObjects.find(object);
+	if (it != trackedObjects.end())
+	{
+		TrackMemoryTag(it->second.tag, -it->second.bytes);
+		if (bytes <= 0)
+		{
+			trackedObjects.erase(object);
+			return;
+		}
+		it->second.tag = tag;
+		it->second.bytes = bytes;
+	}
+	else if (bytes > 0)
+	{
+		GLMemoryAllocation allocation = { tag, bytes };
+		trackedObjects.emplace(object, allocation);
+	}
+	TrackMemoryTag(tag, bytes);
+}
+
+int GetTextureFormatBytes(GLint internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_R8:
+	case GL_RED:
+		return 1;
+	case GL_RG8:
+	case GL_RG:
+	case GL_R16:
+	case GL_R16F:
+	case GL_DEPTH_COMPONENT16:
+		return 2;
+	case GL_RGBA8:
+	case GL_RGBA:
+	case GL_SRGB8_ALPHA8:
+	case GL_SRGB_ALPHA:
+	case GL_RGB10_A2:
+	case GL_R11F_G11F_B10F:
+	case GL_RG16:
+	case GL_RG16F:
+	case GL_R32F:
+	case GL_DEPTH_COMPONENT24:
+	case GL_DEPTH_COMPONENT32F:
+	case GL_DEPTH_COMPONENT:
+	case GL_DEPTH24_STENCIL8:
+	// 3 byte formats are padded to 4
+	case GL_RGB8:
+	case GL_RGB:
+	case GL_SRGB8:
+	case GL_SRGB:
+		return 4;
+	case GL_RGBA16:
+	case GL_RGBA16F:
+	case GL_RGB16F:
+	case GL_RG32F:
+	case GL_DEPTH32F_STENCIL8:
+		return 8;
+	case GL_RGBA32F:
+	case GL_RGB32F:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+int64_t GetTextureBytes(GLint internalFormat, int width, int height, int layerCount, bool bMipmaps)
+{
+	if (width <= 0 || height <= 0 || layerCount <= 0)
+		return 0;
+	int64_t texelCount = (int64_t)width * height;
+	if (bMipmaps)
+	{
+		while (width > 1 || height > 1)
+		{
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+			texelCount += (int64_t)width * height;
+		}
+	}
+	return texelCount * layerCount * GetTextureFormatBytes(internalFormat);
+}
+
+void TrackGLTexture(GLuint texture, EMemoryTag tag, int64_t bytes)
+{
+	TrackGLObject(gTrackedGLTextures, texture, tag, bytes);
+}
+
+void UntrackGLTexture(GLuint texture)
+{
+	TrackGLObject(gTrackedGLTextures, texture, EMemoryTag::Default, 0);
+}
+
+void TrackGLBuffer(GLuint buffer, EMemoryTag tag, int64_t bytes)
+{
+	TrackGLObject(gTrackedGLBuffers, buffer, tag, bytes);
+}
+
+void UntrackGLBuffer(GLuint buffer)
+{
+	TrackGLObject(gTrackedGLBuffers, buffer, EMemoryTag::Default, 0);
+}
+
+void TrackGLRenderbuffer(GLuint renderbuffer, EMemoryTag tag, int64_t bytes)
+{
+	TrackGLObject(gTrackedGLRenderbuffers, renderbuffer, tag, bytes);
+}
+
+void UntrackGLRenderbuffer(GLuint renderbuffer)
+{
+	TrackGLObject(gTrackedGLRenderbuffers, renderbuffer, EMemoryTag::Default, 0);
+}
\ No newline at end of file
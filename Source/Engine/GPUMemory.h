@@ -0,0 +1,26 @@
+#pragma once
+
+// glew
+#include "gl/glew.h"
+
+#include "Memory/Memory.h"
+
+// GL memory in the memory tag stats (GetMemoryTagStats), GL doesn't report sizes so they're computed from format and dimensions
+// every GL object is counted once, tracking it again replaces the old size so a Reallocate can't count twice
+// only call from the render thread, like the GL calls next to them
+
+// bytes per texel of a sized or unsized internal format, unsized ones are what drivers usually pick
+int GetTextureFormatBytes(GLint internalFormat);
+// layerCount is array layers, cube faces or both multiplied, bMipmaps adds the whole chain
+int64_t GetTextureBytes(GLint internalFormat, int width, int height, int layerCount = 1, bool bMipmaps = false);
+
+void TrackGLTexture(GLuint texture, EMemoryTag tag, int64_t bytes);
+void UntrackGLTexture(GLuint texture);
+
+// after glBufferData, with the same size
+void TrackGLBuffer(GLuint buffer, EMemoryTag tag, int64_t bytes);
+void UntrackGLBuffer(GLuint buffer);
+
+// after glRenderbufferStorage, sized like a texture (GetTextureBytes)
+void TrackGLRenderbuffer(GLuint renderbuffer, EMemoryTag tag, int64_t bytes);
+void UntrackGLRenderbuffer(GLuint renderbuffer);
\ No newline at end of file
@@ -3,7 +3,7 @@
 
 #include "Material.h"
 
-REArray<Material*> Material::gMaterialContainer;
+REStableSlotMap<Material, EMemoryTag::Material> Material::gMaterialContainer;
 
 void Material::Reload(Shader* inNewShader)
 {
@@ -56,15 +56,14 @@ void Material::DispatchCompute(struct RenderContext& renderContext, unsigned int
 	glDispatchCompute((GLuint)x, (GLuint)y, (GLuint)z);
 }
 
-void Material::SetParameter(const char* name, const char* data, int bytes, EMaterialParameterType type)
+void Material::SetParameter(StringID name, const char* data, int bytes, EMaterialParameterType type)
 {
 	MaterialParameter* params = 0;
 	int paramListSize = (int)parameterList.size();
 	for (int i = 0; i < paramListSize; ++i)
 	{
-		//if (parameterList.data()[i].name[0] == name[0])
 		params = &parameterList[i];
-		if (strcmp(params->name, name) == 0)
+		if (params->name == name)
 		{
 			break;
 		}
@@ -77,7 +76,7 @@ void Material::SetParameter(const char* name, const char* data, int bytes, EMate
 	{
 		parameterList.push_back(MaterialParameter());
 		params = &parameterList[paramListSize];
-		strcpy_s(params->name, name);
+		params->name = name;
 		params->offset = (int)parameterData.size();
 		params->count = bytes;
 		params->type = type;
@@ -96,18 +95,18 @@ void Material::SetParameter(const char* name, const char* data, int bytes, EMate
 	}
 }
 
-void Material::CopyParameter(const Material* otherMaterial, const REArray<char*>* names)
+void Material::CopyParameter(const Material* otherMaterial, const REArray<StringID>* names)
 {
 	assert(otherMaterial);
 	if (names)
 	{
 		for (int j = 0, nj = (int)names->size(); j < nj; ++j)
 		{
-			const char* name = (*names)[j];
+			StringID name = (*names)[j];
 			for (int i = 0, ni = (int)otherMaterial->parameterList.size(); i < ni; ++i)
 			{
 				const MaterialParameter* params = &otherMaterial->parameterList[i];
-				if (strcmp(params->name, name) == 0)
+				if (params->name == name)
 				{
 					SetParameter(name, otherMaterial->parameterData.data() + params->offset, params->count, params->type);
 					break;
@@ -2,6 +2,7 @@
 
 
 #include "Containers/Containers.h"
+#include "Containers/SlotMap.h"
 
 #include "Shader.h"
 #include "Texture2D.h"
@@ -22,7 +23,7 @@ enum class EMaterialParameterType
 class MaterialParameter
 {
 public:
-	char name[64];
+	StringID name;
 	int offset = 0;
 	int count = 0;
 	int location = -1; // uniform location for parameters, tex unit for textures
@@ -99,19 +100,20 @@ class Material
 {
 public:
 
-	static REArray<Material*> gMaterialContainer;
+	static REStableSlotMap<Material, EMemoryTag::Material> gMaterialContainer;
 
 	static Material* Create(Shader* inShader)
 	{
-		Material* mat = new Material(inShader);
-		gMaterialContainer.push_back(mat);
-		return mat;
+		return gMaterialContainer.Create(inShader);
 	}
 	static Material* Create(Material* otherMaterial)
 	{
-		Material* mat = new Material(otherMaterial);
-		gMaterialContainer.push_back(mat);
-		return mat;
+		return gMaterialContainer.Create(otherMaterial);
+	}
+	// meshes using it must be gone first
+	static void Destroy(Material* material)
+	{
+		gMaterialContainer.Destroy(material);
 	}
 
 	bool bBothSide = false;
@@ -119,8 +121,8 @@ public:
 	bool bMasked = false;
 
 	Shader* shader;
-	REArray<char> parameterData;
-	REArray<MaterialParameter> parameterList;
+	REArray<char, 0, EMemoryTag::Material> parameterData;
+	REArray<MaterialParameter, 0, EMemoryTag::Material> parameterList;
 
 	Material() {}
 	Material(Shader* inShader)
@@ -147,16 +149,17 @@ public:
 
 	void DispatchCompute(struct RenderContext& renderContext, unsigned int x, unsigned int y = 1, unsigned int z = 1);
 
-	void CopyParameter(const Material* otherMaterial, const REArray<char*>* names = 0);
+	void CopyParameter(const Material* otherMaterial, const REArray<StringID>* names = 0);
 
-	void SetParameter(const char* name, const char* data, int bytes, EMaterialParameterType type);
+	// names compare as integers, STRING_ID("name") skips hashing the string on every call
+	void SetParameter(StringID name, const char* data, int bytes, EMaterialParameterType type);
 
-	inline void SetParameter(const char* name, Texture* tex, bool bAsImage = false)
+	inline void SetParameter(StringID name, Texture* tex, bool bAsImage = false)
 	{
 		SetParameter(name, (char*)(&tex), sizeof(Texture*), bAsImage ? EMaterialParameterType::IMG : EMaterialParameterType::TEX);
 	}
 	
-	inline void SetParameter(const char* name, const Vector4& value, int count)
+	inline void SetParameter(StringID name, const Vector4& value, int count)
 	{
 		assert(count >= 2 && count <= 4);
 		EMaterialParameterType type = (count == 4) ? EMaterialParameterType::VEC4 :
@@ -164,17 +167,17 @@ public:
 		SetParameter(name, (char*)(value.m), count * sizeof(GLfloat), type);
 	}
 	
-	inline void SetParameter(const char* name, GLfloat value)
+	inline void SetParameter(StringID name, GLfloat value)
 	{
 		SetParameter(name, (char*)(&value), sizeof(GLfloat), EMaterialParameterType::FLOAT);
 	}
 
-	inline void SetParameter(const char* name, GLint value)
+	inline void SetParameter(StringID name, GLint value)
 	{
 		SetParameter(name, (char*)(&value), sizeof(GLint), EMaterialParameterType::INT);
 	}
 
-	inline void SetParameter(const char* name, const Matrix4& value)
+	inline void SetParameter(StringID name, const Matrix4& value)
 	{
 		SetParameter(name, (char*)(value.m), 16 * sizeof(GLfloat), EMaterialParameterType::MAT4);
 	}
@@ -2,10 +2,11 @@
 #include "GL/glew.h"
 
 #include "Render.h"
+#include "GPUMemory.h"
 
 #include "Mesh.h"
 
-REArray<MeshData*> MeshData::gMeshDataContainer;
+REStableSlotMap<MeshData, EMemoryTag::Mesh> MeshData::gMeshDataContainer;
 
 void MeshData::InitResource()
 {
@@ -13,11 +14,17 @@ void MeshData::InitResource()
 
 	// clear old buffer
 	if (VAO)
-		glDeleteBuffers(1, &VAO);
+		glDeleteVertexArrays(1, &VAO);
 	if (VBO)
+	{
+		UntrackGLBuffer(VBO);
 		glDeleteBuffers(1, &VBO);
+	}
 	if (EBO)
+	{
+		UntrackGLBuffer(EBO);
 		glDeleteBuffers(1, &EBO);
+	}
 
 	// create buffer
 	glGenVertexArrays(1, &VAO);
@@ -28,9 +35,11 @@ void MeshData::InitResource()
 	// VBO data
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, vertCount * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+	TrackGLBuffer(VBO, EMemoryTag::GPUVertexBuffer, vertCount * sizeof(Vertex));
 	// EBO data
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, idxCount * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	TrackGLBuffer(EBO, EMemoryTag::GPUIndexBuffer, idxCount * sizeof(GLuint));
 	
 	// position
 	{
@@ -60,7 +69,21 @@ void MeshData::InitResource()
 		bounds += vertices[i].position.ToVector4();
 }
 
-REArray<Mesh*> Mesh::gMeshContainer;
+void MeshData::ReleaseResource()
+{
+	if (!bHasResource)
+		return;
+	bHasResource = false;
+
+	UntrackGLBuffer(VBO);
+	UntrackGLBuffer(EBO);
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
+	VAO = VBO = EBO = 0;
+}
+
+REStableSlotMap<Mesh, EMemoryTag::Mesh> Mesh::gMeshContainer;
 
 void Mesh::Init(MeshData* inMeshData, Material* inMaterial)
 {
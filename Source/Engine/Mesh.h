@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Containers/Containers.h"
+#include "Containers/SlotMap.h"
 #include "Math/REMath.h"
 #include "Math/UVector.h"
 #include "Material.h"
@@ -46,13 +47,18 @@ struct Vertex
 class MeshData
 {
 public:
-	static REArray<MeshData*> gMeshDataContainer;
+	static REStableSlotMap<MeshData, EMemoryTag::Mesh> gMeshDataContainer;
 
 	static MeshData* Create()
 	{
-		MeshData* md = new MeshData();
-		gMeshDataContainer.push_back(md);
-		return md;
+		return gMeshDataContainer.Create();
+	}
+
+	// meshes using it must be gone first
+	static void Destroy(MeshData* meshData)
+	{
+		meshData->ReleaseResource();
+		gMeshDataContainer.Destroy(meshData);
 	}
 
 	MeshData() :
@@ -69,9 +75,13 @@ public:
 	}
 
 	void InitResource();
+	void ReleaseResource();
+
+	typedef REArray<Vertex, 0, EMemoryTag::Mesh> VertexArray;
+	typedef REArray<GLuint, 0, EMemoryTag::Mesh> IndexArray;
 
-	REArray<Vertex> vertices;
-	REArray<GLuint> indices;
+	VertexArray vertices;
+	IndexArray indices;
 	GLsizei vertCount;
 	GLsizei idxCount;
 
@@ -85,13 +95,11 @@ class Mesh
 {
 public:
 
-	static REArray<Mesh*> gMeshContainer;
+	static REStableSlotMap<Mesh, EMemoryTag::Mesh> gMeshContainer;
 
 	static Mesh* Create()
 	{
-		Mesh* mesh = new Mesh();
-		gMeshContainer.push_back(mesh);
-		return mesh;
+		return gMeshContainer.Create();
 	}
 
 	static Mesh* Create(MeshData* inMeshData, Material* inMaterial = 0)
@@ -101,6 +109,12 @@ public:
 		return mesh;
 	}
 
+	// components using it must be gone first, the mesh data and material stay
+	static void Destroy(Mesh* mesh)
+	{
+		gMeshContainer.Destroy(mesh);
+	}
+
 	MeshData* meshData;
 	Material* material;
 
@@ -132,8 +146,8 @@ public:
 
 static void MakeCube(MeshData& meshData)
 {
-	REArray<Vertex>& vertList = meshData.vertices;
-	REArray<GLuint>& idxList = meshData.indices;
+	MeshData::VertexArray& vertList = meshData.vertices;
+	MeshData::IndexArray& idxList = meshData.indices;
 	Vector4_2 uv[4] =
 	{
 		Vector4_2(0, 0),
@@ -189,8 +203,8 @@ static void MakeCube(MeshData& meshData)
 
 static void MakeSphere(MeshData& meshData, int div)
 {
-	REArray<Vertex>& vertList = meshData.vertices;
-	REArray<GLuint>& idxList = meshData.indices;
+	MeshData::VertexArray& vertList = meshData.vertices;
+	MeshData::IndexArray& idxList = meshData.indices;
 
 	int latDiv = div / 2 + 1;
 
@@ -279,8 +293,8 @@ static Vector4_3 GetTangent(Vector4_3 normal)
 
 static void MakeCone(MeshData& meshData, int firstRingVertCount, int level)
 {
-	REArray<Vertex>& vertList = meshData.vertices;
-	REArray<GLuint>& idxList = meshData.indices;
+	MeshData::VertexArray& vertList = meshData.vertices;
+	MeshData::IndexArray& idxList = meshData.indices;
 
 	Vector4_3 mainAxis(0, 0, -1);
 	Vector4_3 secAxis(0, 1, 0);
@@ -393,8 +407,8 @@ static int FindNewVert(const REArray<Vector4_3>& newVertTable, int i0, int i1)
 
 static void MakeIcosahedron(MeshData& meshData, int tesLevel)
 {
-	REArray<Vertex>& vertList = meshData.vertices;
-	REArray<GLuint>& idxList = meshData.indices;
+	MeshData::VertexArray& vertList = meshData.vertices;
+	MeshData::IndexArray& idxList = meshData.indices;
 
 	vertList.empty();
 	idxList.empty();
@@ -529,8 +543,8 @@ static void MakeIcosahedron(MeshData& meshData, int tesLevel)
 // view space quad
 static void MakeQuadVS(MeshData& meshData)
 {
-	REArray<Vertex>& vertList = meshData.vertices;
-	REArray<GLuint>& idxList = meshData.indices;
+	MeshData::VertexArray& vertList = meshData.vertices;
+	MeshData::IndexArray& idxList = meshData.indices;
 
 	vertList.reserve(4);
 	idxList.reserve(6);
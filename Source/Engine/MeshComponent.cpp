@@ -4,7 +4,7 @@
 
 #include "MeshComponent.h"
 
-REArray<MeshComponent*> MeshComponent::gMeshComponentContainer;
+MeshComponent::Container MeshComponent::gMeshComponentContainer;
 
 void MeshComponent::CacheRenderMatrices()
 {
@@ -33,7 +33,7 @@ void MeshComponent::UpdateEndOfFrame(float deltaTime)
 
 void MeshComponent::SetMeshList(const REArray<Mesh*>& inMeshList)
 {
-	meshList = inMeshList;
+	meshList.assign(inMeshList.begin(), inMeshList.end());
 	for (int i = 0, ni = (int)inMeshList.size(); i < ni; ++i)
 	{
 		MeshData* meshData = inMeshList[i]->meshData;
@@ -53,18 +53,18 @@ void MeshComponent::Draw(RenderContext& renderContext, Material* overrideMateria
 {
 	if (overrideMaterial)
 	{
-		overrideMaterial->SetParameter("prevModelMat", prevModelMat);
-		overrideMaterial->SetParameter("modelMat", modelMat);
-		//overrideMaterial->SetParameter("normalMat", normalMat);
+		overrideMaterial->SetParameter(STRING_ID("prevModelMat"), prevModelMat);
+		overrideMaterial->SetParameter(STRING_ID("modelMat"), modelMat);
+		//overrideMaterial->SetParameter(STRING_ID("normalMat"), normalMat);
 	}
 	for (int i = 0, ni = (int)meshList.size(); i < ni; ++i)
 	{
 		Mesh*& mesh = meshList[i];
 		if (!overrideMaterial)
 		{
-			mesh->material->SetParameter("prevModelMat", prevModelMat);
-			mesh->material->SetParameter("modelMat", modelMat);
-			//meshListPtr[i]->material->SetParameter("normalMat", normalMat);
+			mesh->material->SetParameter(STRING_ID("prevModelMat"), prevModelMat);
+			mesh->material->SetParameter(STRING_ID("modelMat"), modelMat);
+			//meshListPtr[i]->material->SetParameter(STRING_ID("normalMat"), normalMat);
 		}
 
 		mesh->Draw(renderContext, overrideMaterial);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Containers/Containers.h"
+#include "Containers/SlotMap.h"
 
 #include "Math/REMath.h"
 
@@ -11,13 +12,27 @@ class Mesh;
 class MeshComponent : public Component
 {
 public:
-	static REArray<MeshComponent*> gMeshComponentContainer;
+	// packed, culling and the shadow passes walk every component every frame
+	typedef RESlotMap<MeshComponent, EMemoryTag::Mesh> Container;
+	static Container gMeshComponentContainer;
 
+	// nearly every component has one or two meshes, they sit inline in the component
+	typedef RESmallArray<Mesh*, 2, 0, EMemoryTag::Mesh> MeshList;
+
+	// the pointer is only good until the next Create or Destroy, keep GetHandle() to find the component later
 	static MeshComponent* Create()
 	{
-		MeshComponent* mc = new MeshComponent();
-		gMeshComponentContainer.push_back(mc);
-		return mc;
+		return gMeshComponentContainer.Get(gMeshComponentContainer.Create());
+	}
+
+	static void Destroy(SlotHandle<MeshComponent> handle)
+	{
+		gMeshComponentContainer.Destroy(handle);
+	}
+
+	SlotHandle<MeshComponent> GetHandle() const
+	{
+		return gMeshComponentContainer.GetHandle(this);
 	}
 
 	Vector4_3 position;
@@ -30,10 +45,9 @@ public:
 
 	BoxBounds bounds;
 
+	// culling reads copies of OBB, modelMat and bounds, see gMeshCullData
 	OrientedBoxBounds OBB;
 
-	bool bRenderVisibile = true; // for shadow rendering
-
 	MeshComponent()
 	: position(Vector4_3::Zero())
 	, rotation(Vector4_3::Zero())
@@ -76,7 +90,7 @@ public:
 
 	virtual void UpdateEndOfFrame(float deltaTime) override;
 
-	const REArray<Mesh*>& GetMeshList() { return meshList; }
+	const MeshList& GetMeshList() { return meshList; }
 	void SetMeshList(const REArray<Mesh*>& inMeshList);
 	void AddMesh(Mesh* inMesh);
 
@@ -87,7 +101,7 @@ protected:
 	bool bRenderTransformDirty;
 	bool bHasCachedRenderTransform;
 
-	REArray<Mesh*> meshList;
+	MeshList meshList;
 
 	void CacheRenderMatrices();
 };
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "Mesh.h"
 
 #include "Profiler.h"
+#include "JobSystem/JobSystem.h"
 
 enum class EMeshConversion
 {
@@ -25,8 +26,8 @@ void ProcessMesh(REArray<Mesh*>& output, aiMesh* mesh, const aiScene* scene, REA
 
 	// create mesh data
 	MeshData* meshData = MeshData::Create();
-	REArray<Vertex>& vertList = meshData->vertices;
-	REArray<GLuint>& idxList = meshData->indices;
+	MeshData::VertexArray& vertList = meshData->vertices;
+	MeshData::IndexArray& idxList = meshData->indices;
 
 	bool bHasTexCoord = (mesh->mTextureCoords[0] > 0);
 	for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
@@ -71,6 +72,8 @@ void ProcessNode(REArray<Mesh*>& output, aiNode* node, const aiScene* scene, REA
 	{
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
 		ProcessMesh(output, mesh, scene, materials, conversion);
+		// big scenes take a while, let queued jobs (render jobs on the render worker) run in between
+		JobYield();
 	}
 	for (unsigned int i = 0; i < node->mNumChildren; ++i)
 	{
@@ -1,13 +1,15 @@
 #include "Profiler.h"
 
 
-RESortedMap<std::string, double> ScopedProfileTimerCPU::timerMap;
-REMap<std::string, double> ScopedProfileTimerCPU::timeStampMap[2];
+RESortedMap<std::string, double, 0, EMemoryTag::Profiler> ScopedProfileTimerCPU::timerMap;
+REFlatMap<StringID, double, EMemoryTag::Profiler> ScopedProfileTimerCPU::timeStampMap[2];
 int ScopedProfileTimerCPU::MapWriteIdx = 0;
 char ScopedProfileTimerCPU::fullName[1024];
+uint32_t ScopedProfileTimerCPU::pathID = STRING_ID_OFFSET_BASIS;
 
 
-RESortedMap<std::string, double> ScopedProfileTimerGPU::timerMap;
-REMap<std::string, REArray<TimestampPair>> ScopedProfileTimerGPU::timeStampPairMap[2];
+RESortedMap<std::string, double, 0, EMemoryTag::Profiler> ScopedProfileTimerGPU::timerMap;
+REFlatMap<StringID, REArray<TimestampPair, 0, EMemoryTag::Profiler>, EMemoryTag::Profiler> ScopedProfileTimerGPU::timeStampPairMap[2];
 int ScopedProfileTimerGPU::MapWriteIdx = 0;
-char ScopedProfileTimerGPU::fullName[1024];
\ No newline at end of file
+char ScopedProfileTimerGPU::fullName[1024];
+uint32_t ScopedProfileTimerGPU::pathID = STRING_ID_OFFSET_BASIS;
\ No newline at end of file
@@ -8,6 +8,7 @@
 
 #include "Containers/Containers.h"
 #include "Math/REMath.h"
+#include "StringID.h"
 
 #include "SDL.h"
 #include "SDL_opengl.h"
@@ -62,12 +63,16 @@ class ScopedProfileTimerCPU
 {
 	Uint64 start;
 	size_t nameSize;
+	uint32_t parentPathID;
 
 public:
-	static RESortedMap<std::string, double> timerMap;
-	static REMap<std::string, double> timeStampMap[2];
+	static RESortedMap<std::string, double, 0, EMemoryTag::Profiler> timerMap;
+	// keyed by the StringID of fullName, a scope only hashes its own name onto the parent's ID
+	static REFlatMap<StringID, double, EMemoryTag::Profiler> timeStampMap[2];
 	static int MapWriteIdx;
 	static char fullName[1024];
+	// HashStringID(fullName)
+	static uint32_t pathID;
 
 	static void Swap()
 	{
@@ -76,7 +81,7 @@ public:
 		for (auto it = timeStampMap[MapReadIdx].begin(); it != timeStampMap[MapReadIdx].end(); ++it)
 		{
 			// update
-			timerMap[it->first] = it->second;
+			timerMap[it->first.c_str()] = it->second;
 			// clear
 			it->second = 0;
 		}
@@ -88,6 +93,8 @@ public:
 		// add to prefix
 		strcat_s(fullName, "/");
 		strcat_s(fullName, inName);
+		parentPathID = pathID;
+		pathID = HashStringID(inName, HashStringID("/", pathID));
 
 		start = SDL_GetPerformanceCounter();
 	}
@@ -96,19 +103,15 @@ public:
 	{
 		Uint64 end = SDL_GetPerformanceCounter();
 		double deltaTime = (double)((end - start) * 1000) * gInvPerformanceFreq;
-		auto it = timeStampMap[MapWriteIdx].find(fullName);
-		if (it != timeStampMap[MapWriteIdx].end())
-		{
-			// find it
-			it->second += deltaTime;
-		}
-		else
-		{
-			timeStampMap[MapWriteIdx][fullName] = deltaTime;
-		}
+		auto it = timeStampMap[MapWriteIdx].find(StringID(pathID));
+		// first time, the name is interned so Swap can print it
+		if (it == timeStampMap[MapWriteIdx].end())
+			it = timeStampMap[MapWriteIdx].emplace(StringID(StringID::Intern(fullName, pathID)), 0.0).first;
+		it->second += deltaTime;
 		// remove from full name
 		size_t len = strlen(fullName);
 		fullName[len - nameSize - 1] = 0;
+		pathID = parentPathID;
 	}
 };
 
@@ -116,12 +119,15 @@ class ScopedProfileTimerGPU
 {
 	TimestampPair query;
 	size_t nameSize;
+	uint32_t parentPathID;
 
 public:
-	static RESortedMap<std::string, double> timerMap;
-	static REMap<std::string, REArray<TimestampPair>> timeStampPairMap[2];
+	static RESortedMap<std::string, double, 0, EMemoryTag::Profiler> timerMap;
+	static REFlatMap<StringID, REArray<TimestampPair, 0, EMemoryTag::Profiler>, EMemoryTag::Profiler> timeStampPairMap[2];
 	static int MapWriteIdx;
 	static char fullName[1024];
+	// HashStringID(fullName)
+	static uint32_t pathID;
 
 	static void Swap()
 	{
@@ -141,10 +147,11 @@ public:
 			//if (elapsed > 0)
 			{
 				// update
-				if (timerMap[it->first] > 0)
-					timerMap[it->first] = Lerp(timerMap[it->first], elapsed, 0.2);
+				double& timer = timerMap[it->first.c_str()];
+				if (timer > 0)
+					timer = Lerp(timer, elapsed, 0.2);
 				else
-					timerMap[it->first] = elapsed;
+					timer = elapsed;
 			}
 			// clear
 			it->second.clear();
@@ -157,6 +164,8 @@ public:
 		// add to prefix
 		strcat_s(fullName, "/");
 		strcat_s(fullName, inName);
+		parentPathID = pathID;
+		pathID = HashStringID(inName, HashStringID("/", pathID));
 
 		glGenQueries(2, query.m);
 		glQueryCounter(query.m[0], GL_TIMESTAMP);
@@ -165,7 +174,10 @@ public:
 	~ScopedProfileTimerGPU()
 	{
 		glQueryCounter(query.m[1], GL_TIMESTAMP);
-		timeStampPairMap[MapWriteIdx][fullName].push_back(query);
+		auto it = timeStampPairMap[MapWriteIdx].find(StringID(pathID));
+		if (it == timeStampPairMap[MapWriteIdx].end())
+			it = timeStampPairMap[MapWriteIdx].emplace(StringID(StringID::Intern(fullName, pathID))).first;
+		it->second.push_back(query);
 		//auto it = timerMap.find(fullName);
 		//if (it == timerMap.end())
 		//{
@@ -174,5 +186,6 @@ public:
 		// remove from full name
 		size_t len = strlen(fullName);
 		fullName[len - nameSize - 1] = 0;
+		pathID = parentPathID;
 	}
 };
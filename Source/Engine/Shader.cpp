@@ -181,7 +181,7 @@ void Shader::Load(const GLchar* vertexPath, const GLchar* geometryPath, const GL
 		auto it = gShaderFileCache.find(dependent);
 		if (it != gShaderFileCache.end())
 		{
-			it->second.shaders.erase(this);
+			it->second.RemoveShader(this);
 		}
 	}
 	dependentFileNames.clear();
@@ -216,9 +216,9 @@ void Shader::Load(const GLchar* vertexPath, const GLchar* geometryPath, const GL
 		"image2DMSArray"
 	};
 
-	TexUnitList.clear();
-	ImgUnitList.clear();
-	UniformLocationList.clear();
+	texUnits.clear();
+	imgUnits.clear();
+	uniformLocations.clear();
 	for (int shaderInfoIdx = 0; shaderInfoIdx < shaderInfoCount; ++shaderInfoIdx)
 	{
 		ShaderInfo& shaderInfo = shaderInfoList[shaderInfoIdx];
@@ -230,7 +230,8 @@ void Shader::Load(const GLchar* vertexPath, const GLchar* geometryPath, const GL
 		{
 			for (int nameIdx = 0; nameIdx < it->second.size(); ++nameIdx)
 			{
-				UniformLocationList.push_back(ValuePair(it->second[nameIdx].c_str(), -1));
+				StringID uniformName(it->second[nameIdx].c_str());
+				uniformLocations.emplace(uniformName, -1);
 				bool bTexUniform = false;
 				for (int i = 0; i < _countof(samplers); ++i)
 				{
@@ -243,7 +244,7 @@ void Shader::Load(const GLchar* vertexPath, const GLchar* geometryPath, const GL
 				if (bTexUniform)
 				{
 					// custom texture unit, init to be -1, don't bind it unless used
-					TexUnitList.push_back(ValuePair(it->second[nameIdx].c_str(), -1));
+					texUnits.emplace(uniformName, -1);
 					continue;
 				}
 
@@ -259,7 +260,7 @@ void Shader::Load(const GLchar* vertexPath, const GLchar* geometryPath, const GL
 				if (bImgUniform)
 				{
 					// custom texture unit, init to be -1, don't bind it unless used
-					ImgUnitList.push_back(ValuePair(it->second[nameIdx].c_str(), -1));
+					imgUnits.emplace(uniformName, -1);
 					continue;
 				}
 			}
@@ -272,7 +273,7 @@ void Shader::Load(const GLchar* vertexPath, const GLchar* geometryPath, const GL
 		auto it = gShaderFileCache.find(dependent);
 		if (it != gShaderFileCache.end())
 		{
-			it->second.shaders.insert(this);
+			it->second.AddShader(this);
 		}
 	}
 
@@ -296,7 +297,7 @@ void Shader::Load(const GLchar* vertexPath, const GLchar* geometryPath, const GL
 		SetTextureUnit("gSceneColorTex", gSceneColorTexUnit, true);
 	}
 	// custom
-	//for (auto it = TexUnitList.begin(); it != TexUnitList.end(); ++it)
+	//for (auto it = texUnits.begin(); it != texUnits.end(); ++it)
 	//{
 	//	SetTextureUnit(it->first.c_str(), it->second);
 	//}
@@ -335,20 +336,15 @@ GLint Shader::GetUniformLocation_Internal(const GLchar* name, bool bSilent)
 	return location;
 }
 
-GLint Shader::GetUniformLocation(const GLchar* name, bool bSilent)
+GLint Shader::GetUniformLocation(StringID name, bool bSilent)
 {
-	//return GetUniformLocation_Internal(name);
-	for (int i = 0, ni = (int)UniformLocationList.size(); i < ni; ++i)
-	{
-		ValuePair& pair = UniformLocationList[i];
-		if (strcmp(pair.key, name) == 0)
-		{
-			if (pair.value < 0)
-				pair.value = GetUniformLocation_Internal(name, bSilent);
-			return pair.value;
-		}
-	}
-	return -1;
+	//return GetUniformLocation_Internal(name.c_str());
+	auto it = uniformLocations.find(name);
+	if (it == uniformLocations.end())
+		return -1;
+	if (it->second < 0)
+		it->second = GetUniformLocation_Internal(name.c_str(), bSilent);
+	return it->second;
 }
 
 void Shader::BindUniformBlock(const GLchar* name, GLuint bindingPoint)
@@ -373,48 +369,42 @@ void Shader::SetTextureUnit(const GLchar* name, GLuint texUnit, bool bSilent)
 		glUniform1i(location, texUnit);
 }
 
-GLint Shader::GetTextureUnit(const GLchar* name)
+GLint Shader::GetTextureUnit(StringID name)
 {
-	for (int i = 0, ni = (int)TexUnitList.size(); i < ni; ++i)
+	auto it = texUnits.find(name);
+	if (it != texUnits.end())
 	{
-		ValuePair& pair = TexUnitList[i];
-		if (strcmp(pair.key, name) == 0)
+		if (it->second < 0)
 		{
-			if (pair.value < 0)
-			{
-				pair.value = nextTexUnit;
-				SetTextureUnit(pair.key, pair.value);
-				++nextTexUnit;
-			}
-			return pair.value;
+			it->second = nextTexUnit;
+			SetTextureUnit(name.c_str(), it->second);
+			++nextTexUnit;
 		}
+		return it->second;
 	}
 	if(computeFilePath[0])
-		printf("%s is not a valid texture name! (comp: %s)\n", name, computeFilePath);
+		printf("%s is not a valid texture name! (comp: %s)\n", name.c_str(), computeFilePath);
 	else
-		printf("%s is not a valid texture name! (vert: %s frag: %s)\n", name, vertexFilePath, fragmentFilePath);
+		printf("%s is not a valid texture name! (vert: %s frag: %s)\n", name.c_str(), vertexFilePath, fragmentFilePath);
 	return -1;
 }
 
-GLint Shader::GetImageUnit(const GLchar* name)
+GLint Shader::GetImageUnit(StringID name)
 {
-	for (int i = 0, ni = (int)ImgUnitList.size(); i < ni; ++i)
+	auto it = imgUnits.find(name);
+	if (it != imgUnits.end())
 	{
-		ValuePair& pair = ImgUnitList[i];
-		if (strcmp(pair.key, name) == 0)
+		if (it->second < 0)
 		{
-			if (pair.value < 0)
-			{
-				pair.value = nextImgUnit;
-				SetTextureUnit(pair.key, pair.value);
-				++nextImgUnit;
-			}
-			return pair.value;
+			it->second = nextImgUnit;
+			SetTextureUnit(name.c_str(), it->second);
+			++nextImgUnit;
 		}
+		return it->second;
 	}
 	if (computeFilePath[0])
-		printf("%s is not a valid image name! (comp: %s)\n", name, computeFilePath);
+		printf("%s is not a valid image name! (comp: %s)\n", name.c_str(), computeFilePath);
 	else
-		printf("%s is not a valid image name! (vert: %s frag: %s)\n", name, vertexFilePath, fragmentFilePath);
+		printf("%s is not a valid image name! (vert: %s frag: %s)\n", name.c_str(), vertexFilePath, fragmentFilePath);
 	return -1;
 }
\ No newline at end of file
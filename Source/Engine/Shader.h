@@ -9,6 +9,7 @@
 #include <cassert>
 
 #include "Containers/Containers.h"
+#include "StringID.h"
 
 class Material;
 
@@ -49,18 +50,6 @@ public:
 	}
 };
 
-struct ValuePair
-{
-	char key[128];
-	GLint value;
-
-	ValuePair(const char* inKey, GLint inValue) :
-		value(inValue)
-	{
-		strcpy_s(key, inKey);
-	}
-};
-
 enum class EShaderBindingUBO : GLuint
 {
 	RenderInfo,
@@ -114,9 +103,10 @@ public:
 
 	RESet<Material*> referenceMaterials;
 
-	REArray<ValuePair> TexUnitList;
-	REArray<ValuePair> ImgUnitList;
-	REArray<ValuePair> UniformLocationList;
+	// every uniform of the program by name, -1 until the first lookup
+	REFlatMap<StringID, GLint> uniformLocations;
+	REFlatMap<StringID, GLint> texUnits;
+	REFlatMap<StringID, GLint> imgUnits;
 
 	Shader()
 	{
@@ -164,7 +154,7 @@ public:
 
 	GLint GetUniformLocation_Internal(const GLchar* name, bool bSilent = false);
 
-	GLint GetUniformLocation(const GLchar* name, bool bSilent = false);
+	GLint GetUniformLocation(StringID name, bool bSilent = false);
 
 	void BindUniformBlock(const GLchar* name, GLuint bindingPoint);
 	void BindShaderStorageBlock(const GLchar* name, GLuint bindingPoint);
@@ -172,6 +162,6 @@ public:
 	// used for both texture and image
 	void SetTextureUnit(const GLchar* name, GLuint texUnit, bool bSilent = false);
 
-	GLint GetTextureUnit(const GLchar* name);
-	GLint GetImageUnit(const GLchar* name);
+	GLint GetTextureUnit(StringID name);
+	GLint GetImageUnit(StringID name);
 };
@@ -8,6 +8,7 @@
 #include <stack>
 #include <set>
 #include <cassert>
+#include <algorithm>
 
 #include "Shader.h"
 #include "Util.h"
@@ -118,8 +119,30 @@ class ShaderFileInfo
 public:
 	std::string fileName;
 	ShaderInfo shaderInfo;
-	RESet<Shader*> shaders;
-	RESet<std::string> childFiles;
+	// a file has a handful of shaders and includers, a small array keeps them in the cache entry
+	RESmallArray<Shader*, 4> shaders;
+	RESmallArray<std::string, 4> childFiles;
+
+	void AddShader(Shader* shader) { AddUnique(shaders, shader); }
+	void RemoveShader(Shader* shader) { RemoveValue(shaders, shader); }
+	void AddChildFile(const std::string& childFile) { AddUnique(childFiles, childFile); }
+	void RemoveChildFile(const std::string& childFile) { RemoveValue(childFiles, childFile); }
+
+protected:
+	template<class TArray, class TValue>
+	static void AddUnique(TArray& values, const TValue& value)
+	{
+		if (std::find(values.begin(), values.end(), value) == values.end())
+			values.push_back(value);
+	}
+
+	template<class TArray, class TValue>
+	static void RemoveValue(TArray& values, const TValue& value)
+	{
+		auto it = std::find(values.begin(), values.end(), value);
+		if (it != values.end())
+			values.erase(it);
+	}
 };
 
 class ExpressionParser
@@ -392,7 +415,7 @@ static bool LoadShader(ShaderInfo& output, std::string path, int includeDepth =
 			// reload, un-register child files info
 			for (const auto& file : shaderFileInfo->shaderInfo.involvedFiles)
 			{
-				gShaderFileCache[file].childFiles.erase(fileName);
+				gShaderFileCache[file].RemoveChildFile(fileName);
 			}
 			// new shader info
 			it->second.shaderInfo = ShaderInfo();
@@ -615,7 +638,7 @@ static bool LoadShader(ShaderInfo& output, std::string path, int includeDepth =
 	for (const auto& file : localOutput.involvedFiles)
 	{
 		if(file != fileName)
-			gShaderFileCache[file].childFiles.insert(fileName);
+			gShaderFileCache[file].AddChildFile(fileName);
 	}
 
 #if DUMP_SHADER
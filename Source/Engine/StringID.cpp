@@ -0,0 +1,105 @@
+#include <cassert>
+#include <cstdio>
+
+#include "Containers/Containers.h"
+#include "JobSystem/Locks.h"
+
+#include "StringID.h"
+
+// IDs to interned strings, the strings live in blocks that are only freed at exit so c_str() stays valid
+struct StringIDTable
+{
+	static const size_t BLOCK_SIZE = 64 * 1024;
+
+	SpinLockReaderWriter lock;
+	REFlatMap<uint32_t, const char*> names;
+	REArray<char*> blocks;
+	size_t blockOffset = BLOCK_SIZE;
+
+	~StringIDTable()
+	{
+		for (int i = 0, ni = (int)blocks.size(); i < ni; ++i)
+			delete[] blocks[i];
+	}
+
+	const char* CopyString(const char* str, size_t size)
+	{
+		if (size > BLOCK_SIZE)
+		{
+			// longer than a block, gets its own
+			char* bigBlock = new char[size];
+			blocks.push_back(bigBlock);
+			memcpy(bigBlock, str, size);
+			return bigBlock;
+		}
+		if (blockOffset + size > BLOCK_SIZE)
+		{
+			blocks.push_back(new char[BLOCK_SIZE]);
+			blockOffset = 0;
+		}
+		char* copy = blocks.back() + blockOffset;
+		memcpy(copy, str, size);
+		blockOffset += size;
+		return copy;
+	}
+};
+
+// made on first use, IDs can be interned during static init
+static StringIDTable& GetStringIDTable()
+{
+	static StringIDTable table;
+	return table;
+}
+
+uint32_t StringID::Intern(const char* str)
+{
+	return Intern(str, HashStringID(str));
+}
+
+uint32_t StringID::Intern(const char* str, uint32_t hash)
+{
+	assert(hash == HashStringID(str));
+	StringIDTable& table = GetStringIDTable();
+
+	// nearly always there already
+	table.lock.LockReadOnly();
+	auto it = table.names.find(hash);
+	const char* internedName = (it != table.names.end()) ? it->second : 0;
+	table.lock.UnlockReadOnly();
+
+	if (!internedName)
+	{
+		table.lock.LockReadWrite();
+		const char*& name = table.names[hash];
+		if (!name)
+			name = table.CopyString(str, strlen(str) + 1);
+		internedName = name;
+		table.lock.UnlockReadWrite();
+	}
+
+	if (strcmp(internedName, str) != 0)
+	{
+		printf("StringID collision: \"%s\" and \"%s\" are both %08x\n", internedName, str, hash);
+		assert(false);
+	}
+	return hash;
+}
+
+const char* StringID::GetName(uint32_t id)
+{
+	StringIDTable& table = GetStringIDTable();
+	table.lock.LockReadOnly();
+	auto it = table.names.find(id);
+	const char* name = (it != table.names.end()) ? it->second : 0;
+	table.lock.UnlockReadOnly();
+	return name;
+}
+
+int StringID::GetInternedCount()
+{
+	StringIDTable& table = GetStringIDTable();
+	table.lock.LockReadOnly();
+	int count = (int)table.names.size();
+	table.lock.UnlockReadOnly();
+	return count;
+}
\ No newline at end of file
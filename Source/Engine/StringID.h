@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+// 32 bit name of a string (FNV-1a), compared and hashed as an integer
+// StringID("modelMat") hashes at run time and interns the string so c_str() can give it back
+// STRING_ID("modelMat") hashes at compile time and interns once per call site, use it for names in hot code
+// the hash is incremental, HashStringID(" child", parentID) is the ID of the parent's string followed by " child"
+// two strings with the same ID assert when the second one is interned
+
+static const uint32_t STRING_ID_OFFSET_BASIS = 2166136261u;
+static const uint32_t STRING_ID_PRIME = 16777619u;
+
+// one return statement, VS2015 constexpr, only meant for literals
+constexpr uint32_t HashStringIDConst(const char* str, uint32_t hash = STRING_ID_OFFSET_BASIS)
+{
+	return *str ? HashStringIDConst(str + 1, (hash ^ (uint32_t)(uint8_t)*str) * STRING_ID_PRIME) : hash;
+}
+
+inline uint32_t HashStringID(const char* str, uint32_t hash = STRING_ID_OFFSET_BASIS)
+{
+	for (; *str; ++str)
+		hash = (hash ^ (uint32_t)(uint8_t)*str) * STRING_ID_PRIME;
+	return hash;
+}
+
+struct StringID
+{
+	// 0 is no name
+	uint32_t id;
+
+	constexpr StringID() : id(0) {}
+	constexpr explicit StringID(uint32_t inID) : id(inID) {}
+	// interns, implicit so functions taking a StringID still take a string
+	StringID(const char* str) : id(Intern(str)) {}
+
+	bool IsNone() const { return id == 0; }
+	// the interned string, 0 for an ID whose string was never interned
+	const char* c_str() const { return GetName(id); }
+
+	bool operator==(const StringID& other) const { return id == other.id; }
+	bool operator!=(const StringID& other) const { return id != other.id; }
+	bool operator<(const StringID& other) const { return id < other.id; }
+
+	// every ID made through STRING_ID goes here once, the hash is a template argument so it's done by the compiler
+	template<uint32_t ID>
+	static StringID FromLiteral(const char* str)
+	{
+		static const uint32_t internedID = Intern(str, ID);
+		(void)internedID;
+		return StringID(ID);
+	}
+
+	// thread safe, the string is copied
+	static uint32_t Intern(const char* str);
+	// with the ID already hashed, when it was built incrementally
+	static uint32_t Intern(const char* str, uint32_t hash);
+	static const char* GetName(uint32_t id);
+	static int GetInternedCount();
+};
+
+#define STRING_ID(str) StringID::FromLiteral<std::integral_constant<uint32_t, HashStringIDConst(str)>::value>(str)
+
+namespace std
+{
+	template<>
+	struct hash<StringID>
+	{
+		// REFlatMap mixes the bits itself
+		size_t operator()(const StringID& stringID) const { return (size_t)stringID.id; }
+	};
+}
\ No newline at end of file
@@ -3,6 +3,8 @@
 // opengl
 #include "SDL_opengl.h"
 
+#include "Memory/Memory.h"
+
 class Texture
 {
 public:
@@ -17,6 +19,7 @@ public:
 		format = 0;
 		type = 0;
 		access = GL_READ_ONLY;
+		memoryTag = EMemoryTag::GPURenderTarget;
 		path[0] = 0;
 	}
 
@@ -35,5 +38,6 @@ public:
 	GLenum format;
 	GLenum type;
 	GLenum access; // used for image
+	EMemoryTag memoryTag; // what AllocateForFrameBuffer and Reallocate count it as, loaded textures are always GPUTexture
 	char path[256];
 };
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <string>
 
 #include "JobSystem/JobSystem.h"
+#include "GPUMemory.h"
 #include "Texture2D.h"
 
 REArray<Texture2D*> Texture2D::gContainer;
@@ -81,6 +82,7 @@ void Texture2D::Load(const char* name, bool bSRGB, GLint wrapS, GLint wrapT, GLi
 		glBindTexture(textureType, textureID);
 		glTexImage2D(textureType, 0, internalFormat, image->w, image->h, 0, format, type, image->pixels);
 		glGenerateMipmap(textureType);
+		TrackGLTexture(textureID, EMemoryTag::GPUTexture, GetTextureBytes(internalFormat, image->w, image->h, 1, true));
 		glTexParameteri(textureType, GL_TEXTURE_WRAP_S, wrapS);
 		glTexParameteri(textureType, GL_TEXTURE_WRAP_T, wrapT);
 		glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, minFilter);
@@ -104,6 +106,7 @@ void Texture2D::AllocateForFrameBuffer(int width, int height, GLint internalForm
 	glBindTexture(textureType, textureID);
 	if(width > 0 && height > 0)
 		glTexImage2D(textureType, 0, internalFormat, width, height, 0, format, type, NULL);
+	TrackGLTexture(textureID, memoryTag, GetTextureBytes(internalFormat, width, height));
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, bLinearFilter ? GL_LINEAR : GL_NEAREST);
@@ -123,5 +126,7 @@ void Texture2D::Reallocate(int width, int height)
 		this->height = height;
 		glBindTexture(textureType, textureID);
 		glTexImage2D(textureType, 0, internalFormat, width, height, 0, format, type, NULL);
+		// replaces the old size
+		TrackGLTexture(textureID, memoryTag, GetTextureBytes(internalFormat, width, height));
 	}
 }
\ No newline at end of file
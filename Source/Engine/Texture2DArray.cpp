@@ -6,6 +6,7 @@
 
 #include <string>
 
+#include "GPUMemory.h"
 #include "Texture2DArray.h"
 
 REArray<Texture2DArray*> Texture2DArray::gContainer;
@@ -26,6 +27,7 @@ void Texture2DArray::AllocateForFrameBuffer(int width, int height, int count, GL
 	{
 		glTexImage3D(textureType, 0, internalFormat, width, height, count, 0, format, type, NULL);
 	}
+	TrackGLTexture(textureID, memoryTag, GetTextureBytes(internalFormat, width, height, count));
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -42,5 +44,7 @@ void Texture2DArray::Reallocate(int width, int height, int count)
 		this->count = count;
 		glBindTexture(textureType, textureID);
 		glTexImage3D(textureType, 0, internalFormat, width, height, count, 0, format, type, NULL);
+		// replaces the old size
+		TrackGLTexture(textureID, memoryTag, GetTextureBytes(internalFormat, width, height, count));
 	}
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 #include <string>
 
+#include "GPUMemory.h"
 #include "TextureCube.h"
 
 REArray<TextureCube*> TextureCube::gContainer;
@@ -66,6 +67,7 @@ void TextureCube::Load(REArray<const char*> name, bool bSRGB, GLint wrapS, GLint
 	{
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, images[i]->w, images[i]->h, 0, format, type, images[i]->pixels);
 	}
+	TrackGLTexture(textureID, EMemoryTag::GPUTexture, GetTextureBytes(internalFormat, width, height, (int)images.size()));
 	//glGenerateMipmap(textureType);
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_S, wrapS);
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_T, wrapT);
@@ -96,6 +98,7 @@ void TextureCube::AllocateForFrameBuffer(int width, int height, GLint internalFo
 		for (int i = 0; i < 6; ++i)
 			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, width, height, 0, format, type, NULL);
 	}
+	TrackGLTexture(textureID, memoryTag, GetTextureBytes(internalFormat, width, height, 6));
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -112,5 +115,7 @@ void TextureCube::Reallocate(int width, int height)
 		glBindTexture(textureType, textureID);
 		for (int i = 0; i < 6; ++i)
 			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, width, height, 0, format, type, NULL);
+		// replaces the old size
+		TrackGLTexture(textureID, memoryTag, GetTextureBytes(internalFormat, width, height, 6));
 	}
 }
\ No newline at end of file
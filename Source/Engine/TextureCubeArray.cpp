@@ -6,6 +6,7 @@
 
 #include <string>
 
+#include "GPUMemory.h"
 #include "TextureCubeArray.h"
 
 REArray<TextureCubeArray*> TextureCubeArray::gContainer;
@@ -26,6 +27,7 @@ void TextureCubeArray::AllocateForFrameBuffer(int width, int height, int count,
 	{
 		glTexImage3D(textureType, 0, internalFormat, width, height, count * 6, 0, format, type, NULL);
 	}
+	TrackGLTexture(textureID, memoryTag, GetTextureBytes(internalFormat, width, height, count * 6));
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameteri(textureType, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -42,5 +44,7 @@ void TextureCubeArray::Reallocate(int width, int height, int count)
 		this->count = count;
 		glBindTexture(textureType, textureID);
 		glTexImage3D(textureType, 0, internalFormat, width, height, count * 6, 0, format, type, NULL);
+		// replaces the old size
+		TrackGLTexture(textureID, memoryTag, GetTextureBytes(internalFormat, width, height, count * 6));
 	}
 }
\ No newline at end of file
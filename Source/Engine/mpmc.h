@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "spsc.h"
+
+//http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+// every cell has a sequence number telling whose turn it is: pos for the producer of lap pos, pos + 1 for its consumer
+// producers and consumers only contend on their own position counter, never allocates after construction
+
+// multi-producer/multi-consumer bounded queue, capacity must be power of 2
+template<typename T>
+class mpmc_bounded_queue
+{
+public:
+	mpmc_bounded_queue(size_t buffer_size)
+		: buffer_(new cell[buffer_size])
+		, buffer_mask_(buffer_size - 1)
+	{
+		assert(buffer_size >= 2 && (buffer_size & (buffer_size - 1)) == 0);
+		for (size_t i = 0; i != buffer_size; ++i)
+			buffer_[i].sequence_.store(i, std::memory_order_relaxed);
+		enqueue_pos_.store(0, std::memory_order_relaxed);
+		dequeue_pos_.store(0, std::memory_order_relaxed);
+	}
+
+	~mpmc_bounded_queue()
+	{
+		delete[] buffer_;
+	}
+
+	// returns 'false' if queue is full
+	bool enqueue(T const& v)
+	{
+		cell* c;
+		size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			c = &buffer_[pos & buffer_mask_];
+			size_t seq = c->sequence_.load(std::memory_order_acquire);
+			intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+			if (dif == 0)
+			{
+				if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+				return false;
+			else
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+		}
+		c->value_ = v;
+		c->sequence_.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// returns 'false' if queue is empty
+	bool dequeue(T& v)
+	{
+		cell* c;
+		size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			c = &buffer_[pos & buffer_mask_];
+			size_t seq = c->sequence_.load(std::memory_order_acquire);
+			intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (dif == 0)
+			{
+				if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+				return false;
+			else
+				pos = dequeue_pos_.load(std::memory_order_relaxed);
+		}
+		v = c->value_;
+		c->sequence_.store(pos + buffer_mask_ + 1, std::memory_order_release);
+		return true;
+	}
+
+	// enqueues as many as fit in one go (one CAS for the whole run of free cells), returns how many
+	size_t enqueue_bulk(T const* values, size_t count)
+	{
+		size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+		size_t free_count;
+		for (;;)
+		{
+			// cells free for this lap, a cell only becomes free for a later lap once the position moved past it
+			free_count = 0;
+			while (free_count < count && free_count <= buffer_mask_)
+			{
+				size_t seq = buffer_[(pos + free_count) & buffer_mask_].sequence_.load(std::memory_order_acquire);
+				if (seq != pos + free_count)
+					break;
+				++free_count;
+			}
+			if (free_count == 0)
+			{
+				size_t seq = buffer_[pos & buffer_mask_].sequence_.load(std::memory_order_relaxed);
+				// full, or somebody else took this position already
+				if ((intptr_t)seq - (intptr_t)pos < 0)
+					return 0;
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+				continue;
+			}
+			if (enqueue_pos_.compare_exchange_weak(pos, pos + free_count, std::memory_order_relaxed))
+				break;
+		}
+		for (size_t i = 0; i != free_count; ++i)
+		{
+			cell* c = &buffer_[(pos + i) & buffer_mask_];
+			c->value_ = values[i];
+			c->sequence_.store(pos + i + 1, std::memory_order_release);
+		}
+		return free_count;
+	}
+
+	// dequeues up to max_count in one go, returns how many
+	size_t dequeue_bulk(T* values, size_t max_count)
+	{
+		size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+		size_t ready_count;
+		for (;;)
+		{
+			ready_count = 0;
+			while (ready_count < max_count && ready_count <= buffer_mask_)
+			{
+				size_t seq = buffer_[(pos + ready_count) & buffer_mask_].sequence_.load(std::memory_order_acquire);
+				if (seq != pos + ready_count + 1)
+					break;
+				++ready_count;
+			}
+			if (ready_count == 0)
+			{
+				size_t seq = buffer_[pos & buffer_mask_].sequence_.load(std::memory_order_relaxed);
+				// empty, or somebody else took this position already
+				if ((intptr_t)seq - (intptr_t)(pos + 1) < 0)
+					return 0;
+				pos = dequeue_pos_.load(std::memory_order_relaxed);
+				continue;
+			}
+			if (dequeue_pos_.compare_exchange_weak(pos, pos + ready_count, std::memory_order_relaxed))
+				break;
+		}
+		for (size_t i = 0; i != ready_count; ++i)
+		{
+			cell* c = &buffer_[(pos + i) & buffer_mask_];
+			values[i] = c->value_;
+			c->sequence_.store(pos + i + buffer_mask_ + 1, std::memory_order_release);
+		}
+		return ready_count;
+	}
+
+	size_t capacity() const
+	{
+		return buffer_mask_ + 1;
+	}
+
+private:
+	struct cell
+	{
+		std::atomic<size_t> sequence_;
+		T value_;
+	};
+
+	typedef char cache_line_pad_t[cache_line_size];
+
+	// producer and consumer positions on their own cache lines, away from the read-only part
+	cache_line_pad_t pad0_;
+	cell* const buffer_;
+	size_t const buffer_mask_;
+	cache_line_pad_t pad1_;
+	std::atomic<size_t> enqueue_pos_;
+	cache_line_pad_t pad2_;
+	std::atomic<size_t> dequeue_pos_;
+	cache_line_pad_t pad3_;
+
+	mpmc_bounded_queue(mpmc_bounded_queue const&);
+	mpmc_bounded_queue& operator = (mpmc_bounded_queue const&);
+};
\ No newline at end of file
@@ -1,27 +1,10 @@
 #pragma once
 
-#include <intrin.h>
+#include <atomic>
+#include <cstddef>
 
 //https://software.intel.com/en-us/articles/single-producer-single-consumer-queue
-
-// load with 'consume' (data-dependent) memory ordering
-template<typename T>
-T load_consume(T const* addr)
-{
-	// hardware fence is implicit on x86
-	T v = *const_cast<T const volatile*>(addr);
-	_ReadWriteBarrier(); // compiler fence
-	return v;
-}
-
-// store with 'release' memory ordering
-template<typename T>
-void store_release(T* addr, T v)
-{
-	// hardware fence is implicit on x86
-	_ReadWriteBarrier(); // compiler fence
-	*const_cast<T volatile*>(addr) = v;
-}
+// links are std::atomic, acquire/release compile to plain loads and stores on x86 like the original compiler fences
 
 // cache line size on modern x86 processors (in bytes)
 size_t const cache_line_size = 64;
@@ -34,8 +17,9 @@ public:
 	spsc_queue()
 	{
 		node* n = new node;
-		n->next_ = 0;
-		tail_ = head_ = first_ = tail_copy_ = n;
+		n->next_.store(0, std::memory_order_relaxed);
+		tail_.store(n, std::memory_order_relaxed);
+		head_ = first_ = tail_copy_ = n;
 	}
 
 	~spsc_queue()
@@ -43,7 +27,7 @@ public:
 		node* n = first_;
 		do
 		{
-			node* next = n->next_;
+			node* next = n->next_.load(std::memory_order_relaxed);
 			delete n;
 			n = next;
 		} while (n);
@@ -52,19 +36,22 @@ public:
 	void enqueue(T v)
 	{
 		node* n = alloc_node();
-		n->next_ = 0;
+		n->next_.store(0, std::memory_order_relaxed);
 		n->value_ = v;
-		store_release(&head_->next_, n);
+		head_->next_.store(n, std::memory_order_release);
 		head_ = n;
 	}
 
 	// returns 'false' if queue is empty
 	bool dequeue(T& v)
 	{
-		if (load_consume(&tail_->next_))
+		node* tail = tail_.load(std::memory_order_relaxed);
+		node* next = tail->next_.load(std::memory_order_acquire);
+		if (next)
 		{
-			v = tail_->next_->value_;
-			store_release(&tail_, tail_->next_);
+			v = next->value_;
+			// producer reuses the node once it sees this
+			tail_.store(next, std::memory_order_release);
 			return true;
 		}
 		else
@@ -77,13 +64,13 @@ private:
 	// internal node structure
 	struct node
 	{
-		node* next_;
+		std::atomic<node*> next_;
 		T value_;
 	};
 
 	// consumer part
 	// accessed mainly by consumer, infrequently be producer
-	node* tail_; // tail of the queue
+	std::atomic<node*> tail_; // tail of the queue
 
 				 // delimiter between consumer part and producer part,
 				 // so that they situated on different cache lines
@@ -103,14 +90,14 @@ private:
 		if (first_ != tail_copy_)
 		{
 			node* n = first_;
-			first_ = first_->next_;
+			first_ = first_->next_.load(std::memory_order_relaxed);
 			return n;
 		}
-		tail_copy_ = load_consume(&tail_);
+		tail_copy_ = tail_.load(std::memory_order_acquire);
 		if (first_ != tail_copy_)
 		{
 			node* n = first_;
-			first_ = first_->next_;
+			first_ = first_->next_.load(std::memory_order_relaxed);
 			return n;
 		}
 		node* n = new node;
@@ -0,0 +1,288 @@
+#include <cassert>
+#include <cstdint>
+#include <thread>
+
+#include "Fiber.h"
+
+#if FIBER_BACKEND == FIBER_BACKEND_WIN32
+#include "Windows.h"
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#if FIBER_BACKEND == FIBER_BACKEND_UCONTEXT
+#include <ucontext.h>
+#endif
+#endif
+
+struct JobFiber
+{
+	FiberEntryPoint entryPoint = 0;
+	void* dataPtr = 0;
+
+#if FIBER_BACKEND == FIBER_BACKEND_WIN32
+	void* handle = 0;
+#else
+	// mmap'd stack including the guard page, 0 for converted threads
+	void* stackMemory = 0;
+	size_t stackMemorySize = 0;
+#if FIBER_BACKEND == FIBER_BACKEND_ASM
+	// saved stack pointer, everything else is pushed on the stack
+	void* stackPtr = 0;
+#else
+	ucontext_t context;
+#endif
+#endif
+};
+
+#if FIBER_BACKEND == FIBER_BACKEND_WIN32
+
+void __stdcall JobFiberStart(void* lpParameter)
+{
+	JobFiber* fiber = (JobFiber*)lpParameter;
+	fiber->entryPoint(fiber->dataPtr);
+	// entry point should never return
+	assert(false);
+}
+
+JobFiber* ConvertThreadToJobFiber(void* fiberDataPtr)
+{
+	JobFiber* fiber = new JobFiber();
+	fiber->dataPtr = fiberDataPtr;
+	fiber->handle = ConvertThreadToFiber(fiber);
+	assert(fiber->handle);
+	return fiber;
+}
+
+void ConvertJobFiberToThread()
+{
+	JobFiber* fiber = GetCurrentJobFiber();
+	ConvertFiberToThread();
+	delete fiber;
+}
+
+JobFiber* CreateJobFiber(size_t stackSize, FiberEntryPoint entryPoint, void* fiberDataPtr)
+{
+	JobFiber* fiber = new JobFiber();
+	fiber->entryPoint = entryPoint;
+	fiber->dataPtr = fiberDataPtr;
+	// reserve only what we asked for, commit grows on demand (CreateFiber would reserve the default 1MB for every fiber)
+	fiber->handle = CreateFiberEx(0, stackSize, 0, &JobFiberStart, fiber);
+	assert(fiber->handle);
+	return fiber;
+}
+
+void DeleteJobFiber(JobFiber* fiber)
+{
+	DeleteFiber(fiber->handle);
+	delete fiber;
+}
+
+void SwitchToJobFiber(JobFiber* fiber)
+{
+	SwitchToFiber(fiber->handle);
+}
+
+RE_NOINLINE JobFiber* GetCurrentJobFiber()
+{
+	return (JobFiber*)GetFiberData();
+}
+
+RE_NOINLINE void* GetCurrentJobFiberData()
+{
+	return GetCurrentJobFiber()->dataPtr;
+}
+
+void SetCurrentThreadAffinity(int coreIndex)
+{
+	SetThreadAffinityMask(GetCurrentThread(), 1ull << coreIndex);
+}
+
+#else
+
+thread_local JobFiber* tlsCurrentJobFiber = 0;
+
+void* AllocateFiberStack(size_t stackSize, size_t& outMemorySize)
+{
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	stackSize = (stackSize + pageSize - 1) & ~(pageSize - 1);
+	// one extra page at the bottom as guard, stack overflow will fault instead of corrupting memory
+	outMemorySize = stackSize + pageSize;
+	void* memory = mmap(0, outMemorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+	assert(memory != MAP_FAILED);
+	mprotect(memory, pageSize, PROT_NONE);
+	return memory;
+}
+
+#if FIBER_BACKEND == FIBER_BACKEND_ASM
+
+// void JobFiberSwitchContext(void** fromStackPtr, void* toStackPtr)
+// push callee saved registers and fp control words on the current stack, save stack pointer, then do the reverse on the new stack
+// JobFiberTrampoline is the first return address of a new fiber, r12 = start function, r13 = fiber
+extern "C" void JobFiberSwitchContext(void** fromStackPtr, void* toStackPtr);
+extern "C" void JobFiberTrampoline();
+
+asm(R"(
+	.pushsection .text
+	.globl JobFiberSwitchContext
+	.type JobFiberSwitchContext, @function
+	.p2align 4
+JobFiberSwitchContext:
+	pushq %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	subq $8, %rsp
+	stmxcsr (%rsp)
+	fnstcw 4(%rsp)
+	movq %rsp, (%rdi)
+	movq %rsi, %rsp
+	ldmxcsr (%rsp)
+	fldcw 4(%rsp)
+	addq $8, %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size JobFiberSwitchContext, .-JobFiberSwitchContext
+
+	.globl JobFiberTrampoline
+	.type JobFiberTrampoline, @function
+	.p2align 4
+JobFiberTrampoline:
+	movq %r13, %rdi
+	andq $-16, %rsp
+	callq *%r12
+	ud2
+	.size JobFiberTrampoline, .-JobFiberTrampoline
+	.popsection
+)");
+
+extern "C" void JobFiberStart(JobFiber* fiber)
+{
+	fiber->entryPoint(fiber->dataPtr);
+	// entry point should never return
+	assert(false);
+}
+
+void InitFiberContext(JobFiber* fiber)
+{
+	// build the frame JobFiberSwitchContext expects to pop
+	uintptr_t stackTop = ((uintptr_t)fiber->stackMemory + fiber->stackMemorySize) & ~(uintptr_t)15;
+	uint64_t* frame = (uint64_t*)stackTop;
+	*--frame = 0;											// fake return address of the trampoline
+	*--frame = (uint64_t)(uintptr_t)&JobFiberTrampoline;	// return address
+	*--frame = 0;											// rbp
+	*--frame = 0;											// rbx
+	*--frame = (uint64_t)(uintptr_t)&JobFiberStart;			// r12
+	*--frame = (uint64_t)(uintptr_t)fiber;					// r13
+	*--frame = 0;											// r14
+	*--frame = 0;											// r15
+	*--frame = 0x1F80ull | (0x037Full << 32);				// mxcsr, x87 control word (defaults)
+	fiber->stackPtr = frame;
+}
+
+void SwitchFiberContext(JobFiber* fromFiber, JobFiber* toFiber)
+{
+	JobFiberSwitchContext(&fromFiber->stackPtr, toFiber->stackPtr);
+}
+
+#else
+
+void JobFiberStart(unsigned int fiberPtrHigh, unsigned int fiberPtrLow)
+{
+	// makecontext only passes int arguments
+	JobFiber* fiber = (JobFiber*)(((uintptr_t)fiberPtrHigh << 32) | (uintptr_t)fiberPtrLow);
+	fiber->entryPoint(fiber->dataPtr);
+	// entry point should never return
+	assert(false);
+}
+
+void InitFiberContext(JobFiber* fiber)
+{
+	getcontext(&fiber->context);
+	fiber->context.uc_stack.ss_sp = (char*)fiber->stackMemory;
+	fiber->context.uc_stack.ss_size = fiber->stackMemorySize;
+	fiber->context.uc_link = 0;
+	uintptr_t fiberPtr = (uintptr_t)fiber;
+	makecontext(&fiber->context, (void(*)())&JobFiberStart, 2, (unsigned int)(fiberPtr >> 32), (unsigned int)fiberPtr);
+}
+
+void SwitchFiberContext(JobFiber* fromFiber, JobFiber* toFiber)
+{
+	swapcontext(&fromFiber->context, &toFiber->context);
+}
+
+#endif
+
+JobFiber* ConvertThreadToJobFiber(void* fiberDataPtr)
+{
+	assert(!tlsCurrentJobFiber);
+	// context is filled in the first time we switch away
+	JobFiber* fiber = new JobFiber();
+	fiber->dataPtr = fiberDataPtr;
+	tlsCurrentJobFiber = fiber;
+	return fiber;
+}
+
+void ConvertJobFiberToThread()
+{
+	JobFiber* fiber = GetCurrentJobFiber();
+	assert(fiber && !fiber->stackMemory);
+	tlsCurrentJobFiber = 0;
+	delete fiber;
+}
+
+JobFiber* CreateJobFiber(size_t stackSize, FiberEntryPoint entryPoint, void* fiberDataPtr)
+{
+	JobFiber* fiber = new JobFiber();
+	fiber->entryPoint = entryPoint;
+	fiber->dataPtr = fiberDataPtr;
+	fiber->stackMemory = AllocateFiberStack(stackSize ? stackSize : gDefaultFiberStackSize, fiber->stackMemorySize);
+	InitFiberContext(fiber);
+	return fiber;
+}
+
+void DeleteJobFiber(JobFiber* fiber)
+{
+	assert(fiber != GetCurrentJobFiber());
+	if (fiber->stackMemory)
+		munmap(fiber->stackMemory, fiber->stackMemorySize);
+	delete fiber;
+}
+
+void SwitchToJobFiber(JobFiber* fiber)
+{
+	JobFiber* currentFiber = GetCurrentJobFiber();
+	assert(currentFiber && currentFiber != fiber);
+	// whoever we switch to runs on this thread now, we might be resumed on a different one
+	tlsCurrentJobFiber = fiber;
+	SwitchFiberContext(currentFiber, fiber);
+}
+
+RE_NOINLINE JobFiber* GetCurrentJobFiber()
+{
+	return tlsCurrentJobFiber;
+}
+
+RE_NOINLINE void* GetCurrentJobFiberData()
+{
+	JobFiber* fiber = GetCurrentJobFiber();
+	return fiber ? fiber->dataPtr : 0;
+}
+
+void SetCurrentThreadAffinity(int coreIndex)
+{
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(coreIndex, &cpuSet);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+}
+
+#endif
\ No newline at end of file
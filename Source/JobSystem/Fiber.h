@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Platform/Platform.h"
+
+// fiber backends, select one with FIBER_BACKEND in preprocessor definitions, or leave it to the platform default
+// win32: ConvertThreadToFiber/CreateFiber/SwitchToFiber
+// asm: hand written x86-64 System V context switch with mmap'd stacks
+// ucontext: getcontext/makecontext/swapcontext with mmap'd stacks, slower (saves signal mask with a syscall)
+#define FIBER_BACKEND_WIN32 1
+#define FIBER_BACKEND_ASM 2
+#define FIBER_BACKEND_UCONTEXT 3
+
+#ifndef FIBER_BACKEND
+#if defined(_WIN32)
+#define FIBER_BACKEND FIBER_BACKEND_WIN32
+#elif defined(__x86_64__)
+#define FIBER_BACKEND FIBER_BACKEND_ASM
+#else
+#define FIBER_BACKEND FIBER_BACKEND_UCONTEXT
+#endif
+#endif
+
+#if FIBER_BACKEND == FIBER_BACKEND_WIN32
+#define FIBER_BACKEND_NAME "win32"
+#elif FIBER_BACKEND == FIBER_BACKEND_ASM
+#define FIBER_BACKEND_NAME "asm"
+#elif FIBER_BACKEND == FIBER_BACKEND_UCONTEXT
+#define FIBER_BACKEND_NAME "ucontext"
+#else
+#error "unknown FIBER_BACKEND"
+#endif
+
+// used when stackSize is 0, same as the default Win32 fiber stack reserve
+const size_t gDefaultFiberStackSize = 1024 * 1024;
+
+typedef void(*FiberEntryPoint)(void* fiberDataPtr);
+
+// opaque fiber handle
+struct JobFiber;
+
+// current thread becomes a fiber so it can switch to other fibers
+extern JobFiber* ConvertThreadToJobFiber(void* fiberDataPtr);
+// must be called on the converted thread after switching back to its own fiber
+extern void ConvertJobFiberToThread();
+
+// entry point must never return, switch to another fiber instead
+extern JobFiber* CreateJobFiber(size_t stackSize, FiberEntryPoint entryPoint, void* fiberDataPtr);
+// never delete the running fiber
+extern void DeleteJobFiber(JobFiber* fiber);
+
+extern void SwitchToJobFiber(JobFiber* fiber);
+
+// fibers can move between threads, these always read the current thread state (never inlined)
+extern JobFiber* GetCurrentJobFiber();
+extern void* GetCurrentJobFiberData();
+
+extern void SetCurrentThreadAffinity(int coreIndex);
\ No newline at end of file
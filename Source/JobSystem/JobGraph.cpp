@@ -0,0 +1,117 @@
+#include "JobGraph.h"
+
+JobGraph::~JobGraph()
+{
+	Clear();
+}
+
+int JobGraph::AddNode(const JobDescriptor& jobDesc)
+{
+	assert(jobDesc.entryPoint);
+	Node* node = new Node();
+	node->jobDesc = jobDesc;
+	node->jobDesc.counterPtr = 0;
+	node->graph = this;
+	nodes.push_back(node);
+	bValidated = false;
+	return (int)nodes.size() - 1;
+}
+
+void JobGraph::AddDependency(int node, int dependencyNode)
+{
+	assert(node >= 0 && node < (int)nodes.size());
+	assert(dependencyNode >= 0 && dependencyNode < (int)nodes.size());
+	assert(node != dependencyNode);
+	nodes[dependencyNode]->successors.push_back(node);
+	++nodes[node]->dependencyCount;
+	bValidated = false;
+}
+
+void JobGraph::Clear()
+{
+	for (int i = 0, ni = (int)nodes.size(); i < ni; ++i)
+	{
+		delete nodes[i];
+	}
+	nodes.clear();
+	bValidated = false;
+}
+
+bool JobGraph::HasCycle() const
+{
+	// Kahn's algorithm, every node is visited once if there is no cycle
+	REArray<int> pendingCounts(nodes.size());
+	REArray<int> readyNodes;
+	for (int i = 0, ni = (int)nodes.size(); i < ni; ++i)
+	{
+		pendingCounts[i] = nodes[i]->dependencyCount;
+		if (pendingCounts[i] == 0)
+			readyNodes.push_back(i);
+	}
+
+	int visitedCount = 0;
+	while (!readyNodes.empty())
+	{
+		int nodeIndex = readyNodes.back();
+		readyNodes.pop_back();
+		++visitedCount;
+		const REArray<int>& successors = nodes[nodeIndex]->successors;
+		for (int i = 0, ni = (int)successors.size(); i < ni; ++i)
+		{
+			if (--pendingCounts[successors[i]] == 0)
+				readyNodes.push_back(successors[i]);
+		}
+	}
+	return visitedCount != (int)nodes.size();
+}
+
+void JobGraph::Run(JobWaitingCounter* waitingCounterPtr)
+{
+	if (!bValidated)
+	{
+		assert(!HasCycle());
+		bValidated = true;
+	}
+
+	counterPtr = waitingCounterPtr;
+	for (int i = 0, ni = (int)nodes.size(); i < ni; ++i)
+	{
+		nodes[i]->pendingCount.store(nodes[i]->dependencyCount, std::memory_order_relaxed);
+	}
+
+	// hold the counter, a root can finish before we push the next one
+	if (counterPtr)
+		counterPtr->Add(1);
+
+	for (int i = 0, ni = (int)nodes.size(); i < ni; ++i)
+	{
+		if (nodes[i]->dependencyCount == 0)
+			LaunchNode(nodes[i]);
+	}
+
+	if (counterPtr)
+		counterPtr->Sub(1);
+}
+
+void JobGraph::LaunchNode(Node* node)
+{
+	JobDescriptor jobDesc = node->jobDesc;
+	jobDesc.entryPoint = &JobGraph::RunNode;
+	jobDesc.dataPtr = node;
+	RunJobs(&jobDesc, 1, node->graph->counterPtr);
+}
+
+JOB_ENTRY_POINT(JobGraph::RunNode)
+{
+	Node* node = (Node*)customDataPtr;
+	node->jobDesc.entryPoint(node->jobDesc.dataPtr);
+
+	// successors are added to the counter before this job subtracts itself, so it never hits 0 early
+	JobGraph* graph = node->graph;
+	for (int i = 0, ni = (int)node->successors.size(); i < ni; ++i)
+	{
+		Node* successor = graph->nodes[node->successors[i]];
+		if (successor->pendingCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			graph->LaunchNode(successor);
+	}
+}
\ No newline at end of file
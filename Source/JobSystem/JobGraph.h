@@ -0,0 +1,48 @@
+#pragma once
+
+#include "JobSystem.h"
+
+// static dependency graph of jobs, built once and run as many times as needed (e.g. once per frame)
+// a node is pushed by whichever job finishes its last dependency, so no fiber waits on a counter in between
+class JobGraph
+{
+public:
+	JobGraph() {}
+	~JobGraph();
+
+	// returns node index, priority and stackSize of the descriptor are kept (render nodes still go to render processor)
+	int AddNode(const JobDescriptor& jobDesc);
+	// node won't start before dependencyNode is done
+	void AddDependency(int node, int dependencyNode);
+	void Clear();
+
+	// push every node without dependencies, waitingCounterPtr reaches 0 when all nodes are done
+	// graph must not be changed or run again before that
+	void Run(JobWaitingCounter* waitingCounterPtr);
+
+	__forceinline int GetNodeCount() const { return (int)nodes.size(); }
+
+protected:
+	struct Node
+	{
+		JobDescriptor jobDesc;
+		REArray<int> successors;
+		int dependencyCount = 0;
+		// reset to dependencyCount on each run
+		std::atomic<int> pendingCount{ 0 };
+		JobGraph* graph = 0;
+	};
+
+	JOB_METHOD_ENTRY_POINT(RunNode);
+	void LaunchNode(Node* node);
+	bool HasCycle() const;
+
+	// nodes are allocated one by one, job data pointer must stay valid while adding nodes
+	REArray<Node*> nodes;
+	JobWaitingCounter* counterPtr = 0;
+	bool bValidated = false;
+
+private:
+	JobGraph(const JobGraph&);
+	JobGraph& operator=(const JobGraph&);
+};
\ No newline at end of file
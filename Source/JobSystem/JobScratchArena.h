@@ -0,0 +1,256 @@
+#pragma once
+
+#include <cstdint>
+#include <cassert>
+#include <new>
+
+#include "Containers/Containers.h"
+
+// linear allocator every job fiber carries, allocating is a pointer bump and nothing is freed one by one
+// the job system resets it when the fiber's job finishes, memory must not outlive the job that allocated it
+// blocks are kept between jobs, if a job needed more than one they are merged into one big block on reset
+class JobScratchArena
+{
+public:
+	// position to rewind to, see JobScratchScope
+	struct Marker
+	{
+		int blockIndex;
+		size_t offset;
+	};
+
+	static const size_t DEFAULT_BLOCK_SIZE = 16 * 1024;
+
+	~JobScratchArena()
+	{
+		Release();
+	}
+
+	__forceinline void* Allocate(size_t size, size_t alignment)
+	{
+		if (blockIndex < (int)blocks.size())
+		{
+			Block& block = blocks[blockIndex];
+			uintptr_t ptr = ((uintptr_t)block.memory + offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			if (ptr + size <= (uintptr_t)block.memory + block.size)
+			{
+				offset = ptr + size - (uintptr_t)block.memory;
+				return (void*)ptr;
+			}
+		}
+		return AllocateSlow(size, alignment);
+	}
+
+	// only the last allocation gives its memory back (a growing array freeing its old buffer usually isn't)
+	__forceinline void Free(void* ptr, size_t size)
+	{
+		if (blockIndex < (int)blocks.size() && (char*)ptr + size == blocks[blockIndex].memory + offset)
+			offset = (char*)ptr - blocks[blockIndex].memory;
+	}
+
+	// make sure the first block holds at least size bytes
+	void Reserve(size_t size)
+	{
+		if (blocks.empty())
+			AddBlock(size);
+	}
+
+	Marker GetMarker() const
+	{
+		Marker marker;
+		marker.blockIndex = blockIndex;
+		marker.offset = offset;
+		return marker;
+	}
+
+	// everything allocated after the marker is gone
+	void Rewind(const Marker& marker)
+	{
+		assert(marker.blockIndex <= blockIndex);
+		blockIndex = marker.blockIndex;
+		offset = marker.offset;
+	}
+
+	void Reset()
+	{
+		if (blocks.size() > 1)
+		{
+			// next job that needs as much fits in one block
+			size_t totalSize = 0;
+			for (int i = 0, ni = (int)blocks.size(); i < ni; ++i)
+				totalSize += blocks[i].size;
+			Release();
+			AddBlock(totalSize);
+		}
+		blockIndex = 0;
+		offset = 0;
+	}
+
+	void Release()
+	{
+		for (int i = 0, ni = (int)blocks.size(); i < ni; ++i)
+			::operator delete(blocks[i].memory);
+		blocks.clear();
+		blockIndex = 0;
+		offset = 0;
+	}
+
+	size_t GetCapacity() const
+	{
+		size_t capacity = 0;
+		for (int i = 0, ni = (int)blocks.size(); i < ni; ++i)
+			capacity += blocks[i].size;
+		return capacity;
+	}
+
+protected:
+	struct Block
+	{
+		char* memory;
+		size_t size;
+	};
+
+	RE_NOINLINE void* AllocateSlow(size_t size, size_t alignment)
+	{
+		// try blocks we already have (kept after a rewind), then add one
+		while (blockIndex + 1 < (int)blocks.size())
+		{
+			++blockIndex;
+			offset = 0;
+			Block& block = blocks[blockIndex];
+			uintptr_t ptr = ((uintptr_t)block.memory + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			if (ptr + size <= (uintptr_t)block.memory + block.size)
+			{
+				offset = ptr + size - (uintptr_t)block.memory;
+				return (void*)ptr;
+			}
+		}
+
+		size_t blockSize = blocks.empty() ? DEFAULT_BLOCK_SIZE : blocks.back().size * 2;
+		if (blockSize < size + alignment)
+			blockSize = size + alignment;
+		AddBlock(blockSize);
+		blockIndex = (int)blocks.size() - 1;
+		offset = 0;
+		return Allocate(size, alignment);
+	}
+
+	void AddBlock(size_t size)
+	{
+		Block block;
+		block.memory = (char*)::operator new(size);
+		block.size = size;
+		blocks.push_back(block);
+	}
+
+	REArray<Block> blocks;
+	int blockIndex = 0;
+	size_t offset = 0;
+};
+
+// arena of the job running on this thread, 0 outside of job fibers
+extern JobScratchArena* GetCurrentJobScratchArena();
+
+// for jobs that run for a long time (a loop that never returns), rewinds the arena when it goes out of scope
+class JobScratchScope
+{
+public:
+	JobScratchScope() : arenaPtr(GetCurrentJobScratchArena())
+	{
+		if (arenaPtr)
+			marker = arenaPtr->GetMarker();
+	}
+
+	~JobScratchScope()
+	{
+		if (arenaPtr)
+			arenaPtr->Rewind(marker);
+	}
+
+private:
+	JobScratchScope(const JobScratchScope&);
+	JobScratchScope& operator=(const JobScratchScope&);
+
+	JobScratchArena* arenaPtr;
+	JobScratchArena::Marker marker;
+};
+
+// allocator for containers of temporaries, draws from the arena of the job that constructed the container
+// falls back to the heap outside of job fibers, the container must not outlive the job (or the JobScratchScope)
+template<class T, int Alignment = 0>
+class REScratchAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	// every container holds its own arena, never move memory between two of them
+	typedef std::false_type propagate_on_container_copy_assignment;
+	typedef std::false_type propagate_on_container_move_assignment;
+	typedef std::false_type propagate_on_container_swap;
+	typedef std::false_type is_always_equal;
+
+	template<class TOther>
+	struct rebind
+	{
+		typedef REScratchAllocator<TOther, Alignment> other;
+	};
+
+	REScratchAllocator() noexcept : arenaPtr(GetCurrentJobScratchArena()) {}
+
+	explicit REScratchAllocator(JobScratchArena* inArenaPtr) noexcept : arenaPtr(inArenaPtr) {}
+
+	template<class TOther>
+	REScratchAllocator(const REScratchAllocator<TOther, Alignment>& other) noexcept : arenaPtr(other.arenaPtr) {}
+
+	// a copied container allocates from the arena of whoever copies it
+	REScratchAllocator select_on_container_copy_construction() const
+	{
+		return REScratchAllocator();
+	}
+
+	RE_DECLSPEC_ALLOCATOR pointer allocate(size_type count)
+	{
+		if ((size_t)(-1) / sizeof(T) < count)
+			throw std::bad_alloc();
+		if (arenaPtr)
+			return (pointer)arenaPtr->Allocate(count * sizeof(T), GetAlignment());
+		return (pointer)_Aligned_Allocate(count, sizeof(T), GetAlignment());
+	}
+
+	void deallocate(pointer ptr, size_type count)
+	{
+		if (arenaPtr)
+			arenaPtr->Free(ptr, count * sizeof(T));
+		else
+			_Aligned_Deallocate(ptr);
+	}
+
+	static size_t GetAlignment()
+	{
+		return (Alignment > (int)alignof(T)) ? (size_t)Alignment : alignof(T);
+	}
+
+	JobScratchArena* arenaPtr;
+};
+
+template<class T, class TOther, int Alignment> inline
+bool operator==(const REScratchAllocator<T, Alignment>& left, const REScratchAllocator<TOther, Alignment>& right) noexcept
+{
+	return left.arenaPtr == right.arenaPtr;
+}
+
+template<class T, class TOther, int Alignment> inline
+bool operator!=(const REScratchAllocator<T, Alignment>& left, const REScratchAllocator<TOther, Alignment>& right) noexcept
+{
+	return left.arenaPtr != right.arenaPtr;
+}
+
+// REArray of temporaries for a job, same alignment parameter
+template<class T, int Alignment = 0>
+using REScratchArray = std::vector<T, REScratchAllocator<T, Alignment>>;
\ No newline at end of file
@@ -1,25 +1,46 @@
 
 #include <stdlib.h>
 #include <cassert>
-#include "Windows.h"
+#include <cstdio>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
 
 #include "Locks.h"
+#include "Fiber.h"
+#include "WorkStealingQueue.h"
 #include "JobSystem.h"
+#include "JobTrace.h"
 
 struct JobFiberData
 {
+	// fiber handle and stack class, fixed for the fiber's lifetime
+	JobFiber* fiber = 0;
+	int stackClass = 0;
+	// converted worker thread, never in a pool
+	bool bThreadFiber = false;
+	// link for counter waiting list and ready queue, a fiber is only in one of them at a time
+	JobFiberData* nextWaitingFiber = 0;
+
 	JobEntryPoint jobEntryPoint = 0;
 	void* jobDataPtr = 0;
-	void* prevFiber;
-	JobFiberData* prevFiberDataPtr;
+	JobFiber* prevFiber = 0;
+	JobFiberData* prevFiberDataPtr = 0;
 	JobWaitingCounter* counterPtr = 0;
 	JobWaitingCounter* waitingCounterPtr = 0;
 	int waitingCounterTarget = 0;
 	int currentProcessor = 0;
 	int fixedProcessor = -1; // -1 means not fixed
+	EJobPriority jobPriority = EJobPriority::Normal;
+	JobCancellationToken* cancellationTokenPtr = 0;
+	// switched out by JobYield, queued again once the next fiber is running
+	bool bYielding = false;
+	// temporaries of the running job, reset when it finishes, keeps its blocks for the next job
+	JobScratchArena scratchArena;
 
 	void Reset()
 	{
+		nextWaitingFiber = 0;
 		jobEntryPoint = 0;
 		jobDataPtr = 0;
 		prevFiber = 0;
@@ -29,39 +50,323 @@ struct JobFiberData
 		waitingCounterTarget = 0;
 		currentProcessor = 0;
 		fixedProcessor = -1;
+		jobPriority = EJobPriority::Normal;
+		cancellationTokenPtr = 0;
+		bYielding = false;
 	}
 };
 
+// payload blocks are linked through their first bytes while free
+union JobPayloadBlock
+{
+	JobPayloadBlock* next;
+	alignas(gJobPayloadAlignment) char data[gJobPayloadSize];
+};
+
 struct JobFiberListData
 {
-	void* fiber = 0;
+	JobFiber* fiber = 0;
 	JobFiberData* fiberDataPtr = 0;
 };
 
+// spin-then-park state of a worker, see ParkWorker and UnparkWorker
+struct JobWorkerIdleState
+{
+	std::mutex mutex;
+	std::condition_variable condition;
+	// protected by mutex
+	bool bWakeRequested = false;
+	// set under gIdleWorkerLock, read without it for a cheap check
+	std::atomic<bool> bIdle = false;
+
+	// metrics
+	std::atomic<int64_t> wakeRequestTime = 0;
+	std::atomic<int64_t> idleTimeNs = 0;
+	std::atomic<int64_t> wakeCount = 0;
+	std::atomic<int64_t> totalWakeLatencyNs = 0;
+	std::atomic<int64_t> maxWakeLatencyNs = 0;
+};
+
+// per priority stats, only the owning worker writes them (see AddJobStat), GetJobPriorityStats sums them up
+struct JobPriorityCounters
+{
+	std::atomic<int64_t> pushCount;
+	std::atomic<int64_t> popCount;
+	std::atomic<int64_t> cancelCount;
+	std::atomic<int64_t> totalWaitTimeNs;
+	std::atomic<int64_t> maxWaitTimeNs;
+	std::atomic<int64_t> waitTimeHistogram[gJobStatsHistogramBucketCount];
+	std::atomic<int64_t> queueDepthHistogram[gJobStatsHistogramBucketCount];
+
+	void Reset()
+	{
+		pushCount = 0;
+		popCount = 0;
+		cancelCount = 0;
+		totalWaitTimeNs = 0;
+		maxWaitTimeNs = 0;
+		for (int i = 0; i < gJobStatsHistogramBucketCount; ++i)
+		{
+			waitTimeHistogram[i] = 0;
+			queueDepthHistogram[i] = 0;
+		}
+	}
+};
+
+struct JobWorkerMailbox;
+
 class JobSystemWorker
 {
 public:
-	void Start(int inCoreIndex);
+	void Init(int inProcessorIndex);
+	void Release();
+	void Start();
 	void Run();
 	void Stop();
 
+	__forceinline unsigned int NextRandom()
+	{
+		// xorshift32, only used to pick steal victims
+		randomState ^= randomState << 13;
+		randomState ^= randomState >> 17;
+		randomState ^= randomState << 5;
+		return randomState;
+	}
+
+	// one deque per priority, only this worker pushes/pops, other workers steal
+	WorkStealingQueue<JobDescriptor>* jobQueues = 0;
+	unsigned int randomState = 1;
+	// weighted round robin state, see PopNextJob
+	int priorityTurn = 0;
+	int priorityTurnCredits = 0;
+
+	JobWorkerIdleState* idleState = 0;
+	// jobs and fibers that can only run on this worker
+	JobWorkerMailbox* mailbox = 0;
+	// one per priority, EJobPriority::Render included
+	JobPriorityCounters* priorityCounters = 0;
+
+	// free payload blocks only this worker touches, balanced against gJobPayloadFreeList
+	JobPayloadBlock* payloadFreeList = 0;
+	int payloadFreeCount = 0;
+
 	std::thread* threadPtr = 0;
-	void* fiber = 0;
+	JobFiber* fiber = 0;
+	// data of the converted thread fiber, it only runs to park the thread for a waiting fiber, or on shutdown
+	JobFiberData threadFiberData;
 	int processorIndex = 0;
 };
 
-bool bJobSystemRuning = false;
+// growable ring buffer, REQueue (std::deque) allocates as it moves through its blocks
+// not thread safe, guarded by the queue locks below
+class JobDescriptorRing
+{
+public:
+	void Push(const JobDescriptor& jobDesc)
+	{
+		if (count == (int)buffer.size())
+			Grow();
+		buffer[(head + count) & ((int)buffer.size() - 1)] = jobDesc;
+		++count;
+	}
+
+	bool Pop(JobDescriptor& outJobDesc)
+	{
+		if (count == 0)
+			return false;
+		outJobDesc = buffer[head];
+		head = (head + 1) & ((int)buffer.size() - 1);
+		--count;
+		return true;
+	}
+
+	// keeps the buffer
+	void Clear()
+	{
+		head = 0;
+		count = 0;
+	}
+
+	__forceinline bool Empty() const { return count == 0; }
+	__forceinline int Size() const { return count; }
+
+protected:
+	void Grow()
+	{
+		REArray<JobDescriptor> newBuffer(buffer.empty() ? 64 : buffer.size() * 2);
+		for (int i = 0; i < count; ++i)
+			newBuffer[i] = buffer[(head + i) & ((int)buffer.size() - 1)];
+		buffer.swap(newBuffer);
+		head = 0;
+	}
+
+	// size is always power of 2
+	REArray<JobDescriptor> buffer;
+	int head = 0;
+	int count = 0;
+};
+
+std::atomic<bool> bJobSystemRuning = false;
 
 REArray<JobSystemWorker> gJobSystemWorkerList;
 
-REQueue<JobDescriptor> gJobQueue[(int)EJobPriority::Count];
-REQueue<JobDescriptor> gRenderJobQueue;
+// jobs added from threads outside of the job system (no worker deque to push to)
+JobDescriptorRing gInjectedJobQueue[(int)EJobPriority::Count];
+std::atomic<int> gInjectedJobCount = 0;
+
+int gJobPriorityWeights[(int)EJobPriority::Count] = { 8, 3, 1 };
+// jobs pushed by threads outside of the job system, those can push at the same time so these are updated atomically
+JobPriorityCounters gExternalJobCounters[(int)EJobPriority::Count + 1];
+
+// shared payload blocks, workers move batches in and out of their own lists
+SpinLock gJobPayloadLock;
+JobPayloadBlock* gJobPayloadFreeList = 0;
+// every chunk we allocated, released when the job system stops
+REArray<JobPayloadBlock*> gJobPayloadChunkList;
+const int gJobPayloadChunkSize = 64;
+int gJobPayloadInitialCount = 4096;
+// a worker keeps at most this many blocks, half of them go back to the shared list above that
+const int gJobPayloadWorkerCacheSize = 128;
+
+JobFiberPoolDesc gJobFiberPoolDescs[(int)EJobStackSize::Count] =
+{
+	{ gJobSmallStackSize, 32, 1024 },
+	{ gJobMediumStackSize, 32, 256 },
+	{ gJobLargeStackSize, 4, 32 },
+};
+
+// every fiber we created, only used for clean up
+ThreadProtected<REArray<JobFiberListData>, SpinLock> gAllFiberList;
 
-ThreadProtected<REArray<JobFiberListData>, SpinLock> gFreeFiberList;
-ThreadProtected<REArray<JobFiberListData>, SpinLock> gWaitingFiberList;
+// one pool per stack size class
+struct JobFiberPool
+{
+	ThreadProtected<REArray<JobFiberListData>, SpinLock> freeFiberList;
+	std::atomic<int> fiberCount = 0;
+	// jobs popped while the pool was at its cap, not pending work so their worker can park,
+	// queued again when a fiber of this class is freed, see ReleaseFiberWaitingJob
+	SpinLock fiberWaitingJobLock;
+	JobDescriptorRing fiberWaitingJobQueue;
+	std::atomic<int> fiberWaitingJobCount = 0;
+};
+
+JobFiberPool gJobFiberPools[(int)EJobStackSize::Count];
+
+// intrusive FIFO of fibers ready to resume, linked through JobFiberData::nextWaitingFiber
+class ReadyFiberQueue
+{
+public:
+	void Push(JobFiberData* fiberDataPtr)
+	{
+		fiberDataPtr->nextWaitingFiber = 0;
+		lock.LockReadWrite();
+		if (tail)
+			tail->nextWaitingFiber = fiberDataPtr;
+		else
+			head = fiberDataPtr;
+		tail = fiberDataPtr;
+		count.fetch_add(1, std::memory_order_release);
+		lock.UnlockReadWrite();
+	}
+
+	JobFiberData* Pop()
+	{
+		// cheap check, we poll often
+		if (count.load(std::memory_order_acquire) == 0)
+			return 0;
+
+		lock.LockReadWrite();
+		JobFiberData* fiberDataPtr = head;
+		if (fiberDataPtr)
+		{
+			head = fiberDataPtr->nextWaitingFiber;
+			if (!head)
+				tail = 0;
+			fiberDataPtr->nextWaitingFiber = 0;
+			count.fetch_sub(1, std::memory_order_relaxed);
+		}
+		lock.UnlockReadWrite();
+		return fiberDataPtr;
+	}
+
+	void Clear()
+	{
+		head = tail = 0;
+		count = 0;
+	}
+
+	__forceinline bool Empty() const
+	{
+		return count.load(std::memory_order_acquire) == 0;
+	}
+
+protected:
+	JobFiberData* head = 0;
+	JobFiberData* tail = 0;
+	std::atomic<int> count = 0;
+	SpinLock lock;
+};
+
+ReadyFiberQueue gReadyFiberQueue;
+
+// per worker queues for everything with a fixed processor (render jobs, JobDescriptor::fixedProcessor, fibers resumed after waiting)
+// the target worker is woken directly, nobody else looks at them
+struct JobWorkerMailbox
+{
+	SpinLock jobQueueLock;
+	JobDescriptorRing jobQueue;
+	std::atomic<int> jobCount = 0;
+	ReadyFiberQueue readyFiberQueue;
+
+	// returns the queue length after the push
+	int PushJob(const JobDescriptor& jobDesc)
+	{
+		jobQueueLock.LockReadWrite();
+		jobQueue.Push(jobDesc);
+		int newCount = jobCount.fetch_add(1, std::memory_order_release) + 1;
+		jobQueueLock.UnlockReadWrite();
+		return newCount;
+	}
+
+	bool PopJob(JobDescriptor& outJobDesc)
+	{
+		if (jobCount.load(std::memory_order_acquire) == 0)
+			return false;
+		jobQueueLock.LockReadWrite();
+		bool bResult = jobQueue.Pop(outJobDesc);
+		if (bResult)
+			jobCount.fetch_sub(1, std::memory_order_relaxed);
+		jobQueueLock.UnlockReadWrite();
+		return bResult;
+	}
+
+	__forceinline bool Empty() const
+	{
+		return jobCount.load(std::memory_order_acquire) == 0 && readyFiberQueue.Empty();
+	}
+};
 
 // spin locks
-SpinLock gJobQueueLock;
+SpinLock gInjectedJobQueueLock;
+
+// general workers parked right now, render worker only parks through its own idle state
+SpinLock gIdleWorkerLock;
+REArray<int> gIdleWorkerList;
+std::atomic<int> gIdleWorkerCount = 0;
+
+// rounds of polling with yield before a worker parks
+const int gJobWorkerSpinCount = 64;
+
+int64_t gJobSystemStartTime = 0;
+
+// -1 for threads not owned by the job system
+thread_local int tlsJobWorkerIndex = -1;
+
+// fibers can move between threads, never inline this so TLS address is not cached across a fiber switch
+RE_NOINLINE int GetCurrentWorkerIndex()
+{
+	return tlsJobWorkerIndex;
+}
 
 JobWaitingCounter gRenderFrameSyncCounter;
 
@@ -80,164 +385,710 @@ __forceinline bool CheckWaitingCounter(JobFiberData* fiberDataPtr)
 }
 
 
-void AddJobFiberToFreeList(void* fiber, void* dataPtr)
+__forceinline int GetJobStackClass(int stackSize)
+{
+	if (stackSize <= 0)
+		return (int)EJobStackSize::Medium;
+	for (int i = 0; i < (int)EJobStackSize::Count; ++i)
+	{
+		if (stackSize <= gJobFiberPoolDescs[i].stackSize)
+			return i;
+	}
+	// bigger than any class, give it the biggest we have
+	assert(false);
+	return (int)EJobStackSize::Count - 1;
+}
+
+void JobFiberFunc(void* fiberParameter);
+void ReleaseFiberWaitingJob(int stackClass);
+
+JobFiberListData CreateJobFiberForPool(int stackClass)
+{
+	JobFiberListData fiberData;
+	fiberData.fiberDataPtr = new JobFiberData();
+	fiberData.fiberDataPtr->stackClass = stackClass;
+	// first scratch block comes with the fiber, a warm pool never touches the heap
+	fiberData.fiberDataPtr->scratchArena.Reserve(JobScratchArena::DEFAULT_BLOCK_SIZE);
+	fiberData.fiber = CreateJobFiber(gJobFiberPoolDescs[stackClass].stackSize, &JobFiberFunc, fiberData.fiberDataPtr);
+	fiberData.fiberDataPtr->fiber = fiberData.fiber;
+
+	SCOPED_READ_WRITE_REF(gAllFiberList, gAllFiberListRef)
+	gAllFiberListRef.push_back(fiberData);
+	return fiberData;
+}
+
+void AddJobFiberToFreeList(JobFiber* fiber, JobFiberData* dataPtr)
 {
 	assert(fiber);
 
 	JobFiberListData fiberData;
 	fiberData.fiber = fiber;
-	fiberData.fiberDataPtr = (JobFiberData*)dataPtr;
+	fiberData.fiberDataPtr = dataPtr;
 	
+	JobFiberPool& pool = gJobFiberPools[dataPtr->stackClass];
 	{
-		SCOPED_READ_WRITE_REF(gFreeFiberList, gFreeFiberListRef)
-		gFreeFiberListRef.push_back(fiberData);
+		SCOPED_READ_WRITE_REF(pool.freeFiberList, freeFiberListRef)
+		freeFiberListRef.push_back(fiberData);
 	}
 
+	// pairs with the fence in AddFiberWaitingJob, either we see its job or it sees our fiber
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (pool.fiberWaitingJobCount.load(std::memory_order_relaxed) > 0)
+		ReleaseFiberWaitingJob(dataPtr->stackClass);
 }
 
-void AddJobFiberToWaitingList(void* fiber, void* dataPtr)
+// approximate, a free fiber can be taken before the caller gets to it
+bool HasFreeJobFiber(int stackClass)
 {
-	assert(fiber);
-	assert(dataPtr);
+	JobFiberPool& pool = gJobFiberPools[stackClass];
+	if (pool.fiberCount.load(std::memory_order_relaxed) < gJobFiberPoolDescs[stackClass].maxCount)
+		return true;
+	SCOPED_READ_WRITE_REF(pool.freeFiberList, freeFiberListRef)
+	return !freeFiberListRef.empty();
+}
 
-	JobFiberListData fiberData;
-	fiberData.fiber = fiber;
-	fiberData.fiberDataPtr = (JobFiberData*)dataPtr;
+bool GetFreeJobFiber(int stackClass, JobFiberListData& outFiberData)
+{
+	JobFiberPool& pool = gJobFiberPools[stackClass];
+	{
+		SCOPED_READ_WRITE_REF(pool.freeFiberList, freeFiberListRef)
+		if (!freeFiberListRef.empty())
+		{
+			outFiberData = freeFiberListRef.back();
+			freeFiberListRef.pop_back();
+			return true;
+		}
+	}
 
+	// pool is empty, grow it if we are still under the cap
+	if (pool.fiberCount.fetch_add(1, std::memory_order_relaxed) >= gJobFiberPoolDescs[stackClass].maxCount)
 	{
-		SCOPED_READ_WRITE_REF(gWaitingFiberList, gWaitingFiberListRef)
-		gWaitingFiberListRef.push_back(fiberData);
+		pool.fiberCount.fetch_sub(1, std::memory_order_relaxed);
+		return false;
 	}
+	outFiberData = CreateJobFiberForPool(stackClass);
+	return true;
 }
 
-void GetNextJobFiber(void* prevFiber, JobFiberData* prevFiberDataPtr, int processorIndex, 
-	void*& outFiber, JobFiberData*& outFiberDataPtr)
+// caller holds gJobPayloadLock
+void AddJobPayloadChunk()
 {
-	outFiber = 0;
-	outFiberDataPtr = 0;
+	JobPayloadBlock* chunk = new JobPayloadBlock[gJobPayloadChunkSize];
+	gJobPayloadChunkList.push_back(chunk);
+	for (int i = 0; i < gJobPayloadChunkSize; ++i)
+	{
+		chunk[i].next = gJobPayloadFreeList;
+		gJobPayloadFreeList = &chunk[i];
+	}
+}
 
-	JobFiberListData nextFiberData;
+void* AllocateJobPayload()
+{
+	int workerIndex = GetCurrentWorkerIndex();
+	JobSystemWorker* worker = (workerIndex >= 0) ? &gJobSystemWorkerList[workerIndex] : 0;
+	if (worker && worker->payloadFreeList)
+	{
+		JobPayloadBlock* block = worker->payloadFreeList;
+		worker->payloadFreeList = block->next;
+		--worker->payloadFreeCount;
+		return block;
+	}
 
-	//printf("GetNextJobFiber thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
+	gJobPayloadLock.LockReadWrite();
+	if (!gJobPayloadFreeList)
+		AddJobPayloadChunk();
+	JobPayloadBlock* block = gJobPayloadFreeList;
+	gJobPayloadFreeList = block->next;
+	// refill the worker cache while we hold the lock
+	if (worker)
+	{
+		for (int i = 0; i < gJobPayloadWorkerCacheSize / 2 && gJobPayloadFreeList; ++i)
+		{
+			JobPayloadBlock* cacheBlock = gJobPayloadFreeList;
+			gJobPayloadFreeList = cacheBlock->next;
+			cacheBlock->next = worker->payloadFreeList;
+			worker->payloadFreeList = cacheBlock;
+			++worker->payloadFreeCount;
+		}
+	}
+	gJobPayloadLock.UnlockReadWrite();
+	return block;
+}
+
+void FreeJobPayload(void* payloadPtr)
+{
+	JobPayloadBlock* block = (JobPayloadBlock*)payloadPtr;
+	int workerIndex = GetCurrentWorkerIndex();
+	if (workerIndex < 0)
+	{
+		gJobPayloadLock.LockReadWrite();
+		block->next = gJobPayloadFreeList;
+		gJobPayloadFreeList = block;
+		gJobPayloadLock.UnlockReadWrite();
+		return;
+	}
+
+	JobSystemWorker& worker = gJobSystemWorkerList[workerIndex];
+	block->next = worker.payloadFreeList;
+	worker.payloadFreeList = block;
+	if (++worker.payloadFreeCount <= gJobPayloadWorkerCacheSize)
+		return;
+
+	// producers and consumers are often different workers, give half back
+	JobPayloadBlock* first = worker.payloadFreeList;
+	JobPayloadBlock* last = first;
+	for (int i = 1; i < gJobPayloadWorkerCacheSize / 2; ++i)
+		last = last->next;
+	worker.payloadFreeList = last->next;
+	worker.payloadFreeCount -= gJobPayloadWorkerCacheSize / 2;
+
+	gJobPayloadLock.LockReadWrite();
+	last->next = gJobPayloadFreeList;
+	gJobPayloadFreeList = first;
+	gJobPayloadLock.UnlockReadWrite();
+}
+
+__forceinline int64_t GetJobSystemTimeNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// only the owning worker writes, a plain load and store is enough (no locked instruction on the job path)
+__forceinline void AddJobStat(std::atomic<int64_t>& stat, int64_t value)
+{
+	stat.store(stat.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
 
-	// check waiting list first
+__forceinline int GetJobStatsHistogramBucket(int64_t value)
+{
+	int bucket = 0;
+	while (value > 0 && bucket < gJobStatsHistogramBucketCount - 1)
 	{
-		SCOPED_READ_WRITE_REF(gWaitingFiberList, gWaitingFiberListRef)
+		value >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
 
-		for (int i = 0, ni = (int)gWaitingFiberListRef.size(); i < ni; ++i)
+void RecordJobPush(int workerIndex, int priority, int queueLength)
+{
+#if JOB_STATS
+	int bucket = GetJobStatsHistogramBucket(queueLength);
+	if (workerIndex >= 0)
+	{
+		JobPriorityCounters& counters = gJobSystemWorkerList[workerIndex].priorityCounters[priority];
+		AddJobStat(counters.pushCount, 1);
+		AddJobStat(counters.queueDepthHistogram[bucket], 1);
+	}
+	else
+	{
+		JobPriorityCounters& counters = gExternalJobCounters[priority];
+		counters.pushCount.fetch_add(1, std::memory_order_relaxed);
+		counters.queueDepthHistogram[bucket].fetch_add(1, std::memory_order_relaxed);
+	}
+#endif
+}
+
+// jobs are only popped on workers
+void RecordJobPop(JobSystemWorker& worker, const JobDescriptor& jobDesc)
+{
+#if JOB_STATS
+	int64_t timeNs = GetJobSystemTimeNs();
+	JobPriorityCounters& counters = worker.priorityCounters[(int)jobDesc.priority];
+	int64_t waitTimeNs = timeNs - jobDesc.queueTimeNs;
+	if (waitTimeNs < 0)
+		waitTimeNs = 0;
+	AddJobStat(counters.popCount, 1);
+	AddJobStat(counters.totalWaitTimeNs, waitTimeNs);
+	if (waitTimeNs > counters.maxWaitTimeNs.load(std::memory_order_relaxed))
+		counters.maxWaitTimeNs.store(waitTimeNs, std::memory_order_relaxed);
+	AddJobStat(counters.waitTimeHistogram[GetJobStatsHistogramBucket(waitTimeNs / 1000)], 1);
+#endif
+}
+
+__forceinline bool IsJobCancelled(const JobDescriptor& jobDesc)
+{
+	return jobDesc.cancellationTokenPtr && jobDesc.cancellationTokenPtr->IsCancelled();
+}
+
+// finish a popped job without running it
+void DropCancelledJob(JobSystemWorker& worker, const JobDescriptor& jobDesc)
+{
+	RecordJobPop(worker, jobDesc);
+#if JOB_STATS
+	AddJobStat(worker.priorityCounters[(int)jobDesc.priority].cancelCount, 1);
+#endif
+	if (jobDesc.counterPtr)
+		jobDesc.counterPtr->Sub(1);
+}
+
+// approximate, only used to cancel parking
+bool HasPendingWork(int processorIndex)
+{
+	if (!gJobSystemWorkerList[processorIndex].mailbox->Empty())
+		return true;
+	// render processor only runs its mailbox
+	if (processorIndex == gRenderProcessorIndex)
+		return false;
+
+	if (!gReadyFiberQueue.Empty() || gInjectedJobCount.load(std::memory_order_relaxed) > 0)
+		return true;
+	// render worker doesn't run its own queues, but jobs it pushes are stolen from there
+	for (int i = 0, ni = (int)gJobSystemWorkerList.size(); i < ni; ++i)
+	{
+		for (int priority = 0; priority < (int)EJobPriority::Count; ++priority)
 		{
-			const JobFiberListData& waitingData = gWaitingFiberListRef[i];
-			JobFiberData* fiberDataPtr = waitingData.fiberDataPtr;
-			if ((!fiberDataPtr->waitingCounterPtr || (*fiberDataPtr->waitingCounterPtr).Get() == fiberDataPtr->waitingCounterTarget) &&
-				((processorIndex != gRenderProcessorIndex && fiberDataPtr->fixedProcessor < 0) || fiberDataPtr->fixedProcessor == processorIndex))
+			if (!gJobSystemWorkerList[i].jobQueues[priority].Empty())
+				return true;
+		}
+	}
+	return false;
+}
+
+void UnparkWorker(int processorIndex)
+{
+	JobWorkerIdleState* idleState = gJobSystemWorkerList[processorIndex].idleState;
+	idleState->wakeRequestTime.store(GetJobSystemTimeNs(), std::memory_order_relaxed);
+	{
+		std::lock_guard<std::mutex> lock(idleState->mutex);
+		idleState->bWakeRequested = true;
+	}
+	idleState->condition.notify_one();
+}
+
+// returns true if the worker is still registered (nobody is waking it)
+bool RemoveIdleWorker(int processorIndex)
+{
+	JobWorkerIdleState* idleState = gJobSystemWorkerList[processorIndex].idleState;
+	bool bRemoved = false;
+	gIdleWorkerLock.LockReadWrite();
+	if (idleState->bIdle.load(std::memory_order_relaxed))
+	{
+		idleState->bIdle.store(false, std::memory_order_relaxed);
+		if (processorIndex != gRenderProcessorIndex)
+		{
+			for (int i = 0, ni = (int)gIdleWorkerList.size(); i < ni; ++i)
 			{
-				// assign fiber data
-				nextFiberData = waitingData;
-				// remove from list
-				gWaitingFiberListRef.erase(gWaitingFiberListRef.begin() + i);
-				break;
+				if (gIdleWorkerList[i] == processorIndex)
+				{
+					gIdleWorkerList[i] = gIdleWorkerList.back();
+					gIdleWorkerList.pop_back();
+					break;
+				}
 			}
+			gIdleWorkerCount.fetch_sub(1, std::memory_order_relaxed);
 		}
+		bRemoved = true;
 	}
+	gIdleWorkerLock.UnlockReadWrite();
+	return bRemoved;
+}
 
-	if (nextFiberData.fiber)
-	{
-		assert(nextFiberData.fiberDataPtr);
-		nextFiberData.fiberDataPtr->prevFiber = prevFiber;
-		nextFiberData.fiberDataPtr->prevFiberDataPtr = prevFiberDataPtr;
-		nextFiberData.fiberDataPtr->currentProcessor = processorIndex;
-		// clear waiting status
-		nextFiberData.fiberDataPtr->waitingCounterPtr = 0;
-		nextFiberData.fiberDataPtr->waitingCounterTarget = 0;
-		outFiber = nextFiberData.fiber;
-		outFiberDataPtr = nextFiberData.fiberDataPtr;
+// block the worker thread until UnparkWorker, the running fiber must not be waiting on a counter (nobody would wake the thread for it)
+void ParkWorker(int processorIndex)
+{
+	JobWorkerIdleState* idleState = gJobSystemWorkerList[processorIndex].idleState;
 
-		//printf("pick up waiting list thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
+	// register first, then check again: a job pushed before this is seen by the check, a job pushed after sees us idle
+	gIdleWorkerLock.LockReadWrite();
+	idleState->bIdle.store(true, std::memory_order_relaxed);
+	if (processorIndex != gRenderProcessorIndex)
+	{
+		gIdleWorkerList.push_back(processorIndex);
+		gIdleWorkerCount.fetch_add(1, std::memory_order_relaxed);
+	}
+	gIdleWorkerLock.UnlockReadWrite();
+	std::atomic_thread_fence(std::memory_order_seq_cst);
 
+	if (!bJobSystemRuning || HasPendingWork(processorIndex))
+	{
+		// if somebody already took us off the list its wake up is on the way, next park just returns early
+		RemoveIdleWorker(processorIndex);
 		return;
 	}
 
-	// no waiting fiber, try get a free fiber and a new job
-	JobDescriptor jobDesc;
+	JOB_TRACE_EVENT(processorIndex, IdleBegin, 0, 0, 0);
+	int64_t parkStartTime = GetJobSystemTimeNs();
+	{
+		std::unique_lock<std::mutex> lock(idleState->mutex);
+		idleState->condition.wait(lock, [idleState] { return idleState->bWakeRequested; });
+		idleState->bWakeRequested = false;
+	}
+	int64_t parkEndTime = GetJobSystemTimeNs();
+	JOB_TRACE_EVENT(processorIndex, IdleEnd, 0, 0, 0);
 
-	bool bCanUsePrevFiber = (prevFiber && prevFiberDataPtr && !prevFiberDataPtr->waitingCounterPtr);
+	idleState->idleTimeNs.fetch_add(parkEndTime - parkStartTime, std::memory_order_relaxed);
+	int64_t wakeLatency = parkEndTime - idleState->wakeRequestTime.load(std::memory_order_relaxed);
+	if (wakeLatency >= 0)
+	{
+		idleState->wakeCount.fetch_add(1, std::memory_order_relaxed);
+		idleState->totalWakeLatencyNs.fetch_add(wakeLatency, std::memory_order_relaxed);
+		if (wakeLatency > idleState->maxWakeLatencyNs.load(std::memory_order_relaxed))
+			idleState->maxWakeLatencyNs.store(wakeLatency, std::memory_order_relaxed);
+	}
+}
 
-	if (bCanUsePrevFiber)
+// wake up to count parked general workers, one for each new job or ready fiber
+void WakeIdleWorkers(int count)
+{
+	// pairs with the fence in ParkWorker, either we see the idle worker or it sees our job
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	while (count > 0 && gIdleWorkerCount.load(std::memory_order_relaxed) > 0)
 	{
-		gJobQueueLock.LockReadWrite();
+		int processorIndex = -1;
+		gIdleWorkerLock.LockReadWrite();
+		if (!gIdleWorkerList.empty())
+		{
+			processorIndex = gIdleWorkerList.back();
+			gIdleWorkerList.pop_back();
+			gIdleWorkerCount.fetch_sub(1, std::memory_order_relaxed);
+			gJobSystemWorkerList[processorIndex].idleState->bIdle.store(false, std::memory_order_relaxed);
+		}
+		gIdleWorkerLock.UnlockReadWrite();
 
-		//printf("CanUsePrevFiber thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
+		if (processorIndex < 0)
+			break;
+		UnparkWorker(processorIndex);
+		--count;
+	}
+}
+
+// wake one specific worker, after something was put in its mailbox
+void WakeWorker(int processorIndex)
+{
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	JobWorkerIdleState* idleState = gJobSystemWorkerList[processorIndex].idleState;
+	if (!idleState->bIdle.load(std::memory_order_relaxed))
+		return;
+	if (RemoveIdleWorker(processorIndex))
+		UnparkWorker(processorIndex);
+}
 
-		// get job
-		REQueue<JobDescriptor>* targetQueuePtr = 0;
-		if (processorIndex == gRenderProcessorIndex)
+void AddJobFibersToReadyQueue(JobFiberData* fiberDataList)
+{
+	int readyCount = 0;
+	while (fiberDataList)
+	{
+		JobFiberData* nextFiberDataPtr = fiberDataList->nextWaitingFiber;
+		int fixedProcessor = fiberDataList->fixedProcessor;
+		if (fixedProcessor >= 0)
 		{
-			if (!gRenderJobQueue.empty())
-				targetQueuePtr = &gRenderJobQueue;
+			// straight back to its worker, no other worker picks it up and passes it on
+			gJobSystemWorkerList[fixedProcessor].mailbox->readyFiberQueue.Push(fiberDataList);
+			WakeWorker(fixedProcessor);
 		}
 		else
 		{
-			for (int i = 0; i < (int)EJobPriority::Count; ++i)
-			{
-				if (!gJobQueue[i].empty())
-				{
-					targetQueuePtr = &gJobQueue[i];
-					break;
-				}
-			}
+			gReadyFiberQueue.Push(fiberDataList);
+			++readyCount;
 		}
-		if (targetQueuePtr)
+		fiberDataList = nextFiberDataPtr;
+	}
+
+	WakeIdleWorkers(readyCount);
+}
+
+// must hold waitingFiberLock, returns the list of fibers whose target is reached
+JobFiberData* JobWaitingCounter::RemoveReadyFibers()
+{
+	int value = Get();
+	JobFiberData* readyList = 0;
+	JobFiberData** linkPtr = &waitingFiberList;
+	while (*linkPtr)
+	{
+		JobFiberData* fiberDataPtr = *linkPtr;
+		if (fiberDataPtr->waitingCounterTarget == value)
 		{
-			// assign job desc
-			jobDesc = targetQueuePtr->front();
-			// remove job from queue
-			targetQueuePtr->pop();
-			// assign fiber
-			nextFiberData.fiber = prevFiber;
-			nextFiberData.fiberDataPtr = prevFiberDataPtr;
+			// unlink and add to ready list
+			*linkPtr = fiberDataPtr->nextWaitingFiber;
+			fiberDataPtr->nextWaitingFiber = readyList;
+			readyList = fiberDataPtr;
 		}
+		else
+		{
+			linkPtr = &fiberDataPtr->nextWaitingFiber;
+		}
+	}
+	// nobody left, later Add/Sub can skip waking
+	if (!waitingFiberList)
+		state.fetch_and(~WAITING_BIT, std::memory_order_acq_rel);
+	return readyList;
+}
 
-		gJobQueueLock.UnlockReadWrite();
+void JobWaitingCounter::AddWaitingFiber(JobFiberData* fiberDataPtr)
+{
+	assert(fiberDataPtr);
+	assert(fiberDataPtr->waitingCounterPtr == this);
+
+	waitingFiberLock.LockReadWrite();
+	fiberDataPtr->nextWaitingFiber = waitingFiberList;
+	waitingFiberList = fiberDataPtr;
+	state.fetch_or(WAITING_BIT, std::memory_order_acq_rel);
+	// counter might have reached the target before the waiting bit is set, nobody else will wake it up then
+	JobFiberData* readyList = RemoveReadyFibers();
+	waitingFiberLock.UnlockReadWrite();
+
+	// don't touch the counter after this, the waiting fiber can resume and release it
+	AddJobFibersToReadyQueue(readyList);
+}
+
+void JobWaitingCounter::WakeWaitingFibers()
+{
+	waitingFiberLock.LockReadWrite();
+	JobFiberData* readyList = RemoveReadyFibers();
+	waitingFiberLock.UnlockReadWrite();
+
+	AddJobFibersToReadyQueue(readyList);
+
+	// we are done with the counter, resumed fibers can leave WaitOnCounter now
+	state.fetch_sub(WAKER_ONE, std::memory_order_release);
+}
+
+void JobWaitingCounter::WaitForWakers()
+{
+	while (state.load(std::memory_order_acquire) & WAKER_MASK)
+		std::this_thread::yield();
+}
+
+bool PopInjectedJob(int priority, JobDescriptor& outJobDesc)
+{
+	if (gInjectedJobCount.load(std::memory_order_relaxed) == 0)
+		return false;
+
+	bool bResult = false;
+	gInjectedJobQueueLock.LockReadWrite();
+	if (gInjectedJobQueue[priority].Pop(outJobDesc))
+	{
+		gInjectedJobCount.fetch_sub(1, std::memory_order_relaxed);
+		bResult = true;
+	}
+	gInjectedJobQueueLock.UnlockReadWrite();
+	return bResult;
+}
+
+bool StealJob(JobSystemWorker& thief, int priority, JobDescriptor& outJobDesc)
+{
+	int workerCount = (int)gJobSystemWorkerList.size();
+	// start from a random victim so thieves don't all hit the same worker
+	int victimIndex = (int)(thief.NextRandom() % (unsigned int)workerCount);
+	for (int i = 0; i < workerCount; ++i)
+	{
+		if (victimIndex != thief.processorIndex &&
+			gJobSystemWorkerList[victimIndex].jobQueues[priority].Steal(outJobDesc))
+		{
+			JOB_TRACE_EVENT(thief.processorIndex, Steal, 0, 0, victimIndex);
+			return true;
+		}
+		if (++victimIndex >= workerCount)
+			victimIndex = 0;
+	}
+	return false;
+}
+
+__forceinline int GetJobPriorityWeight(int priority)
+{
+	return (gJobPriorityWeights[priority] > 0) ? gJobPriorityWeights[priority] : 1;
+}
+
+__forceinline bool PopJobWithPriority(JobSystemWorker& worker, int priority, JobDescriptor& outJobDesc)
+{
+	// own queue first, then jobs from outside, then steal
+	return worker.jobQueues[priority].Pop(outJobDesc) ||
+		PopInjectedJob(priority, outJobDesc) ||
+		StealJob(worker, priority, outJobDesc);
+}
+
+bool PopNextJob(int processorIndex, JobDescriptor& outJobDesc)
+{
+	JobSystemWorker& worker = gJobSystemWorkerList[processorIndex];
+	// jobs sent to this worker first, render processor only runs those
+	if (worker.mailbox->PopJob(outJobDesc))
+		return true;
+	if (processorIndex == gRenderProcessorIndex)
+		return false;
+
+	// weighted round robin, the priority whose turn it is goes first, then the others from High to Low
+	// the turn moves on after weight jobs, so every priority with work gets at least its weight out of every round
+	int turnPriority = worker.priorityTurn;
+	bool bPopped = PopJobWithPriority(worker, turnPriority, outJobDesc);
+	for (int i = 0; i < (int)EJobPriority::Count && !bPopped; ++i)
+	{
+		if (i != turnPriority)
+			bPopped = PopJobWithPriority(worker, i, outJobDesc);
+	}
+	if (!bPopped)
+		return false;
+
+	if (--worker.priorityTurnCredits <= 0)
+	{
+		worker.priorityTurn = (turnPriority + 1) % (int)EJobPriority::Count;
+		worker.priorityTurnCredits = GetJobPriorityWeight(worker.priorityTurn);
+	}
+	return true;
+}
+
+__forceinline int GetJobFixedProcessor(const JobDescriptor& jobDesc)
+{
+	return (jobDesc.priority == EJobPriority::Render) ? gRenderProcessorIndex : jobDesc.fixedProcessor;
+}
+
+// caller wakes the target worker, returns the length of the queue the job went to
+int PushJob(int workerIndex, const JobDescriptor& jobDesc)
+{
+	int queueLength = 0;
+	int fixedProcessor = GetJobFixedProcessor(jobDesc);
+	if (fixedProcessor >= 0)
+	{
+		assert(fixedProcessor < (int)gJobSystemWorkerList.size());
+		queueLength = gJobSystemWorkerList[fixedProcessor].mailbox->PushJob(jobDesc);
+	}
+	else if (workerIndex >= 0)
+	{
+		WorkStealingQueue<JobDescriptor>& jobQueue = gJobSystemWorkerList[workerIndex].jobQueues[(int)jobDesc.priority];
+		jobQueue.Push(jobDesc);
+		queueLength = jobQueue.Size();
 	}
 	else
 	{
-		SCOPED_READ_WRITE_REF(gFreeFiberList, gFreeFiberListRef);
-		
-		if (!gFreeFiberListRef.empty())
+		gInjectedJobQueueLock.LockReadWrite();
+		gInjectedJobQueue[(int)jobDesc.priority].Push(jobDesc);
+		queueLength = gInjectedJobQueue[(int)jobDesc.priority].Size();
+		gInjectedJobCount.fetch_add(1, std::memory_order_relaxed);
+		gInjectedJobQueueLock.UnlockReadWrite();
+	}
+	return queueLength;
+}
+
+// queued in place of a yielded fiber, GetNextJobFiber resumes the fiber instead of running this
+JOB_ENTRY_POINT(ResumeYieldedFiberJob)
+{
+	assert(false);
+}
+
+// move one job waiting for a fiber of this class back to the normal queues and wake a worker for it
+// if another job takes the fiber first, it just comes back to the waiting queue
+void ReleaseFiberWaitingJob(int stackClass)
+{
+	JobFiberPool& pool = gJobFiberPools[stackClass];
+	JobDescriptor jobDesc;
+	pool.fiberWaitingJobLock.LockReadWrite();
+	bool bHasJob = pool.fiberWaitingJobQueue.Pop(jobDesc);
+	if (bHasJob)
+		pool.fiberWaitingJobCount.fetch_sub(1, std::memory_order_relaxed);
+	pool.fiberWaitingJobLock.UnlockReadWrite();
+	if (!bHasJob)
+		return;
+
+	// FIFO queues, any worker can be the one that picks it up
+	PushJob(-1, jobDesc);
+	int fixedProcessor = GetJobFixedProcessor(jobDesc);
+	if (fixedProcessor >= 0)
+		WakeWorker(fixedProcessor);
+	else
+		WakeIdleWorkers(1);
+}
+
+// the job's pool is at its cap, hold it until a fiber is freed instead of putting it back in a queue
+// (that would keep its worker spinning on it)
+void AddFiberWaitingJob(int stackClass, const JobDescriptor& jobDesc)
+{
+	JobFiberPool& pool = gJobFiberPools[stackClass];
+	pool.fiberWaitingJobLock.LockReadWrite();
+	pool.fiberWaitingJobQueue.Push(jobDesc);
+	pool.fiberWaitingJobCount.fetch_add(1, std::memory_order_relaxed);
+	pool.fiberWaitingJobLock.UnlockReadWrite();
+
+	// a fiber freed before the push didn't see the job, check again, see AddJobFiberToFreeList
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (HasFreeJobFiber(stackClass))
+		ReleaseFiberWaitingJob(stackClass);
+}
+
+// fiber must be switched out already, see ReturnPrevFiber
+void QueueYieldedFiber(JobFiberData* fiberDataPtr)
+{
+	fiberDataPtr->bYielding = false;
+	JobDescriptor jobDesc(&ResumeYieldedFiberJob, fiberDataPtr, fiberDataPtr->jobPriority);
+	jobDesc.fixedProcessor = fiberDataPtr->fixedProcessor;
+#if JOB_STATS
+	jobDesc.queueTimeNs = GetJobSystemTimeNs();
+#endif
+	// FIFO queues only, our own deque would hand it straight back to this worker
+	int queueLength = PushJob(-1, jobDesc);
+	RecordJobPush(-1, (int)jobDesc.priority, queueLength);
+	if (fiberDataPtr->fixedProcessor >= 0)
+		WakeWorker(fiberDataPtr->fixedProcessor);
+	else
+		WakeIdleWorkers(1);
+}
+
+void GetNextJobFiber(JobFiber* prevFiber, JobFiberData* prevFiberDataPtr, int processorIndex, 
+	JobFiber*& outFiber, JobFiberData*& outFiberDataPtr)
+{
+	outFiber = 0;
+	outFiberDataPtr = 0;
+
+	JobFiberListData nextFiberData;
+
+	//printf("GetNextJobFiber thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
+
+	// resume ready fibers first, the ones fixed to this worker before anything else
+	JobFiberData* readyFiberDataPtr = gJobSystemWorkerList[processorIndex].mailbox->readyFiberQueue.Pop();
+	if (!readyFiberDataPtr && processorIndex != gRenderProcessorIndex)
+		readyFiberDataPtr = gReadyFiberQueue.Pop();
+
+	// no waiting fiber, try get a free fiber and a new job
+	JobDescriptor jobDesc;
+	bool bHasJob = false;
+	if (!readyFiberDataPtr)
+	{
+		bHasJob = PopNextJob(processorIndex, jobDesc);
+		// cancelled before it started, look for another one
+		while (bHasJob && IsJobCancelled(jobDesc))
+		{
+			DropCancelledJob(gJobSystemWorkerList[processorIndex], jobDesc);
+			bHasJob = PopNextJob(processorIndex, jobDesc);
+		}
+		// a yielded fiber queued like a job
+		if (bHasJob && jobDesc.entryPoint == &ResumeYieldedFiberJob)
 		{
-			gJobQueueLock.LockReadWrite();
+			RecordJobPop(gJobSystemWorkerList[processorIndex], jobDesc);
+			readyFiberDataPtr = (JobFiberData*)jobDesc.dataPtr;
+			bHasJob = false;
+		}
+	}
 
-			// get job
-			REQueue<JobDescriptor>* targetQueuePtr = 0;
-			if (processorIndex == gRenderProcessorIndex)
-			{
-				if (!gRenderJobQueue.empty())
-					targetQueuePtr = &gRenderJobQueue;
-			}
-			else
-			{
-				for (int i = 0; i < (int)EJobPriority::Count; ++i)
-				{
-					if (!gJobQueue[i].empty())
-					{
-						targetQueuePtr = &gJobQueue[i];
-						break;
-					}
-				}
-			}
-			if (targetQueuePtr)
-			{
-				// assign job desc
-				jobDesc = targetQueuePtr->front();
-				// remove job from queue
-				targetQueuePtr->pop();
-				// assign fiber
-				nextFiberData = gFreeFiberListRef.back();
-				// remove fiber
-				gFreeFiberListRef.pop_back();
-			}
+	if (readyFiberDataPtr)
+	{
+		readyFiberDataPtr->prevFiber = prevFiber;
+		readyFiberDataPtr->prevFiberDataPtr = prevFiberDataPtr;
+		readyFiberDataPtr->currentProcessor = processorIndex;
+		// clear waiting status
+		readyFiberDataPtr->waitingCounterPtr = 0;
+		readyFiberDataPtr->waitingCounterTarget = 0;
+		outFiber = readyFiberDataPtr->fiber;
+		outFiberDataPtr = readyFiberDataPtr;
+
+		//printf("pick up ready fiber thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
 
-			gJobQueueLock.UnlockReadWrite();
+		return;
+	}
+
+	bool bCanUsePrevFiber = (prevFiber && prevFiberDataPtr && !prevFiberDataPtr->waitingCounterPtr && !prevFiberDataPtr->bYielding);
+
+	if (bHasJob)
+	{
+		int stackClass = GetJobStackClass(jobDesc.stackSize);
+		if (bCanUsePrevFiber && prevFiberDataPtr->stackClass == stackClass)
+		{
+			// assign fiber
+			nextFiberData.fiber = prevFiber;
+			nextFiberData.fiberDataPtr = prevFiberDataPtr;
+		}
+		else if (!GetFreeJobFiber(stackClass, nextFiberData))
+		{
+			// pool is at its cap, the job waits for a fiber and this worker can park
+			AddFiberWaitingJob(stackClass, jobDesc);
 		}
 	}
 
@@ -253,7 +1104,11 @@ void GetNextJobFiber(void* prevFiber, JobFiberData* prevFiberDataPtr, int proces
 		nextFiberData.fiberDataPtr->prevFiber = prevFiber;
 		nextFiberData.fiberDataPtr->prevFiberDataPtr = prevFiberDataPtr;
 		nextFiberData.fiberDataPtr->currentProcessor = processorIndex;
-		nextFiberData.fiberDataPtr->fixedProcessor = (jobDesc.priority == EJobPriority::Render) ? gRenderProcessorIndex : -1;
+		nextFiberData.fiberDataPtr->fixedProcessor = GetJobFixedProcessor(jobDesc);
+		nextFiberData.fiberDataPtr->jobPriority = jobDesc.priority;
+		nextFiberData.fiberDataPtr->cancellationTokenPtr = jobDesc.cancellationTokenPtr;
+
+		RecordJobPop(gJobSystemWorkerList[processorIndex], jobDesc);
 
 		outFiber = nextFiberData.fiber;
 		outFiberDataPtr = nextFiberData.fiberDataPtr;
@@ -262,11 +1117,12 @@ void GetNextJobFiber(void* prevFiber, JobFiberData* prevFiberDataPtr, int proces
 	}
 }
 
-void PullNextJob(void* fiber, JobFiberData* fiberDataPtr, int processorIndex)
+void PullNextJob(JobFiber* fiber, JobFiberData* fiberDataPtr, int processorIndex)
 {
 	// pull next job
-	void* nextJobFiber = 0;
+	JobFiber* nextJobFiber = 0;
 	JobFiberData* nextJobFiberDataPtr = 0;
+	int spinCount = 0;
 
 	while (bJobSystemRuning && !nextJobFiber)
 	{
@@ -274,42 +1130,64 @@ void PullNextJob(void* fiber, JobFiberData* fiberDataPtr, int processorIndex)
 		if (fiberDataPtr && CheckWaitingCounter(fiberDataPtr))
 			return;
 
+		// fixed processor fibers only go to their own ready queue, so whatever we get can run here
 		GetNextJobFiber(fiber, fiberDataPtr, processorIndex, nextJobFiber, nextJobFiberDataPtr);
 		if (nextJobFiber)
+			break;
+
+		// new jobs usually come soon, poll a bit before parking
+		if (++spinCount < gJobWorkerSpinCount)
 		{
-			// core doesn't match, return to the waiting list
-			if (nextJobFiberDataPtr->fixedProcessor >= 0 && nextJobFiberDataPtr->fixedProcessor != processorIndex)
-			{
-				AddJobFiberToWaitingList(nextJobFiber, nextJobFiberDataPtr);
-				// clear job fiber, try again
-				nextJobFiber = 0;
-				nextJobFiberDataPtr = 0;
-			}
-		}
-		else
 			std::this_thread::yield();
-			//Sleep(1);
+			continue;
+		}
+		spinCount = 0;
+
+		// the counter wakes fibers not threads, hand the thread over to its own fiber,
+		// which puts us on the counter's waiting list and parks
+		// a finished job's fiber goes back to its pool the same way, jobs waiting for a fiber can't have it while we are parked
+		if (fiberDataPtr && !fiberDataPtr->bThreadFiber)
+		{
+			JobSystemWorker& worker = gJobSystemWorkerList[processorIndex];
+			worker.threadFiberData.prevFiber = fiber;
+			worker.threadFiberData.prevFiberDataPtr = fiberDataPtr;
+			nextJobFiber = worker.fiber;
+			break;
+		}
+
+		ParkWorker(processorIndex);
 	}
 
 	// we got a different fiber, switch
 	if (nextJobFiber && nextJobFiber != fiber)
 	{
+		JOB_TRACE_EVENT(processorIndex, FiberSwitch, fiberDataPtr, nextJobFiberDataPtr, 0);
 		//printf("before switch fiber thread ID: %x, current processor: %d, %x->%x\n", GetCurrentThreadId(), GetCurrentProcessorNumber(), fiber, nextJobFiber);
-		SwitchToFiber(nextJobFiber);
+		SwitchToJobFiber(nextJobFiber);
 		//printf("after switch fiber thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
 	}
 }
 
-void ReturnPrevFiber(void* fiber, JobFiberData* fiberDataPtr)
+void ReturnPrevFiber(JobFiber* fiber, JobFiberData* fiberDataPtr)
 {
 	if (fiberDataPtr->prevFiber && fiberDataPtr->prevFiber != fiber)
 	{
 		assert(fiberDataPtr->prevFiberDataPtr);
 
-		if (fiberDataPtr->prevFiberDataPtr->waitingCounterPtr)
+		if (fiberDataPtr->prevFiberDataPtr->bThreadFiber)
+		{
+			// thread fiber stays with its worker, it's resumed directly
+		}
+		else if (fiberDataPtr->prevFiberDataPtr->waitingCounterPtr)
 		{
 			//printf("return fiber to waiting thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
-			AddJobFiberToWaitingList(fiberDataPtr->prevFiber, fiberDataPtr->prevFiberDataPtr);
+			// prev fiber is switched out now, safe to let others resume it
+			fiberDataPtr->prevFiberDataPtr->waitingCounterPtr->AddWaitingFiber(fiberDataPtr->prevFiberDataPtr);
+		}
+		else if (fiberDataPtr->prevFiberDataPtr->bYielding)
+		{
+			// same as above, queue it only now that it's switched out
+			QueueYieldedFiber(fiberDataPtr->prevFiberDataPtr);
 		}
 		else
 		{
@@ -323,9 +1201,45 @@ void ReturnPrevFiber(void* fiber, JobFiberData* fiberDataPtr)
 	fiberDataPtr->prevFiberDataPtr = 0;
 }
 
-void JobSystemWorker::Start(int inCoreIndex)
+void JobSystemWorker::Init(int inProcessorIndex)
+{
+	processorIndex = inProcessorIndex;
+	randomState = (unsigned int)inProcessorIndex * 0x9E3779B9u + 1;
+	jobQueues = new WorkStealingQueue<JobDescriptor>[(int)EJobPriority::Count];
+	idleState = new JobWorkerIdleState();
+	mailbox = new JobWorkerMailbox();
+	priorityCounters = new JobPriorityCounters[(int)EJobPriority::Count + 1];
+	for (int i = 0; i <= (int)EJobPriority::Count; ++i)
+	{
+		priorityCounters[i].Reset();
+	}
+	priorityTurn = 0;
+	priorityTurnCredits = GetJobPriorityWeight(0);
+	threadFiberData.Reset();
+	threadFiberData.bThreadFiber = true;
+	threadFiberData.stackClass = -1;
+	threadFiberData.currentProcessor = inProcessorIndex;
+	threadFiberData.fixedProcessor = inProcessorIndex;
+}
+
+void JobSystemWorker::Release()
+{
+	delete[] jobQueues;
+	jobQueues = 0;
+	delete idleState;
+	idleState = 0;
+	delete mailbox;
+	mailbox = 0;
+	delete[] priorityCounters;
+	priorityCounters = 0;
+	payloadFreeList = 0;
+	payloadFreeCount = 0;
+	fiber = 0;
+	threadFiberData.fiber = 0;
+}
+
+void JobSystemWorker::Start()
 {
-	processorIndex = inCoreIndex;
 	threadPtr = new std::thread(&JobSystemWorker::Run, this);
 }
 
@@ -341,20 +1255,34 @@ void JobSystemWorker::Stop()
 
 void JobSystemWorker::Run()
 {
-	SetThreadAffinityMask(GetCurrentThread(), 1i64 << processorIndex);
-	printf("START: thread ID: %x, current processor: %d\n", GetCurrentThreadId(), processorIndex);
-	fiber = ConvertThreadToFiber(0);
+	// we might run more workers than cores (benchmark), wrap around
+	int coreCount = (int)std::thread::hardware_concurrency();
+	int coreIndex = (coreCount > 0) ? processorIndex % coreCount : processorIndex;
+	SetCurrentThreadAffinity(coreIndex);
+	// stderr so benchmark results on stdout stay parseable
+	fprintf(stderr, "START: worker: %d, core: %d, fiber backend: %s\n", processorIndex, coreIndex, FIBER_BACKEND_NAME);
+	tlsJobWorkerIndex = processorIndex;
+	fiber = ConvertThreadToJobFiber(&threadFiberData);
 	assert(fiber);
+	threadFiberData.fiber = fiber;
+
+	// start pulling next job, we only come back here to park for a waiting fiber, or on shutdown
+	while (bJobSystemRuning)
+	{
+		ReturnPrevFiber(fiber, &threadFiberData);
+		PullNextJob(fiber, &threadFiberData, processorIndex);
+	}
 
-	// start pulling next job
-	PullNextJob(0, 0, processorIndex);
+	// job system stopped
+	ConvertJobFiberToThread();
+	tlsJobWorkerIndex = -1;
 }
 
 
-void __stdcall JobFiberFunc(void* lpParameter)
+void JobFiberFunc(void* fiberParameter)
 {
-	JobFiberData* fiberDataPtr = (JobFiberData*)lpParameter;
-	void* fiber = GetCurrentFiber();
+	JobFiberData* fiberDataPtr = (JobFiberData*)fiberParameter;
+	JobFiber* fiber = fiberDataPtr->fiber;
 
 	while (bJobSystemRuning)
 	{
@@ -364,7 +1292,10 @@ void __stdcall JobFiberFunc(void* lpParameter)
 		ReturnPrevFiber(fiber, fiberDataPtr);
 
 		// execute user function
+		JOB_TRACE_EVENT(fiberDataPtr->currentProcessor, JobBegin, (const void*)fiberDataPtr->jobEntryPoint, fiberDataPtr, 0);
 		fiberDataPtr->jobEntryPoint(fiberDataPtr->jobDataPtr);
+		// we might be on another worker now
+		JOB_TRACE_EVENT(fiberDataPtr->currentProcessor, JobEnd, (const void*)fiberDataPtr->jobEntryPoint, fiberDataPtr, 0);
 
 		//printf("finish job thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
 
@@ -376,57 +1307,85 @@ void __stdcall JobFiberFunc(void* lpParameter)
 			fiberDataPtr->counterPtr->Sub(1);
 		}
 
+		fiberDataPtr->scratchArena.Reset();
+
 		// pull the next job
 		PullNextJob(fiber, fiberDataPtr, fiberDataPtr->currentProcessor);
 	}
 
-	SwitchToFiber(gJobSystemWorkerList[fiberDataPtr->currentProcessor].fiber);
+	SwitchToJobFiber(gJobSystemWorkerList[fiberDataPtr->currentProcessor].fiber);
 }
 
 
 int gJobSystemWorkerThreadCount = 6;
 int gRenderProcessorIndex = gJobSystemWorkerThreadCount - 1;
 
-void RunJobSystem(JobDescriptor* startJobDescPtr)
+void RunJobSystem(JobDescriptor* startJobDescPtr, int workerThreadCount)
 {
 #if USE_JOB_SYSTEM
 	assert(gJobSystemWorkerList.size() == 0);
 
-	gJobSystemWorkerThreadCount = std::thread::hardware_concurrency() - 2;
+	gJobSystemWorkerThreadCount = (workerThreadCount > 0) ? workerThreadCount : std::thread::hardware_concurrency() - 2;
 	gRenderProcessorIndex = gJobSystemWorkerThreadCount - 1;
 
 	assert(gJobSystemWorkerThreadCount > 1);
 
 	gJobSystemWorkerList.resize(gJobSystemWorkerThreadCount);
+	for (int i = 0; i < gJobSystemWorkerThreadCount; ++i)
+	{
+		gJobSystemWorkerList[i].Init(i);
+	}
 
 	// set current thread affinity to be first core
-	SetThreadAffinityMask(GetCurrentThread(), 1);
+	SetCurrentThreadAffinity(0);
 
-	// create fiber list
-	const int fiberCount = 32;
+	// create initial fibers for each pool, pools grow later when they run out
+	for (int stackClass = 0; stackClass < (int)EJobStackSize::Count; ++stackClass)
 	{
-		SCOPED_READ_WRITE_REF(gFreeFiberList, gFreeFiberListRef)
-		gFreeFiberListRef.resize(fiberCount);
-		for (int i = 0; i < fiberCount; ++i)
+		const JobFiberPoolDesc& poolDesc = gJobFiberPoolDescs[stackClass];
+		assert(poolDesc.initialCount <= poolDesc.maxCount);
+		JobFiberPool& pool = gJobFiberPools[stackClass];
+		pool.fiberCount = poolDesc.initialCount;
+		for (int i = 0; i < poolDesc.initialCount; ++i)
 		{
-			gFreeFiberListRef[i].fiberDataPtr = new JobFiberData();
-			gFreeFiberListRef[i].fiber = CreateFiber(0, &JobFiberFunc, gFreeFiberListRef[i].fiberDataPtr);
+			JobFiberListData fiberData = CreateJobFiberForPool(stackClass);
+			SCOPED_READ_WRITE_REF(pool.freeFiberList, freeFiberListRef)
+			freeFiberListRef.push_back(fiberData);
 		}
 	}
 
+	gIdleWorkerList.reserve(gJobSystemWorkerThreadCount);
+	for (int i = 0; i <= (int)EJobPriority::Count; ++i)
+	{
+		gExternalJobCounters[i].Reset();
+	}
+
+	// at least enough payload blocks to fill every worker cache, more chunks are only added for bursts
+	int payloadBlockCount = gJobSystemWorkerThreadCount * gJobPayloadWorkerCacheSize;
+	if (payloadBlockCount < gJobPayloadInitialCount)
+		payloadBlockCount = gJobPayloadInitialCount;
+	int payloadChunkCount = (payloadBlockCount + gJobPayloadChunkSize - 1) / gJobPayloadChunkSize;
+	gJobPayloadLock.LockReadWrite();
+	gJobPayloadChunkList.reserve(payloadChunkCount * 2);
+	for (int i = 0; i < payloadChunkCount; ++i)
+	{
+		AddJobPayloadChunk();
+	}
+	gJobPayloadLock.UnlockReadWrite();
+
+	InitJobTrace(gJobSystemWorkerThreadCount);
+
 	// start running
+	gJobSystemStartTime = GetJobSystemTimeNs();
 	bJobSystemRuning = true;
 
 	// start all worker thread
 	// reserve first worker for current thread
 	for (int i = 1; i < gJobSystemWorkerThreadCount; ++i)
 	{
-		gJobSystemWorkerList[i].Start(i);
+		gJobSystemWorkerList[i].Start();
 	}
 
-	// get ready to run fiber on this thread as well
-	gJobSystemWorkerList[0].processorIndex = 0;
-
 	// add start job
 	RunJobs(startJobDescPtr);
 
@@ -438,6 +1397,46 @@ void RunJobSystem(JobDescriptor* startJobDescPtr)
 	{
 		gJobSystemWorkerList[i].Stop();
 	}
+
+	// release everything so the job system can be started again
+	{
+		SCOPED_READ_WRITE_REF(gAllFiberList, gAllFiberListRef)
+		for (int i = 0, ni = (int)gAllFiberListRef.size(); i < ni; ++i)
+		{
+			DeleteJobFiber(gAllFiberListRef[i].fiber);
+			delete gAllFiberListRef[i].fiberDataPtr;
+		}
+		gAllFiberListRef.clear();
+	}
+	for (int stackClass = 0; stackClass < (int)EJobStackSize::Count; ++stackClass)
+	{
+		SCOPED_READ_WRITE_REF(gJobFiberPools[stackClass].freeFiberList, freeFiberListRef)
+		freeFiberListRef.clear();
+		gJobFiberPools[stackClass].fiberCount = 0;
+		gJobFiberPools[stackClass].fiberWaitingJobQueue.Clear();
+		gJobFiberPools[stackClass].fiberWaitingJobCount = 0;
+	}
+	gReadyFiberQueue.Clear();
+	for (int i = 0; i < (int)EJobPriority::Count; ++i)
+	{
+		gInjectedJobQueue[i].Clear();
+	}
+	gInjectedJobCount = 0;
+	// every job is done, so every payload block is back in some free list
+	gJobPayloadFreeList = 0;
+	for (int i = 0, ni = (int)gJobPayloadChunkList.size(); i < ni; ++i)
+	{
+		delete[] gJobPayloadChunkList[i];
+	}
+	gJobPayloadChunkList.clear();
+	gIdleWorkerList.clear();
+	gIdleWorkerCount = 0;
+	for (int i = 0; i < gJobSystemWorkerThreadCount; ++i)
+	{
+		gJobSystemWorkerList[i].Release();
+	}
+	gJobSystemWorkerList.clear();
+	ReleaseJobTrace();
 #else
 	if (startJobDescPtr && startJobDescPtr->entryPoint)
 	{
@@ -449,6 +1448,12 @@ void RunJobSystem(JobDescriptor* startJobDescPtr)
 void StopJobSystem()
 {
 	bJobSystemRuning = false;
+	// parked workers see the flag after waking up
+	for (int i = 0, ni = (int)gJobSystemWorkerList.size(); i < ni; ++i)
+	{
+		RemoveIdleWorker(i);
+		UnparkWorker(i);
+	}
 }
 
 void RunJobs(JobDescriptor* jobDescPtr, int count, JobWaitingCounter* waitingCounterPtr)
@@ -460,20 +1465,34 @@ void RunJobs(JobDescriptor* jobDescPtr, int count, JobWaitingCounter* waitingCou
 		//printf("RunJobs: counter %d\n", counter->load());
 	}
 
-	gJobQueueLock.LockReadWrite();
-
 	//printf("add job thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
-	
+
+	// push to the current worker's own queue, idle workers will steal from it
+	// jobs with a fixed processor go to that worker's mailbox
+	int workerIndex = GetCurrentWorkerIndex();
+#if JOB_STATS
+	int64_t queueTimeNs = GetJobSystemTimeNs();
+#else
+	int64_t queueTimeNs = 0;
+#endif
+	int generalJobCount = 0;
 	for (int i = 0; i < count; ++i)
 	{
-		REQueue<JobDescriptor>& targetQueue =
-			(jobDescPtr->priority == EJobPriority::Render) ? gRenderJobQueue : gJobQueue[(int)jobDescPtr->priority];
-		targetQueue.push(*jobDescPtr);
-		targetQueue.back().counterPtr = waitingCounterPtr;
+		JobDescriptor jobDesc = *jobDescPtr;
+		jobDesc.counterPtr = waitingCounterPtr;
+		jobDesc.queueTimeNs = queueTimeNs;
+		int queueLength = PushJob(workerIndex, jobDesc);
+		RecordJobPush(workerIndex, (int)jobDesc.priority, queueLength);
+		int fixedProcessor = GetJobFixedProcessor(jobDesc);
+		if (fixedProcessor >= 0)
+			WakeWorker(fixedProcessor);
+		else
+			++generalJobCount;
 		++jobDescPtr;
 	}
 
-	gJobQueueLock.UnlockReadWrite();
+	// one parked worker for each new job
+	WakeIdleWorkers(generalJobCount);
 #else
 	for (int i = 0; i < count; ++i)
 	{
@@ -488,13 +1507,18 @@ void WaitOnCounter(JobWaitingCounter* waitingCounterPtr, int waitingCounterTarge
 {
 #if USE_JOB_SYSTEM
 	if (CheckWaitingCounter(waitingCounterPtr, waitingCounterTarget))
+	{
+		waitingCounterPtr->WaitForWakers();
 		return;
+	}
 
-	JobFiberData* fiberDataPtr = (JobFiberData*)GetFiberData();
+	JobFiberData* fiberDataPtr = (JobFiberData*)GetCurrentJobFiberData();
 	fiberDataPtr->waitingCounterPtr = waitingCounterPtr;
 	fiberDataPtr->waitingCounterTarget = waitingCounterTarget;
 
-	void* fiber = GetCurrentFiber();
+	JobFiber* fiber = fiberDataPtr->fiber;
+
+	JOB_TRACE_EVENT(fiberDataPtr->currentProcessor, WaitBegin, waitingCounterPtr, fiberDataPtr, waitingCounterTarget);
 
 	//printf("WaitOnAndFreeCounter thread ID: %x, current processor: %d\n", GetCurrentThreadId(), GetCurrentProcessorNumber());
 
@@ -503,17 +1527,181 @@ void WaitOnCounter(JobWaitingCounter* waitingCounterPtr, int waitingCounterTarge
 
 	// check if we need to quit
 	if(!bJobSystemRuning)
-		SwitchToFiber(gJobSystemWorkerList[fiberDataPtr->currentProcessor].fiber);
+		SwitchToJobFiber(gJobSystemWorkerList[fiberDataPtr->currentProcessor].fiber);
 
 	// if we came back from another fiber, return previous fiber
 	ReturnPrevFiber(fiber, fiberDataPtr);
+
+	JOB_TRACE_EVENT(fiberDataPtr->currentProcessor, WaitEnd, waitingCounterPtr, fiberDataPtr, waitingCounterTarget);
+
+	// we might not have switched out at all (counter reached target while looking for a job)
+	fiberDataPtr->waitingCounterPtr = 0;
+	fiberDataPtr->waitingCounterTarget = 0;
+
+	// counter can go out of scope after we return
+	waitingCounterPtr->WaitForWakers();
+#endif
+}
+
+void JobYield()
+{
+#if USE_JOB_SYSTEM
+	if (GetCurrentWorkerIndex() < 0 || !bJobSystemRuning)
+		return;
+	JobFiberData* fiberDataPtr = (JobFiberData*)GetCurrentJobFiberData();
+	// worker thread fibers don't run jobs
+	if (fiberDataPtr->bThreadFiber)
+		return;
+	JobFiber* fiber = fiberDataPtr->fiber;
+
+	// we are queued again by whoever runs next, after we are switched out
+	fiberDataPtr->bYielding = true;
+	JobFiber* nextJobFiber = 0;
+	JobFiberData* nextJobFiberDataPtr = 0;
+	GetNextJobFiber(fiber, fiberDataPtr, fiberDataPtr->currentProcessor, nextJobFiber, nextJobFiberDataPtr);
+	if (!nextJobFiber)
+	{
+		// nothing else to run, carry on
+		fiberDataPtr->bYielding = false;
+		return;
+	}
+
+	JOB_TRACE_EVENT(fiberDataPtr->currentProcessor, FiberSwitch, fiberDataPtr, nextJobFiberDataPtr, 0);
+	SwitchToJobFiber(nextJobFiber);
+
+	// check if we need to quit
+	if (!bJobSystemRuning)
+		SwitchToJobFiber(gJobSystemWorkerList[fiberDataPtr->currentProcessor].fiber);
+
+	// resumed, maybe on another worker
+	ReturnPrevFiber(fiber, fiberDataPtr);
+#endif
+}
+
+bool IsCurrentJobCancelled()
+{
+#if USE_JOB_SYSTEM
+	if (GetCurrentWorkerIndex() < 0)
+		return false;
+	JobFiberData* fiberDataPtr = (JobFiberData*)GetCurrentJobFiberData();
+	return fiberDataPtr->cancellationTokenPtr && fiberDataPtr->cancellationTokenPtr->IsCancelled();
+#else
+	return false;
+#endif
+}
+
+JobScratchArena* GetCurrentJobScratchArena()
+{
+#if USE_JOB_SYSTEM
+	if (GetCurrentWorkerIndex() < 0)
+		return 0;
+	JobFiberData* fiberDataPtr = (JobFiberData*)GetCurrentJobFiberData();
+	// worker thread fibers don't run jobs
+	return fiberDataPtr->bThreadFiber ? 0 : &fiberDataPtr->scratchArena;
+#else
+	return 0;
+#endif
+}
+
+void GetJobWorkerStats(REArray<JobWorkerStats>& outStats)
+{
+	outStats.clear();
+#if USE_JOB_SYSTEM
+	int64_t runTime = GetJobSystemTimeNs() - gJobSystemStartTime;
+	outStats.resize(gJobSystemWorkerList.size());
+	for (int i = 0, ni = (int)gJobSystemWorkerList.size(); i < ni; ++i)
+	{
+		const JobWorkerIdleState* idleState = gJobSystemWorkerList[i].idleState;
+		outStats[i].runTimeNs = runTime;
+		outStats[i].idleTimeNs = idleState->idleTimeNs.load(std::memory_order_relaxed);
+		outStats[i].wakeCount = idleState->wakeCount.load(std::memory_order_relaxed);
+		outStats[i].totalWakeLatencyNs = idleState->totalWakeLatencyNs.load(std::memory_order_relaxed);
+		outStats[i].maxWakeLatencyNs = idleState->maxWakeLatencyNs.load(std::memory_order_relaxed);
+	}
+#endif
+}
+
+void GetJobPriorityStats(REArray<JobPriorityStats>& outStats)
+{
+	outStats.clear();
+#if USE_JOB_SYSTEM && JOB_STATS
+	if (gJobSystemWorkerList.empty())
+		return;
+	outStats.resize((int)EJobPriority::Count + 1);
+	for (int priority = 0; priority <= (int)EJobPriority::Count; ++priority)
+	{
+		JobPriorityStats& stats = outStats[priority];
+		int64_t pushCount = 0;
+		for (int i = 0, ni = (int)gJobSystemWorkerList.size() + 1; i < ni; ++i)
+		{
+			// external pushes last, they are never popped there
+			const JobPriorityCounters& counters = (i + 1 < ni) ? gJobSystemWorkerList[i].priorityCounters[priority] : gExternalJobCounters[priority];
+			pushCount += counters.pushCount.load(std::memory_order_relaxed);
+			stats.jobCount += counters.popCount.load(std::memory_order_relaxed);
+			stats.cancelledCount += counters.cancelCount.load(std::memory_order_relaxed);
+			stats.totalWaitTimeNs += counters.totalWaitTimeNs.load(std::memory_order_relaxed);
+			int64_t maxWaitTimeNs = counters.maxWaitTimeNs.load(std::memory_order_relaxed);
+			if (maxWaitTimeNs > stats.maxWaitTimeNs)
+				stats.maxWaitTimeNs = maxWaitTimeNs;
+			for (int bucket = 0; bucket < gJobStatsHistogramBucketCount; ++bucket)
+			{
+				stats.waitTimeHistogram[bucket] += counters.waitTimeHistogram[bucket].load(std::memory_order_relaxed);
+				stats.queueDepthHistogram[bucket] += counters.queueDepthHistogram[bucket].load(std::memory_order_relaxed);
+			}
+		}
+		// counters are read one after the other, don't show a negative depth
+		stats.queueDepth = (pushCount > stats.jobCount) ? pushCount - stats.jobCount : 0;
+	}
+#endif
+}
+
+bool TryRunLastJobInline(EJobPriority priority, void* jobDataPtr)
+{
+#if USE_JOB_SYSTEM
+	int workerIndex = GetCurrentWorkerIndex();
+	if (workerIndex < 0 || priority == EJobPriority::Render)
+		return false;
+
+	WorkStealingQueue<JobDescriptor>& jobQueue = gJobSystemWorkerList[workerIndex].jobQueues[(int)priority];
+	JobDescriptor jobDesc;
+	if (!jobQueue.Pop(jobDesc))
+		return false;
+	if (jobDesc.dataPtr != jobDataPtr)
+	{
+		// stolen, or something else was pushed after it (we might even be on another worker now), put it back
+		jobQueue.Push(jobDesc);
+		return false;
+	}
+	if (IsJobCancelled(jobDesc))
+	{
+		DropCancelledJob(gJobSystemWorkerList[workerIndex], jobDesc);
+		return true;
+	}
+	RecordJobPop(gJobSystemWorkerList[workerIndex], jobDesc);
+
+	// the job runs on our fiber, it sees its own token while it runs
+	JobFiberData* fiberDataPtr = (JobFiberData*)GetCurrentJobFiberData();
+	JobCancellationToken* prevCancellationTokenPtr = fiberDataPtr->cancellationTokenPtr;
+	fiberDataPtr->cancellationTokenPtr = jobDesc.cancellationTokenPtr;
+	// and shares our scratch arena, it gets back what the job allocated
+	JobScratchArena::Marker scratchMarker = fiberDataPtr->scratchArena.GetMarker();
+	JOB_TRACE_EVENT(workerIndex, JobBegin, (const void*)jobDesc.entryPoint, fiberDataPtr, 0);
+	jobDesc.entryPoint(jobDesc.dataPtr);
+	JOB_TRACE_EVENT(fiberDataPtr->currentProcessor, JobEnd, (const void*)jobDesc.entryPoint, fiberDataPtr, 0);
+	fiberDataPtr->scratchArena.Rewind(scratchMarker);
+	fiberDataPtr->cancellationTokenPtr = prevCancellationTokenPtr;
+	if (jobDesc.counterPtr)
+		jobDesc.counterPtr->Sub(1);
+	return true;
+#else
+	return false;
 #endif
 }
 
 int GetCurrentJobProcessor()
 {
 #if USE_JOB_SYSTEM
-	JobFiberData* fiberDataPtr = (JobFiberData*)GetFiberData();
+	JobFiberData* fiberDataPtr = (JobFiberData*)GetCurrentJobFiberData();
 	return fiberDataPtr->currentProcessor;
 #else
 	return 0;
@@ -3,26 +3,81 @@
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <cstdint>
+#include <cassert>
+#include <new>
 
+#include "Platform/Platform.h"
 #include "Containers/Containers.h"
+#include "Locks.h"
+#include "JobScratchArena.h"
 
 #define USE_JOB_SYSTEM 1
 
+// per priority queue depth and wait time stats (GetJobPriorityStats), costs a clock read for every job
+// set JOB_STATS to 0 in preprocessor definitions to compile them out
+#ifndef JOB_STATS
+#define JOB_STATS 1
+#endif
+
 extern int gJobSystemWorkerThreadCount;
 extern int gRenderProcessorIndex;
 
 typedef void(*JobEntryPoint)(void* customDataPtr);
 //typedef std::function<void(void*)> JobEntryPoint;
 
+struct JobFiberData;
+
+// counter value is packed with the waiting state in one atomic, so a finished job never touches
+// the counter again unless a fiber is parked on it (counters usually live on the waiting fiber's stack)
 class JobWaitingCounter
 {
 public:
-	__forceinline int Get() { return counter.load(std::memory_order_relaxed); }
-	__forceinline void Set(int value) { counter.store(value, std::memory_order_relaxed); }
-	__forceinline int Add(int value) { return counter.fetch_add(value, std::memory_order_relaxed); }
-	__forceinline int Sub(int value) { return counter.fetch_sub(value, std::memory_order_relaxed); }
+	__forceinline int Get() { return GetValue(state.load(std::memory_order_acquire)); }
+	__forceinline void Set(int value) { Modify(value, true); }
+	__forceinline int Add(int value) { return Modify(value, false); }
+	__forceinline int Sub(int value) { return Modify(-value, false); }
+
+	// park a fiber on this counter, it's moved to a ready queue once the counter reaches its target
+	void AddWaitingFiber(JobFiberData* fiberDataPtr);
+	// wait for other threads still waking fibers from this counter, call before the counter goes out of scope
+	void WaitForWakers();
+
 protected:
-	std::atomic<int> counter = 0;
+	static const int64_t VALUE_MASK = 0xFFFFFFFFll;
+	static const int64_t WAITING_BIT = 1ll << 32;
+	static const int64_t WAKER_ONE = 1ll << 33;
+	static const int64_t WAKER_MASK = ~(VALUE_MASK | WAITING_BIT);
+
+	static __forceinline int GetValue(int64_t inState) { return (int)(uint32_t)(inState & VALUE_MASK); }
+
+	// returns previous value
+	__forceinline int Modify(int value, bool bSet)
+	{
+		int64_t oldState = state.load(std::memory_order_relaxed);
+		int64_t newState;
+		do
+		{
+			int newValue = bSet ? value : GetValue(oldState) + value;
+			newState = (oldState & ~VALUE_MASK) | (uint32_t)newValue;
+			// someone is waiting, register as waker so the counter stays alive until we are done with it
+			if (oldState & WAITING_BIT)
+				newState += WAKER_ONE;
+		} while (!state.compare_exchange_weak(oldState, newState, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+		if (oldState & WAITING_BIT)
+			WakeWaitingFibers();
+
+		return GetValue(oldState);
+	}
+
+	void WakeWaitingFibers();
+	JobFiberData* RemoveReadyFibers();
+
+	std::atomic<int64_t> state = 0;
+	// intrusive list linked through JobFiberData::nextWaitingFiber
+	JobFiberData* waitingFiberList = 0;
+	SpinLock waitingFiberLock;
 };
 
 extern JobWaitingCounter gRenderFrameSyncCounter;
@@ -32,21 +87,49 @@ extern JobWaitingCounter gRenderFrameSyncCounter;
 #define JOB_LAMBDA_ENTRY_POINT(lambdaName, ...) auto lambdaName = [=, __VA_ARGS__](void* customDataPtr)
 #define JOB_LAMBDA_REF_ENTRY_POINT(lambdaName, ...) auto lambdaName = [&, __VA_ARGS__](void* customDataPtr)
 
+// fixed size blocks for job payloads (lambda captures), recycled through per-worker free lists
+// wrappers up to gJobPayloadSize bytes never touch the heap once the pool is warm
+const int gJobPayloadSize = 128;
+const int gJobPayloadAlignment = 16;
+// blocks created when the job system starts (512KB), can be changed before RunJobSystem
+extern int gJobPayloadInitialCount;
+extern void* AllocateJobPayload();
+// can be called from any worker, not only the one that allocated it
+extern void FreeJobPayload(void* payloadPtr);
+
+enum class EJobLambdaStorage
+{
+	// owned by the caller (blocking macros keep it on the stack)
+	Local,
+	Pooled,
+	// captures too big for a payload block
+	Heap,
+};
+
 template<class TLambda>
 struct JobLambdaWrapper
 {
 	const TLambda func;
 	void* dataPtr;
-	bool bHeap;
+	EJobLambdaStorage storage;
 
 	JobLambdaWrapper(const TLambda& inFunc, void* inDataPtr)
-		: func(std::move(inFunc)), dataPtr(inDataPtr), bHeap(false)
+		: func(std::move(inFunc)), dataPtr(inDataPtr), storage(EJobLambdaStorage::Local)
 	{}
 
 	static JobLambdaWrapper* Create(const TLambda& inFunc, void* inDataPtr)
 	{
-		JobLambdaWrapper* wrapper = new JobLambdaWrapper<TLambda>(inFunc, inDataPtr);
-		wrapper->bHeap = true;
+		JobLambdaWrapper* wrapper = 0;
+		if (sizeof(JobLambdaWrapper) <= gJobPayloadSize && alignof(JobLambdaWrapper) <= gJobPayloadAlignment)
+		{
+			wrapper = new (AllocateJobPayload()) JobLambdaWrapper<TLambda>(inFunc, inDataPtr);
+			wrapper->storage = EJobLambdaStorage::Pooled;
+		}
+		else
+		{
+			wrapper = new JobLambdaWrapper<TLambda>(inFunc, inDataPtr);
+			wrapper->storage = EJobLambdaStorage::Heap;
+		}
 		return wrapper;
 	}
 
@@ -54,8 +137,15 @@ struct JobLambdaWrapper
 	{
 		JobLambdaWrapper* wrapper = (JobLambdaWrapper*)customDataPtr;
 		wrapper->func(wrapper->dataPtr);
-		if (wrapper->bHeap)
+		if (wrapper->storage == EJobLambdaStorage::Pooled)
+		{
+			wrapper->~JobLambdaWrapper();
+			FreeJobPayload(wrapper);
+		}
+		else if (wrapper->storage == EJobLambdaStorage::Heap)
+		{
 			delete wrapper;
+		}
 	}
 };
 
@@ -70,30 +160,261 @@ enum class EJobPriority
 	Render = Count,
 };
 
+// weighted round robin between priorities, each priority in turn is looked at first for its weight worth of jobs,
+// so a stream of High jobs can't starve Low ones (with { 8, 3, 1 } Low gets at least 1 of every 12 jobs a worker runs)
+// priorities without work don't hold the turn up, weights <= 0 count as 1
+// can be changed before RunJobSystem
+extern int gJobPriorityWeights[(int)EJobPriority::Count];
+
+// fiber stack size classes, a job runs on a fiber from the smallest class that fits JobDescriptor::stackSize
+enum class EJobStackSize
+{
+	Small = 0,
+	// used when stackSize is 0
+	Medium,
+	Large,
+	Count,
+};
+
+const int gJobSmallStackSize = 16 * 1024;
+const int gJobMediumStackSize = 64 * 1024;
+const int gJobLargeStackSize = 512 * 1024;
+
+struct JobFiberPoolDesc
+{
+	int stackSize;
+	// created when the job system starts
+	int initialCount;
+	// pool grows on demand up to this, after that jobs stay queued until a fiber is free
+	int maxCount;
+};
+
+// can be changed before RunJobSystem
+extern JobFiberPoolDesc gJobFiberPoolDescs[(int)EJobStackSize::Count];
+
+// set JobDescriptor::cancellationTokenPtr, a job that hasn't started when its token is cancelled is dropped,
+// its counter is still decremented but its data is never touched (free it yourself), running jobs check IsCurrentJobCancelled
+// the token must outlive every job using it, like a counter
+class JobCancellationToken
+{
+public:
+	__forceinline void Cancel() { bCancelled.store(true, std::memory_order_release); }
+	__forceinline bool IsCancelled() const { return bCancelled.load(std::memory_order_acquire); }
+	// only once no job using it is queued anymore
+	__forceinline void Reset() { bCancelled.store(false, std::memory_order_relaxed); }
+
+protected:
+	std::atomic<bool> bCancelled = false;
+};
+
 struct JobDescriptor
 {
 	JobEntryPoint entryPoint = 0;
 	void* dataPtr = 0;
 	int stackSize = 0;
 	EJobPriority priority = EJobPriority::Normal;
+	// only this worker runs the job, and resumes it after a wait (e.g. a thread owning an IO or audio device)
+	// -1 means any worker, render jobs always go to gRenderProcessorIndex
+	int fixedProcessor = -1;
+	JobCancellationToken* cancellationTokenPtr = 0;
 
-	// counter is assigned by job system call
+	// counter and queue time are assigned by job system call
 	JobWaitingCounter* counterPtr = 0;
+	int64_t queueTimeNs = 0;
 
 	JobDescriptor() {}
 
-	JobDescriptor(const JobEntryPoint& inEntryPoint, void* inDataPtr = 0, EJobPriority inPriority = EJobPriority::Normal)
-		: entryPoint(inEntryPoint), dataPtr(inDataPtr), priority(inPriority)
+	JobDescriptor(const JobEntryPoint& inEntryPoint, void* inDataPtr = 0, EJobPriority inPriority = EJobPriority::Normal, int inStackSize = 0)
+		: entryPoint(inEntryPoint), dataPtr(inDataPtr), stackSize(inStackSize), priority(inPriority)
 	{}
 };
 
-extern void RunJobSystem(JobDescriptor* startJobDescPtr);
+// workerThreadCount <= 0 means use hardware_concurrency() - 2
+// returns after StopJobSystem() is called, and can be called again after that
+extern void RunJobSystem(JobDescriptor* startJobDescPtr, int workerThreadCount = 0);
 extern void StopJobSystem();
 // if waitingCounterPtr != 0, all the jobs created will be add to that counter
 extern void RunJobs(JobDescriptor* jobDescPtr, int count = 1, JobWaitingCounter* waitingCounterPtr = 0);
 extern void WaitOnCounter(JobWaitingCounter* waitingCounterPtr, int waitingCounterTarget = 0);
 extern int GetCurrentJobProcessor();
 
+// queue the current job's fiber again at its priority, behind what's already queued, and run other work meanwhile
+// returns right away if there is nothing else to run, the job might continue on another worker (unless it has a fixed processor)
+extern void JobYield();
+// the running job's JobDescriptor::cancellationTokenPtr was cancelled, long jobs should check this now and then
+extern bool IsCurrentJobCancelled();
+
+// idle workers park instead of spinning, these are accumulated since RunJobSystem
+struct JobWorkerStats
+{
+	int64_t runTimeNs = 0;
+	// time spent parked
+	int64_t idleTimeNs = 0;
+	// from the wake up request to the worker running again
+	int64_t wakeCount = 0;
+	int64_t totalWakeLatencyNs = 0;
+	int64_t maxWakeLatencyNs = 0;
+};
+
+extern void GetJobWorkerStats(REArray<JobWorkerStats>& outStats);
+
+// log2 buckets, 0 is < 1 (us for wait time, jobs for queue depth), i is [2^(i-1), 2^i), the last one also takes everything above
+const int gJobStatsHistogramBucketCount = 16;
+
+// one per priority, EJobPriority::Render included, accumulated since RunJobSystem, empty if JOB_STATS is 0
+struct JobPriorityStats
+{
+	// queued and not picked up yet, approximate
+	int64_t queueDepth = 0;
+	int64_t jobCount = 0;
+	// dropped before they started, included in jobCount
+	int64_t cancelledCount = 0;
+	// from RunJobs to a worker picking the job up
+	int64_t totalWaitTimeNs = 0;
+	int64_t maxWaitTimeNs = 0;
+	int64_t waitTimeHistogram[gJobStatsHistogramBucketCount];
+	// length of the queue a job was pushed to, including itself
+	int64_t queueDepthHistogram[gJobStatsHistogramBucketCount];
+
+	JobPriorityStats()
+	{
+		for (int i = 0; i < gJobStatsHistogramBucketCount; ++i)
+		{
+			waitTimeHistogram[i] = 0;
+			queueDepthHistogram[i] = 0;
+		}
+	}
+};
+
+extern void GetJobPriorityStats(REArray<JobPriorityStats>& outStats);
+
+// pops the job we just pushed from the current worker's queue if nobody stole it yet, and runs it on the current fiber (and its stack)
+extern bool TryRunLastJobInline(EJobPriority priority, void* jobDataPtr);
+
+// data parallel loops
+// range is halved recursively, the upper half becomes a job for idle workers to steal and the lower half runs here,
+// so big chunks are stolen first. Every split lives on the stack of the fiber that made it, nothing is allocated.
+// grainSize is the max count of indices processed without splitting
+template<class TFunc>
+struct ParallelForTask
+{
+	const TFunc& func;
+	int begin;
+	int end;
+	int grainSize;
+	EJobPriority priority;
+
+	JOB_METHOD_ENTRY_POINT(Run)
+	{
+		ParallelForTask* task = (ParallelForTask*)customDataPtr;
+		task->Execute();
+	}
+
+	void Execute()
+	{
+#if USE_JOB_SYSTEM
+		if (end - begin > grainSize)
+		{
+			int mid = begin + (end - begin) / 2;
+			ParallelForTask upperTask = { func, mid, end, grainSize, priority };
+			JobDescriptor jobDesc(&Run, &upperTask, priority);
+			JobWaitingCounter counter;
+			RunJobs(&jobDesc, 1, &counter);
+
+			ParallelForTask lowerTask = { func, begin, mid, grainSize, priority };
+			lowerTask.Execute();
+
+			// nobody took the upper half, run it here without a fiber switch
+			TryRunLastJobInline(priority, &upperTask);
+			WaitOnCounter(&counter);
+			return;
+		}
+#endif
+		func(begin, end);
+	}
+};
+
+template<class T, class TFunc, class TReduce>
+struct ParallelReduceTask
+{
+	const TFunc& func;
+	const TReduce& reduce;
+	const T& identity;
+	int begin;
+	int end;
+	int grainSize;
+	EJobPriority priority;
+	T result;
+
+	JOB_METHOD_ENTRY_POINT(Run)
+	{
+		ParallelReduceTask* task = (ParallelReduceTask*)customDataPtr;
+		task->Execute();
+	}
+
+	void Execute()
+	{
+#if USE_JOB_SYSTEM
+		if (end - begin > grainSize)
+		{
+			int mid = begin + (end - begin) / 2;
+			ParallelReduceTask upperTask = { func, reduce, identity, mid, end, grainSize, priority, identity };
+			JobDescriptor jobDesc(&Run, &upperTask, priority);
+			JobWaitingCounter counter;
+			RunJobs(&jobDesc, 1, &counter);
+
+			ParallelReduceTask lowerTask = { func, reduce, identity, begin, mid, grainSize, priority, identity };
+			lowerTask.Execute();
+
+			TryRunLastJobInline(priority, &upperTask);
+			WaitOnCounter(&counter);
+
+			// always lower then upper, result doesn't depend on who ran what
+			result = lowerTask.result;
+			reduce(result, upperTask.result);
+			return;
+		}
+#endif
+		func(begin, end, result);
+	}
+};
+
+// func(int chunkBegin, int chunkEnd)
+template<class TFunc>
+void ParallelForChunked(int begin, int end, int grainSize, const TFunc& func, EJobPriority priority = EJobPriority::Normal)
+{
+	// render jobs don't go to the worker queues
+	assert(priority != EJobPriority::Render);
+	if (begin >= end)
+		return;
+	ParallelForTask<TFunc> task = { func, begin, end, (grainSize > 0) ? grainSize : 1, priority };
+	task.Execute();
+}
+
+// func(int index)
+template<class TFunc>
+void ParallelFor(int begin, int end, int grainSize, const TFunc& func, EJobPriority priority = EJobPriority::Normal)
+{
+	ParallelForChunked(begin, end, grainSize, [&func](int chunkBegin, int chunkEnd)
+	{
+		for (int i = chunkBegin; i < chunkEnd; ++i)
+			func(i);
+	}, priority);
+}
+
+// func(int chunkBegin, int chunkEnd, T& result) accumulates a chunk into result (starts as identity)
+// reduce(T& result, const T& other) merges other into result
+template<class T, class TFunc, class TReduce>
+T ParallelReduce(int begin, int end, int grainSize, const T& identity, const TFunc& func, const TReduce& reduce, EJobPriority priority = EJobPriority::Normal)
+{
+	assert(priority != EJobPriority::Render);
+	if (begin >= end)
+		return identity;
+	ParallelReduceTask<T, TFunc, TReduce> task = { func, reduce, identity, begin, end, (grainSize > 0) ? grainSize : 1, priority, identity };
+	task.Execute();
+	return task.result;
+}
+
 extern void AssertFreeFiber();
 
 
@@ -112,7 +433,7 @@ JOB_LAMBDA_REF_ENTRY_POINT(lambda, __VA_ARGS__) { code };\
 JobLambdaWrapper<decltype(lambda)> wrapper(lambda, inCustomDataPtr);\
 JobDescriptor desc(&JobLambdaWrapper<decltype(lambda)>::Callback, &wrapper, priority);\
 JobWaitingCounter counter;\
-RunJobs(&desc, 1, counterPtr);\
+RunJobs(&desc, 1, &counter);\
 WaitOnCounter(&counter);\
 }
 
@@ -127,7 +448,7 @@ if(GetCurrentJobProcessor() == gRenderProcessorIndex)\
 else\
 {\
 	auto wrapperPtr = JobLambdaWrapper<decltype(lambda)>::Create(lambda, 0);\
-	JobDescriptor desc(&JobLambdaWrapper<decltype(lambda)>::Callback, wrapperPtr, EJobPriority::Render);\
+	JobDescriptor desc(&JobLambdaWrapper<decltype(lambda)>::Callback, wrapperPtr, EJobPriority::Render, gJobLargeStackSize);\
 	RunJobs(&desc, 1, &gRenderFrameSyncCounter);\
 }\
 }
@@ -142,7 +463,7 @@ if(GetCurrentJobProcessor() == gRenderProcessorIndex)\
 else\
 {\
 	JobLambdaWrapper<decltype(lambda)> wrapper(lambda, 0);\
-	JobDescriptor desc(&JobLambdaWrapper<decltype(lambda)>::Callback, &wrapper, EJobPriority::Render);\
+	JobDescriptor desc(&JobLambdaWrapper<decltype(lambda)>::Callback, &wrapper, EJobPriority::Render, gJobLargeStackSize);\
 	JobWaitingCounter counter;\
 	RunJobs(&desc, 1, &counter);\
 	WaitOnCounter(&counter);\
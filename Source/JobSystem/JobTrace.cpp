@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <cassert>
+#include <algorithm>
+
+#include "Containers/Containers.h"
+#include "JobTrace.h"
+
+extern int gRenderProcessorIndex;
+
+JobTraceBuffer* gJobTraceBuffers = 0;
+int gJobTraceBufferCount = 0;
+
+// trace clock and steady clock taken together, to get trace clock rate when dumping
+int64_t gJobTraceStartTime = 0;
+int64_t gJobTraceStartTimeNs = 0;
+
+__forceinline int64_t GetJobTraceSteadyTimeNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void InitJobTrace(int workerCount)
+{
+#if JOB_TRACE
+	assert(!gJobTraceBuffers);
+	gJobTraceBuffers = new JobTraceBuffer[workerCount];
+	for (int i = 0; i < workerCount; ++i)
+	{
+		gJobTraceBuffers[i].events = new JobTraceEvent[gJobTraceBufferSize];
+	}
+	gJobTraceStartTimeNs = GetJobTraceSteadyTimeNs();
+	gJobTraceStartTime = GetJobTraceTime();
+	gJobTraceBufferCount = workerCount;
+#endif
+}
+
+void ReleaseJobTrace()
+{
+#if JOB_TRACE
+	for (int i = 0; i < gJobTraceBufferCount; ++i)
+	{
+		delete[] gJobTraceBuffers[i].events;
+	}
+	gJobTraceBufferCount = 0;
+	delete[] gJobTraceBuffers;
+	gJobTraceBuffers = 0;
+#endif
+}
+
+struct JobTraceDumpEvent
+{
+	JobTraceEvent event;
+	int processorIndex;
+};
+
+// a job running on a fiber, split into slices when the fiber waits and resumes (maybe on another worker)
+struct JobTraceOpenSlice
+{
+	const void* entryPoint;
+	int64_t startTime;
+};
+
+struct JobTraceFiberState
+{
+	REArray<JobTraceOpenSlice> openSlices;
+	int64_t waitStartTime = 0;
+	const void* waitCounter = 0;
+	int waitProcessorIndex = 0;
+};
+
+void WriteJobTraceSlice(FILE* file, bool& bFirst, const char* name, const void* ptr, int processorIndex, double startUs, double endUs)
+{
+	fprintf(file, "%s\n\t\t{ \"name\": \"%s 0x%llx\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f }",
+		bFirst ? "" : ",", name, (unsigned long long)(uintptr_t)ptr, processorIndex, startUs, endUs - startUs);
+	bFirst = false;
+}
+
+bool DumpJobTrace(const char* fileName)
+{
+#if JOB_TRACE
+	if (gJobTraceBufferCount == 0)
+		return false;
+
+	// clock rate from the whole run so far
+	double ticksPerUs = (double)(GetJobTraceTime() - gJobTraceStartTime) / ((GetJobTraceSteadyTimeNs() - gJobTraceStartTimeNs) / 1000.0);
+	if (ticksPerUs <= 0)
+		return false;
+
+	// copy everything still in the buffers, writers keep going
+	REArray<JobTraceDumpEvent> dumpEvents;
+	for (int processorIndex = 0; processorIndex < gJobTraceBufferCount; ++processorIndex)
+	{
+		JobTraceBuffer& buffer = gJobTraceBuffers[processorIndex];
+		uint64_t endIndex = buffer.writeIndex.load(std::memory_order_acquire);
+		uint64_t beginIndex = (endIndex > (uint64_t)gJobTraceBufferSize) ? endIndex - gJobTraceBufferSize : 0;
+		size_t firstDumpEvent = dumpEvents.size();
+		for (uint64_t i = beginIndex; i < endIndex; ++i)
+		{
+			JobTraceDumpEvent dumpEvent;
+			dumpEvent.event = buffer.events[i & (gJobTraceBufferSize - 1)];
+			dumpEvent.processorIndex = processorIndex;
+			dumpEvents.push_back(dumpEvent);
+		}
+		// drop the ones overwritten while we were copying
+		uint64_t newEndIndex = buffer.writeIndex.load(std::memory_order_acquire);
+		if (newEndIndex > beginIndex + gJobTraceBufferSize)
+		{
+			size_t overwrittenCount = (size_t)std::min<uint64_t>(newEndIndex - gJobTraceBufferSize - beginIndex, endIndex - beginIndex);
+			dumpEvents.erase(dumpEvents.begin() + firstDumpEvent, dumpEvents.begin() + firstDumpEvent + overwrittenCount);
+		}
+	}
+	if (dumpEvents.empty())
+		return false;
+
+	std::stable_sort(dumpEvents.begin(), dumpEvents.end(), [](const JobTraceDumpEvent& a, const JobTraceDumpEvent& b)
+	{
+		return a.event.time < b.event.time;
+	});
+
+	FILE* file = 0;
+#if defined(_MSC_VER)
+	// fopen is an error with SDL checks on
+	fopen_s(&file, fileName, "w");
+#else
+	file = fopen(fileName, "w");
+#endif
+	if (!file)
+		return false;
+
+	int64_t baseTime = dumpEvents[0].event.time;
+	auto toUs = [baseTime, ticksPerUs](int64_t time) { return (time - baseTime) / ticksPerUs; };
+
+	fprintf(file, "{\n\t\"displayTimeUnit\": \"ns\",\n\t\"traceEvents\": [");
+	bool bFirst = true;
+	for (int processorIndex = 0; processorIndex < gJobTraceBufferCount; ++processorIndex)
+	{
+		fprintf(file, "%s\n\t\t{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"args\": { \"name\": \"%s %d\" } }",
+			bFirst ? "" : ",", processorIndex, (processorIndex == gRenderProcessorIndex) ? "render worker" : "worker", processorIndex);
+		bFirst = false;
+	}
+
+	REMap<const void*, JobTraceFiberState> fiberStates;
+	REArray<int64_t> idleStartTimes(gJobTraceBufferCount, -1);
+	for (int i = 0, ni = (int)dumpEvents.size(); i < ni; ++i)
+	{
+		const JobTraceEvent& event = dumpEvents[i].event;
+		int processorIndex = dumpEvents[i].processorIndex;
+		switch (event.type)
+		{
+		case EJobTraceEvent::JobBegin:
+		{
+			JobTraceOpenSlice slice = { event.ptr, event.time };
+			fiberStates[event.data].openSlices.push_back(slice);
+			break;
+		}
+		case EJobTraceEvent::JobEnd:
+		{
+			// begin might be older than the buffer
+			REArray<JobTraceOpenSlice>& openSlices = fiberStates[event.data].openSlices;
+			if (!openSlices.empty())
+			{
+				WriteJobTraceSlice(file, bFirst, "job", openSlices.back().entryPoint, processorIndex, toUs(openSlices.back().startTime), toUs(event.time));
+				openSlices.pop_back();
+			}
+			break;
+		}
+		case EJobTraceEvent::WaitBegin:
+		{
+			// close what runs on this fiber, reopened where it resumes
+			JobTraceFiberState& fiberState = fiberStates[event.data];
+			for (int j = 0; j < (int)fiberState.openSlices.size(); ++j)
+			{
+				WriteJobTraceSlice(file, bFirst, "job", fiberState.openSlices[j].entryPoint, processorIndex, toUs(fiberState.openSlices[j].startTime), toUs(event.time));
+			}
+			fiberState.waitStartTime = event.time;
+			fiberState.waitCounter = event.ptr;
+			fiberState.waitProcessorIndex = processorIndex;
+			break;
+		}
+		case EJobTraceEvent::WaitEnd:
+		{
+			JobTraceFiberState& fiberState = fiberStates[event.data];
+			for (int j = 0; j < (int)fiberState.openSlices.size(); ++j)
+			{
+				fiberState.openSlices[j].startTime = event.time;
+			}
+			if (fiberState.waitCounter == event.ptr)
+			{
+				// async slice, it starts and ends on different workers
+				fprintf(file, ",\n\t\t{ \"name\": \"wait 0x%llx\", \"cat\": \"wait\", \"ph\": \"b\", \"id\": \"0x%llx\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f }",
+					(unsigned long long)(uintptr_t)event.ptr, (unsigned long long)(uintptr_t)event.data, fiberState.waitProcessorIndex, toUs(fiberState.waitStartTime));
+				fprintf(file, ",\n\t\t{ \"name\": \"wait 0x%llx\", \"cat\": \"wait\", \"ph\": \"e\", \"id\": \"0x%llx\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f }",
+					(unsigned long long)(uintptr_t)event.ptr, (unsigned long long)(uintptr_t)event.data, processorIndex, toUs(event.time));
+			}
+			fiberState.waitCounter = 0;
+			break;
+		}
+		case EJobTraceEvent::FiberSwitch:
+			fprintf(file, ",\n\t\t{ \"name\": \"fiber switch\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"args\": { \"from\": \"0x%llx\", \"to\": \"0x%llx\" } }",
+				processorIndex, toUs(event.time), (unsigned long long)(uintptr_t)event.ptr, (unsigned long long)(uintptr_t)event.data);
+			break;
+		case EJobTraceEvent::Steal:
+			fprintf(file, ",\n\t\t{ \"name\": \"steal\", \"ph\": \"i\", \"s\": \"t\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"args\": { \"victim\": %d } }",
+				processorIndex, toUs(event.time), event.arg);
+			break;
+		case EJobTraceEvent::IdleBegin:
+			idleStartTimes[processorIndex] = event.time;
+			break;
+		case EJobTraceEvent::IdleEnd:
+			if (idleStartTimes[processorIndex] >= 0)
+			{
+				fprintf(file, ",\n\t\t{ \"name\": \"idle\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f }",
+					processorIndex, toUs(idleStartTimes[processorIndex]), toUs(event.time) - toUs(idleStartTimes[processorIndex]));
+				idleStartTimes[processorIndex] = -1;
+			}
+			break;
+		}
+	}
+
+	fprintf(file, "\n\t]\n}\n");
+	fclose(file);
+	return true;
+#else
+	return false;
+#endif
+}
\ No newline at end of file
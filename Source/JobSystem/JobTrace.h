@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <chrono>
+
+#include "Platform/Platform.h"
+
+// per worker ring buffer of scheduler events, dumped on demand as a Chrome trace (chrome://tracing, ui.perfetto.dev)
+// set JOB_TRACE to 0 in preprocessor definitions to compile every record call out
+#ifndef JOB_TRACE
+#define JOB_TRACE 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+enum class EJobTraceEvent : uint32_t
+{
+	// ptr = entry point, data = fiber
+	JobBegin,
+	JobEnd,
+	// ptr = counter, data = fiber
+	WaitBegin,
+	WaitEnd,
+	// ptr = from fiber, data = to fiber
+	FiberSwitch,
+	// arg = victim worker
+	Steal,
+	// worker parked
+	IdleBegin,
+	IdleEnd,
+};
+
+struct JobTraceEvent
+{
+	int64_t time;
+	const void* ptr;
+	const void* data;
+	EJobTraceEvent type;
+	int arg;
+};
+
+// events per worker, oldest are overwritten (2MB per worker)
+const int gJobTraceBufferSize = 64 * 1024;
+
+struct JobTraceBuffer
+{
+	JobTraceEvent* events = 0;
+	// only the owning worker writes, dump reads it from any thread
+	std::atomic<uint64_t> writeIndex = 0;
+};
+
+extern JobTraceBuffer* gJobTraceBuffers;
+extern int gJobTraceBufferCount;
+
+// rdtsc where we have it, converted to microseconds when dumping
+__forceinline int64_t GetJobTraceTime()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return (int64_t)__rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+__forceinline void RecordJobTraceEvent(int processorIndex, EJobTraceEvent type, const void* ptr, const void* data, int arg)
+{
+	if (processorIndex < 0 || processorIndex >= gJobTraceBufferCount)
+		return;
+	JobTraceBuffer& buffer = gJobTraceBuffers[processorIndex];
+	uint64_t writeIndex = buffer.writeIndex.load(std::memory_order_relaxed);
+	JobTraceEvent& event = buffer.events[writeIndex & (gJobTraceBufferSize - 1)];
+	event.time = GetJobTraceTime();
+	event.ptr = ptr;
+	event.data = data;
+	event.type = type;
+	event.arg = arg;
+	buffer.writeIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+#if JOB_TRACE
+#define JOB_TRACE_EVENT(processorIndex, type, ptr, data, arg) RecordJobTraceEvent(processorIndex, EJobTraceEvent::type, ptr, data, arg)
+#else
+#define JOB_TRACE_EVENT(processorIndex, type, ptr, data, arg)
+#endif
+
+// called by RunJobSystem
+extern void InitJobTrace(int workerCount);
+extern void ReleaseJobTrace();
+
+// can be called while jobs are running, events written during the dump may be missing
+// returns false if there is nothing to dump or the file can't be written
+extern bool DumpJobTrace(const char* fileName);
\ No newline at end of file
@@ -1,18 +1,147 @@
 #pragma once
 
 #include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <chrono>
+#include <thread>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "Platform/Platform.h"
+
+// per lock contention counters (GetContentionStats), costs an atomic add on every acquire
+// set LOCK_STATS to 1 in preprocessor definitions to turn them on
+#ifndef LOCK_STATS
+#define LOCK_STATS 0
+#endif
+
+__forceinline void CpuPause()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	_mm_pause();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+	__yield();
+#elif defined(__x86_64__) || defined(__i386__)
+	_mm_pause();
+#elif defined(__aarch64__)
+	asm volatile("yield");
+#endif
+}
+
+// exponential backoff for lock waiting loops, pause 1, 2, 4 .. times, then give the core away
+class LockBackoff
+{
+public:
+	__forceinline void Pause()
+	{
+		if (pauseCount <= MAX_PAUSE_COUNT)
+		{
+			for (int i = 0; i < pauseCount; ++i)
+				CpuPause();
+			pauseCount <<= 1;
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+		++spinCount;
+	}
+
+	int spinCount = 0;
+
+protected:
+	static const int MAX_PAUSE_COUNT = 64;
+	int pauseCount = 1;
+};
+
+// all zero if LOCK_STATS is 0
+struct LockContentionStats
+{
+	int64_t acquireCount = 0;
+	// acquires that had to wait
+	int64_t contendedCount = 0;
+	// backoff rounds over all acquires
+	int64_t spinCount = 0;
+	int64_t maxWaitNs = 0;
+};
+
+class LockContentionCounters
+{
+public:
+	__forceinline void AddAcquire()
+	{
+#if LOCK_STATS
+		acquireCount.fetch_add(1, std::memory_order_relaxed);
+#endif
+	}
+
+	__forceinline int64_t GetWaitStartTime()
+	{
+#if LOCK_STATS
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+		return 0;
+#endif
+	}
+
+	__forceinline void AddContendedAcquire(const LockBackoff& backoff, int64_t waitStartTime)
+	{
+#if LOCK_STATS
+		int64_t waitNs = GetWaitStartTime() - waitStartTime;
+		acquireCount.fetch_add(1, std::memory_order_relaxed);
+		contendedCount.fetch_add(1, std::memory_order_relaxed);
+		spinCount.fetch_add(backoff.spinCount, std::memory_order_relaxed);
+		int64_t maxWaitNs = maxWaitNsValue.load(std::memory_order_relaxed);
+		while (waitNs > maxWaitNs && !maxWaitNsValue.compare_exchange_weak(maxWaitNs, waitNs, std::memory_order_relaxed))
+			;
+#else
+		(void)backoff;
+		(void)waitStartTime;
+#endif
+	}
+
+	LockContentionStats GetStats() const
+	{
+		LockContentionStats stats;
+#if LOCK_STATS
+		stats.acquireCount = acquireCount.load(std::memory_order_relaxed);
+		stats.contendedCount = contendedCount.load(std::memory_order_relaxed);
+		stats.spinCount = spinCount.load(std::memory_order_relaxed);
+		stats.maxWaitNs = maxWaitNsValue.load(std::memory_order_relaxed);
+#endif
+		return stats;
+	}
+
+#if LOCK_STATS
+protected:
+	std::atomic<int64_t> acquireCount = 0;
+	std::atomic<int64_t> contendedCount = 0;
+	std::atomic<int64_t> spinCount = 0;
+	std::atomic<int64_t> maxWaitNsValue = 0;
+#endif
+};
+
+// test and test and set, waiters only read the lock until it looks free
 class SpinLock
 {
 public:
 	__forceinline void LockReadWrite()
 	{
-		while (lock.test_and_set(std::memory_order_acquire))
-			;
+		if (!lock.exchange(true, std::memory_order_acquire))
+		{
+			counters.AddAcquire();
+			return;
+		}
+		LockReadWriteContended();
 	}
 	__forceinline void UnlockReadWrite()
 	{
-		lock.clear(std::memory_order_release);
+		lock.store(false, std::memory_order_release);
 	}
 	__forceinline void LockReadOnly()
 	{
@@ -22,8 +151,24 @@ public:
 	{
 		UnlockReadWrite();
 	}
+
+	LockContentionStats GetContentionStats() const { return counters.GetStats(); }
+
 protected:
-	std::atomic_flag lock = ATOMIC_FLAG_INIT;
+	RE_NOINLINE void LockReadWriteContended()
+	{
+		LockBackoff backoff;
+		int64_t waitStartTime = counters.GetWaitStartTime();
+		do
+		{
+			while (lock.load(std::memory_order_relaxed))
+				backoff.Pause();
+		} while (lock.exchange(true, std::memory_order_acquire));
+		counters.AddContendedAcquire(backoff, waitStartTime);
+	}
+
+	std::atomic<bool> lock = false;
+	LockContentionCounters counters;
 };
 
 // http://joeduffyblog.com/2009/01/29/a-singleword-readerwriter-spin-lock/
@@ -32,42 +177,69 @@ class SpinLockReaderWriter
 public:
 	__forceinline void LockReadWrite()
 	{
-		int state = lock.load(std::memory_order_relaxed);
+		int state = 0;
+		// no writer and no reader, fast path
+		if (lock.compare_exchange_strong(state, MASK_WRITER_LOCK_BIT, std::memory_order_acq_rel))
+		{
+			counters.AddAcquire();
+			return;
+		}
+
+		LockBackoff backoff;
+		int64_t waitStartTime = counters.GetWaitStartTime();
 		while (1)
 		{
 			// if no writer and no reader (all 0 other than waiting bit)
 			if (((state & ~MASK_WRITER_WAITING_BIT) == 0))
 			{
-				// set to writer lock bit
-				if(lock.compare_exchange_strong(state, MASK_WRITER_LOCK_BIT, std::memory_order_acq_rel))
-					return;
+				// set to writer lock bit, a failed exchange reloads state
+				if (lock.compare_exchange_strong(state, MASK_WRITER_LOCK_BIT, std::memory_order_acq_rel))
+					break;
+				continue;
 			}
-			// otherwise set waiting bit if not set
+			// otherwise set waiting bit if not set, so new readers hold off
 			if ((state & MASK_WRITER_WAITING_BIT) == 0)
 			{
-				// we don't care if we failed here
-				lock.compare_exchange_strong(state, state | MASK_WRITER_WAITING_BIT, std::memory_order_acq_rel);
+				// failed exchange reloads state, look at it again
+				if (!lock.compare_exchange_strong(state, state | MASK_WRITER_WAITING_BIT, std::memory_order_acq_rel))
+					continue;
 			}
+			backoff.Pause();
+			state = lock.load(std::memory_order_relaxed);
 		}
+		counters.AddContendedAcquire(backoff, waitStartTime);
 	}
 	__forceinline void UnlockReadWrite()
 	{
-		int state = lock.load(std::memory_order_relaxed);
 		// only keep waiting bit in case other writer want to get in
-		lock.store(state & MASK_WRITER_WAITING_BIT, std::memory_order_release);
+		lock.fetch_and(MASK_WRITER_WAITING_BIT, std::memory_order_release);
 	}
 	__forceinline void LockReadOnly()
 	{
 		int state = lock.load(std::memory_order_relaxed);
+		// make sure we don't have writer, and we are not over max reader
+		if ((state & MASK_WRITER_BITS) == 0 && (state & MASK_READER_BITS) < MAX_READERS &&
+			lock.compare_exchange_strong(state, state + 1, std::memory_order_acq_rel))
+		{
+			counters.AddAcquire();
+			return;
+		}
+
+		LockBackoff backoff;
+		int64_t waitStartTime = counters.GetWaitStartTime();
 		while (1)
 		{
-			// make sure we don't have writer, and we are not over max reader
 			if ((state & MASK_WRITER_BITS) == 0 && (state & MASK_READER_BITS) < MAX_READERS)
 			{
+				// another reader got in first, state is reloaded, try again right away
 				if (lock.compare_exchange_strong(state, state + 1, std::memory_order_acq_rel))
-					return;
+					break;
+				continue;
 			}
+			backoff.Pause();
+			state = lock.load(std::memory_order_relaxed);
 		}
+		counters.AddContendedAcquire(backoff, waitStartTime);
 	}
 	__forceinline void UnlockReadOnly()
 	{
@@ -87,14 +259,17 @@ public:
 		}
 	}
 
+	LockContentionStats GetContentionStats() const { return counters.GetStats(); }
+
 protected:
 	std::atomic<int> lock = 0;
+	LockContentionCounters counters;
 
-	const int MASK_WRITER_LOCK_BIT = 0x80000000;
-	const int MASK_WRITER_WAITING_BIT = 0x40000000;
-	const int MASK_WRITER_BITS = MASK_WRITER_LOCK_BIT | MASK_WRITER_WAITING_BIT;
-	const int MASK_READER_BITS = ~MASK_WRITER_BITS;
-	const int MAX_READERS = 0x3FFFFFFF;
+	static const int MASK_WRITER_LOCK_BIT = (int)0x80000000;
+	static const int MASK_WRITER_WAITING_BIT = 0x40000000;
+	static const int MASK_WRITER_BITS = MASK_WRITER_LOCK_BIT | MASK_WRITER_WAITING_BIT;
+	static const int MASK_READER_BITS = ~MASK_WRITER_BITS;
+	static const int MAX_READERS = 0x3FFFFFFF;
 };
 
 template<class T, class TLock>
@@ -171,6 +346,12 @@ public:
 	{
 		lock.UnlockReadOnly();
 	}
+
+	// for profiling, all zero unless LOCK_STATS is 1
+	LockContentionStats GetLockStats() const
+	{
+		return lock.GetContentionStats();
+	}
 };
 
 #define SCOPED_READ_WRITE_REF(name, ref) decltype(name)::ReadWriteScope __##name_scope(name);\
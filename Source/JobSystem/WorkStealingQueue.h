@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cassert>
+
+#include "Platform/Platform.h"
+
+// Chase-Lev work stealing deque
+// https://www.di.ens.fr/~zappa/readings/ppopp13.pdf (Correct and Efficient Work-Stealing for Weak Memory Models)
+// owner thread pushes and pops at the bottom (LIFO), any other thread steals from the top (FIFO)
+template<class T>
+class WorkStealingQueue
+{
+public:
+	WorkStealingQueue(int inCapacity = 256)
+	{
+		// capacity must be power of 2
+		assert(inCapacity > 0 && (inCapacity & (inCapacity - 1)) == 0);
+		buffer.store(new Buffer(inCapacity, 0), std::memory_order_relaxed);
+	}
+
+	~WorkStealingQueue()
+	{
+		// free current buffer and all the retired ones
+		Buffer* bufferPtr = buffer.load(std::memory_order_relaxed);
+		while (bufferPtr)
+		{
+			Buffer* prevBufferPtr = bufferPtr->prev;
+			delete bufferPtr;
+			bufferPtr = prevBufferPtr;
+		}
+	}
+
+	// owner only
+	void Push(const T& value)
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_acquire);
+		Buffer* bufferPtr = buffer.load(std::memory_order_relaxed);
+		if (b - t > bufferPtr->mask)
+		{
+			bufferPtr = Grow(bufferPtr, t, b);
+		}
+		bufferPtr->data[b & bufferPtr->mask] = value;
+		std::atomic_thread_fence(std::memory_order_release);
+		bottom.store(b + 1, std::memory_order_relaxed);
+	}
+
+	// owner only
+	bool Pop(T& outValue)
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+		Buffer* bufferPtr = buffer.load(std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t t = top.load(std::memory_order_relaxed);
+
+		// empty, restore bottom
+		if (t > b)
+		{
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+
+		outValue = bufferPtr->data[b & bufferPtr->mask];
+		if (t == b)
+		{
+			// last element, race with thieves
+			bool bWon = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return bWon;
+		}
+		return true;
+	}
+
+	// any thread, can fail if we lose the race with another thief or the owner
+	bool Steal(T& outValue)
+	{
+		int64_t t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64_t b = bottom.load(std::memory_order_acquire);
+
+		if (t >= b)
+			return false;
+
+		Buffer* bufferPtr = buffer.load(std::memory_order_acquire);
+		T value = bufferPtr->data[t & bufferPtr->mask];
+		if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return false;
+
+		outValue = value;
+		return true;
+	}
+
+	// approximate, only for heuristics
+	__forceinline bool Empty() const
+	{
+		return Size() <= 0;
+	}
+
+	__forceinline int Size() const
+	{
+		int64_t b = bottom.load(std::memory_order_relaxed);
+		int64_t t = top.load(std::memory_order_relaxed);
+		return (int)(b - t);
+	}
+
+protected:
+	struct Buffer
+	{
+		int64_t mask;
+		T* data;
+		// retired buffers are kept alive until the queue is destroyed, a thief might still read from them
+		Buffer* prev;
+
+		Buffer(int64_t capacity, Buffer* inPrev) : mask(capacity - 1), data(new T[capacity]), prev(inPrev) {}
+		~Buffer() { delete[] data; }
+	};
+
+	Buffer* Grow(Buffer* oldBufferPtr, int64_t t, int64_t b)
+	{
+		Buffer* newBufferPtr = new Buffer((oldBufferPtr->mask + 1) * 2, oldBufferPtr);
+		for (int64_t i = t; i < b; ++i)
+		{
+			newBufferPtr->data[i & newBufferPtr->mask] = oldBufferPtr->data[i & oldBufferPtr->mask];
+		}
+		buffer.store(newBufferPtr, std::memory_order_release);
+		return newBufferPtr;
+	}
+
+	// keep top (thieves) and bottom (owner) on different cache lines
+	alignas(64) std::atomic<int64_t> top = 0;
+	alignas(64) std::atomic<int64_t> bottom = 0;
+	alignas(64) std::atomic<Buffer*> buffer = 0;
+
+private:
+	WorkStealingQueue(const WorkStealingQueue&);
+	WorkStealingQueue& operator=(const WorkStealingQueue&);
+};
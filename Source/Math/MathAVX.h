@@ -4,6 +4,9 @@
 
 #include "MathSSE.h"
 
+// the macros can be used without ENABLE_VEC256, in functions only called after checking the CPU (see MathCulling.h)
+// ENABLE_VEC256 builds the whole engine for AVX: the constants, VecSwizzle and VecSinCos below
+
 typedef __m256	Vec256;
 
 
@@ -13,6 +16,7 @@ typedef __m256	Vec256;
 
 #define Vec256Set_Vec128(v1, v2)		_mm256_setr_m128(v1, v2)
 
+#if ENABLE_VEC256
 namespace Vec256Const {
 
 	const Vec256 SignMask				= Vec256Set1_i(0x80000000);
@@ -26,17 +30,32 @@ namespace Vec256Const {
 	const Vec256 Vec_Half_PI			= Vec256Set1(PI*0.5f);
 	const Vec256 Vec_1_Over_2_PI		= Vec256Set1(0.5f / PI);
 };
+#endif
 
 // zero upper for ALL ymm registers
 // DO THIS before going back to SSE
 #define Vec256ZeroUpper()			_mm256_zeroupper()
 
-#define Vec256Abs(vec)				_mm256_and_ps(vec, Vec256Const::InvSignMask)
+// sign bit from -0.f, no global constant so it works without ENABLE_VEC256
+#define Vec256Abs(vec)				_mm256_andnot_ps(_mm256_set1_ps(-0.f), vec)
+#define Vec256Negate(vec)			_mm256_xor_ps(vec, _mm256_set1_ps(-0.f))
+
+#define Vec256Add(vec1, vec2)		_mm256_add_ps(vec1, vec2)
+#define Vec256Mul(vec1, vec2)		_mm256_mul_ps(vec1, vec2)
+#define Vec256Or(vec1, vec2)		_mm256_or_ps(vec1, vec2)
+#define Vec256CmpLT(vec1, vec2)		_mm256_cmp_ps(vec1, vec2, _CMP_LT_OQ)
+#define Vec256MoveMask(vec)			_mm256_movemask_ps(vec)
+
+// interleave two 128 lanes independently
+#define Vec256Interleave_0011(vec1, vec2)			_mm256_unpacklo_ps(vec1, vec2)
+#define Vec256Interleave_2233(vec1, vec2)			_mm256_unpackhi_ps(vec1, vec2)
 
+#if ENABLE_VEC256
 // re-define VecSwizzle using new instruction
 #undef VecSwizzle
 // vec(0, 1, 2, 3) -> (vec[x], vec[y], vec[z], vec[w])
 #define VecSwizzle(vec, x, y, z, w)					_mm_permute_ps(vec, MakeShuffleMask(x,y,z,w))
+#endif
 // swizzle two 128 lanes independently
 #define Vec256Swizzle(vec, x, y, z, w)				_mm256_permute_ps(vec, MakeShuffleMask(x,y,z,w))
 
@@ -49,6 +68,7 @@ namespace Vec256Const {
 #define Vec256SelectOrZero(vec1, vec2, x, y)		_mm256_permute2f128_ps(vec1, vec2, (x) | (y<<4))
 
 
+#if ENABLE_VEC256
 // same method as VecSin in MathSSE.h
 __forceinline void VecSinCos(Vec128 vec, Vec128& outSin, Vec128& outCos)
 {
@@ -63,4 +83,5 @@ __forceinline void VecSinCos(Vec128 vec, Vec128& outSin, Vec128& outCos)
 	y = _mm256_mul_ps(y, _mm256_add_ps(Vec256Abs(y), SinParamB));
 	outCos = _mm256_extractf128_ps(y, 1);
 	outSin = _mm256_castps256_ps128(y);
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,451 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+#include "REMath.h"
+#include "MathAVX.h"
+
+// batch versions of IsOBBIntersectFrustum and IsSphereIntersectFrustum, 4, 8 or 16 objects per iteration
+// objects are read with a stride so they can stay where they are (gMeshCullData OBBs, gPointLights sphere bounds)
+// and transposed in registers, the result is a bitmask: bit i of outVisibleMask[i / 32] is object i
+// the math is done in the same order as the single object functions without FMA (see CULLING_TARGET_*), so results are identical
+
+// AVX-512 intrinsics need VS2017 15.3, older compilers only get SSE4.1 and AVX2
+#if !defined(_MSC_VER) || _MSC_VER >= 1911
+#define CULLING_AVX512 1
+#else
+#define CULLING_AVX512 0
+#endif
+
+// MSVC takes any intrinsic anywhere, gcc and clang want the instruction set on the function
+// avx512f brings FMA with it and gcc fuses mul + add by default (-ffp-contract=fast), that has to stay off to match the scalar results
+// clang only fuses within one expression, never across intrinsics, and has no optimize attribute
+#if defined(_MSC_VER)
+#define CULLING_TARGET_AVX2
+#define CULLING_TARGET_AVX512
+#elif defined(__clang__)
+#define CULLING_TARGET_AVX2 __attribute__((target("avx2")))
+#define CULLING_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define CULLING_TARGET_AVX2 __attribute__((target("avx2"), optimize("fp-contract=off")))
+#define CULLING_TARGET_AVX512 __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#endif
+
+enum class ECullingISA
+{
+	SSE41,
+	AVX2,
+	AVX512,
+	Count,
+};
+
+inline const char* GetCullingISAName(ECullingISA isa)
+{
+	const char* names[] = { "SSE4.1", "AVX2", "AVX-512" };
+	static_assert(sizeof(names) / sizeof(names[0]) == (int)ECullingISA::Count, "missing culling ISA name");
+	return names[(int)isa];
+}
+
+inline void CullingCPUID(int leaf, int subLeaf, int outRegs[4])
+{
+#if defined(_MSC_VER)
+	__cpuidex(outRegs, leaf, subLeaf);
+#else
+	unsigned int a, b, c, d;
+	__cpuid_count(leaf, subLeaf, a, b, c, d);
+	outRegs[0] = (int)a; outRegs[1] = (int)b; outRegs[2] = (int)c; outRegs[3] = (int)d;
+#endif
+}
+
+// which registers the OS saves on context switch (XCR0)
+inline uint64_t CullingXGetBV()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+// the widest the CPU and OS support, SSE4.1 is the engine's minimum anyway
+inline ECullingISA GetSupportedCullingISA()
+{
+	static const ECullingISA supportedISA = []()
+	{
+		int regs[4];
+		CullingCPUID(0, 0, regs);
+		int maxLeaf = regs[0];
+		CullingCPUID(1, 0, regs);
+		bool bOSXSave = (regs[2] & (1 << 27)) != 0;
+		bool bAVX = (regs[2] & (1 << 28)) != 0;
+		if (!bOSXSave || !bAVX || maxLeaf < 7)
+			return ECullingISA::SSE41;
+		uint64_t xcr0 = CullingXGetBV();
+		// xmm and ymm state
+		if ((xcr0 & 0x6) != 0x6)
+			return ECullingISA::SSE41;
+		CullingCPUID(7, 0, regs);
+		bool bAVX2 = (regs[1] & (1 << 5)) != 0;
+		bool bAVX512F = (regs[1] & (1 << 16)) != 0;
+		// opmask and zmm state too
+		if (CULLING_AVX512 && bAVX512F && (xcr0 & 0xE6) == 0xE6)
+			return ECullingISA::AVX512;
+		return bAVX2 ? ECullingISA::AVX2 : ECullingISA::SSE41;
+	}();
+	return supportedISA;
+}
+
+inline ECullingISA& GetCullingISARef()
+{
+	static ECullingISA cullingISA = GetSupportedCullingISA();
+	return cullingISA;
+}
+
+inline ECullingISA GetCullingISA()
+{
+	return GetCullingISARef();
+}
+
+// for tests and comparing paths, clamped to what's supported, returns the one in use
+inline ECullingISA SetCullingISA(ECullingISA isa)
+{
+	ECullingISA supportedISA = GetSupportedCullingISA();
+	GetCullingISARef() = isa > supportedISA ? supportedISA : isa;
+	return GetCullingISARef();
+}
+
+// rows k = 0..3 of 4 floats at ptr + k * stride, outX[k] = row k x, ...
+__forceinline void VecLoadTransposed4x4(const char* ptr, size_t stride, Vec128* out)
+{
+	Vec128 r0 = ((const Vector4*)(ptr))->m128;
+	Vec128 r1 = ((const Vector4*)(ptr + stride))->m128;
+	Vec128 r2 = ((const Vector4*)(ptr + stride * 2))->m128;
+	Vec128 r3 = ((const Vector4*)(ptr + stride * 3))->m128;
+	Vec128 u0 = VecInterleave_0011(r0, r1); // (r0.x, r1.x, r0.y, r1.y)
+	Vec128 u1 = VecInterleave_2233(r0, r1); // (r0.z, r1.z, r0.w, r1.w)
+	Vec128 u2 = VecInterleave_0011(r2, r3);
+	Vec128 u3 = VecInterleave_2233(r2, r3);
+	out[0] = VecShuffle_0101(u0, u2);
+	out[1] = VecShuffle_2323(u0, u2);
+	out[2] = VecShuffle_0101(u1, u3);
+	out[3] = VecShuffle_2323(u1, u3);
+}
+
+// same with 8 rows, row k goes to lane k / 4 of t[k % 4] so the 4x4 transpose works on both lanes at once
+CULLING_TARGET_AVX2 __forceinline void Vec256LoadTransposed8x4(const char* ptr, size_t stride, Vec256* out)
+{
+	Vec256 t0 = Vec256Set_Vec128(((const Vector4*)(ptr))->m128, ((const Vector4*)(ptr + stride * 4))->m128);
+	Vec256 t1 = Vec256Set_Vec128(((const Vector4*)(ptr + stride))->m128, ((const Vector4*)(ptr + stride * 5))->m128);
+	Vec256 t2 = Vec256Set_Vec128(((const Vector4*)(ptr + stride * 2))->m128, ((const Vector4*)(ptr + stride * 6))->m128);
+	Vec256 t3 = Vec256Set_Vec128(((const Vector4*)(ptr + stride * 3))->m128, ((const Vector4*)(ptr + stride * 7))->m128);
+	Vec256 u0 = Vec256Interleave_0011(t0, t1);
+	Vec256 u1 = Vec256Interleave_2233(t0, t1);
+	Vec256 u2 = Vec256Interleave_0011(t2, t3);
+	Vec256 u3 = Vec256Interleave_2233(t2, t3);
+	out[0] = Vec256Shuffle(u0, u2, 0, 1, 0, 1);
+	out[1] = Vec256Shuffle(u0, u2, 2, 3, 2, 3);
+	out[2] = Vec256Shuffle(u1, u3, 0, 1, 0, 1);
+	out[3] = Vec256Shuffle(u1, u3, 2, 3, 2, 3);
+}
+
+#if CULLING_AVX512
+// same with 16 rows, row k goes to lane k / 4 of t[k % 4]
+CULLING_TARGET_AVX512 __forceinline void Vec512LoadTransposed16x4(const char* ptr, size_t stride, __m512* out)
+{
+	__m512 t[4];
+	for (int j = 0; j < 4; ++j)
+	{
+		t[j] = _mm512_castps128_ps512(((const Vector4*)(ptr + stride * j))->m128);
+		t[j] = _mm512_insertf32x4(t[j], ((const Vector4*)(ptr + stride * (j + 4)))->m128, 1);
+		t[j] = _mm512_insertf32x4(t[j], ((const Vector4*)(ptr + stride * (j + 8)))->m128, 2);
+		t[j] = _mm512_insertf32x4(t[j], ((const Vector4*)(ptr + stride * (j + 12)))->m128, 3);
+	}
+	__m512 u0 = _mm512_unpacklo_ps(t[0], t[1]);
+	__m512 u1 = _mm512_unpackhi_ps(t[0], t[1]);
+	__m512 u2 = _mm512_unpacklo_ps(t[2], t[3]);
+	__m512 u3 = _mm512_unpackhi_ps(t[2], t[3]);
+	out[0] = _mm512_shuffle_ps(u0, u2, MakeShuffleMask(0, 1, 0, 1));
+	out[1] = _mm512_shuffle_ps(u0, u2, MakeShuffleMask(2, 3, 2, 3));
+	out[2] = _mm512_shuffle_ps(u1, u3, MakeShuffleMask(0, 1, 0, 1));
+	out[3] = _mm512_shuffle_ps(u1, u3, MakeShuffleMask(2, 3, 2, 3));
+}
+
+// _mm512_and_ps is AVX-512DQ
+CULLING_TARGET_AVX512 __forceinline __m512 Vec512Abs(__m512 vec)
+{
+	return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(vec), _mm512_set1_epi32(0x7FFFFFFF)));
+}
+#endif
+
+// OBB: (permutedAxisCenter, obbExtent) of object i at (char*)ptr + i * stride, see IsOBBIntersectFrustum
+// for each plane: (|PDotSx * ex| + |PDotSy * ey|) + (|PDotSz * ez| + (PDotC + Pw)) < 0 is outside, same order as VecSum
+
+inline uint32_t OBBIntersectFrustumBatch4(const char* axisCenterPtr, const char* extentPtr, size_t stride, const Plane* planes, int planeCount)
+{
+	Vec128 rowX[4], rowY[4], rowZ[4], extent[4];
+	VecLoadTransposed4x4(axisCenterPtr, stride, rowX);
+	VecLoadTransposed4x4(axisCenterPtr + sizeof(Vector4), stride, rowY);
+	VecLoadTransposed4x4(axisCenterPtr + sizeof(Vector4) * 2, stride, rowZ);
+	VecLoadTransposed4x4(extentPtr, stride, extent);
+	Vec128 outside = VecZero();
+	for (int p = 0; p < planeCount; ++p)
+	{
+		Vec128 px = VecSet1(planes[p].x), py = VecSet1(planes[p].y), pz = VecSet1(planes[p].z), pw = VecSet1(planes[p].w);
+		Vec128 dot[4];
+		for (int c = 0; c < 4; ++c)
+			dot[c] = VecAdd(VecAdd(VecMul(rowX[c], px), VecMul(rowY[c], py)), VecMul(rowZ[c], pz));
+		Vec128 sum = VecAdd(VecAdd(VecAbs(VecMul(dot[0], extent[0])), VecAbs(VecMul(dot[1], extent[1]))),
+			VecAdd(VecAbs(VecMul(dot[2], extent[2])), VecAdd(dot[3], pw)));
+		outside = VecOr(outside, VecCmpLT(sum, VecZero()));
+		if (VecMoveMask(outside) == 0xF)
+			break;
+	}
+	return ~(uint32_t)VecMoveMask(outside) & 0xF;
+}
+
+CULLING_TARGET_AVX2 inline uint32_t OBBIntersectFrustumBatch8(const char* axisCenterPtr, const char* extentPtr, size_t stride, const Plane* planes, int planeCount)
+{
+	Vec256 rowX[4], rowY[4], rowZ[4], extent[4];
+	Vec256LoadTransposed8x4(axisCenterPtr, stride, rowX);
+	Vec256LoadTransposed8x4(axisCenterPtr + sizeof(Vector4), stride, rowY);
+	Vec256LoadTransposed8x4(axisCenterPtr + sizeof(Vector4) * 2, stride, rowZ);
+	Vec256LoadTransposed8x4(extentPtr, stride, extent);
+	Vec256 zero = _mm256_setzero_ps();
+	Vec256 outside = zero;
+	for (int p = 0; p < planeCount; ++p)
+	{
+		Vec256 px = Vec256Set1(planes[p].x), py = Vec256Set1(planes[p].y), pz = Vec256Set1(planes[p].z), pw = Vec256Set1(planes[p].w);
+		Vec256 dot[4];
+		for (int c = 0; c < 4; ++c)
+			dot[c] = Vec256Add(Vec256Add(Vec256Mul(rowX[c], px), Vec256Mul(rowY[c], py)), Vec256Mul(rowZ[c], pz));
+		Vec256 sum = Vec256Add(Vec256Add(Vec256Abs(Vec256Mul(dot[0], extent[0])), Vec256Abs(Vec256Mul(dot[1], extent[1]))),
+			Vec256Add(Vec256Abs(Vec256Mul(dot[2], extent[2])), Vec256Add(dot[3], pw)));
+		outside = Vec256Or(outside, Vec256CmpLT(sum, zero));
+		if (Vec256MoveMask(outside) == 0xFF)
+			break;
+	}
+	return ~(uint32_t)Vec256MoveMask(outside) & 0xFF;
+}
+
+#if CULLING_AVX512
+CULLING_TARGET_AVX512 inline uint32_t OBBIntersectFrustumBatch16(const char* axisCenterPtr, const char* extentPtr, size_t stride, const Plane* planes, int planeCount)
+{
+	__m512 rowX[4], rowY[4], rowZ[4], extent[4];
+	Vec512LoadTransposed16x4(axisCenterPtr, stride, rowX);
+	Vec512LoadTransposed16x4(axisCenterPtr + sizeof(Vector4), stride, rowY);
+	Vec512LoadTransposed16x4(axisCenterPtr + sizeof(Vector4) * 2, stride, rowZ);
+	Vec512LoadTransposed16x4(extentPtr, stride, extent);
+	__m512 zero = _mm512_setzero_ps();
+	__mmask16 outside = 0;
+	for (int p = 0; p < planeCount; ++p)
+	{
+		__m512 px = _mm512_set1_ps(planes[p].x), py = _mm512_set1_ps(planes[p].y), pz = _mm512_set1_ps(planes[p].z), pw = _mm512_set1_ps(planes[p].w);
+		__m512 dot[4];
+		for (int c = 0; c < 4; ++c)
+			dot[c] = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(rowX[c], px), _mm512_mul_ps(rowY[c], py)), _mm512_mul_ps(rowZ[c], pz));
+		__m512 sum = _mm512_add_ps(_mm512_add_ps(Vec512Abs(_mm512_mul_ps(dot[0], extent[0])), Vec512Abs(_mm512_mul_ps(dot[1], extent[1]))),
+			_mm512_add_ps(Vec512Abs(_mm512_mul_ps(dot[2], extent[2])), _mm512_add_ps(dot[3], pw)));
+		outside |= _mm512_cmp_ps_mask(sum, zero, _CMP_LT_OQ);
+		if (outside == 0xFFFF)
+			break;
+	}
+	return ~(uint32_t)outside & 0xFFFF;
+}
+#endif
+
+// sphere: centerRadius (center, radius in w) of object i at (char*)ptr + i * stride, see IsSphereIntersectFrustum
+// for each plane: (Px * Cx + Py * Cy) + (Pz * Cz + Pw) < -radius is outside, same order as PointToPlaneDist
+
+inline uint32_t SphereIntersectFrustumBatch4(const char* centerRadiusPtr, size_t stride, const Plane* planes, int planeCount)
+{
+	Vec128 centerRadius[4];
+	VecLoadTransposed4x4(centerRadiusPtr, stride, centerRadius);
+	Vec128 negRadius = VecNegate(centerRadius[3]);
+	Vec128 outside = VecZero();
+	for (int p = 0; p < planeCount; ++p)
+	{
+		Vec128 px = VecSet1(planes[p].x), py = VecSet1(planes[p].y), pz = VecSet1(planes[p].z), pw = VecSet1(planes[p].w);
+		Vec128 dist = VecAdd(VecAdd(VecMul(px, centerRadius[0]), VecMul(py, centerRadius[1])), VecAdd(VecMul(pz, centerRadius[2]), pw));
+		outside = VecOr(outside, VecCmpLT(dist, negRadius));
+		if (VecMoveMask(outside) == 0xF)
+			break;
+	}
+	return ~(uint32_t)VecMoveMask(outside) & 0xF;
+}
+
+CULLING_TARGET_AVX2 inline uint32_t SphereIntersectFrustumBatch8(const char* centerRadiusPtr, size_t stride, const Plane* planes, int planeCount)
+{
+	Vec256 centerRadius[4];
+	Vec256LoadTransposed8x4(centerRadiusPtr, stride, centerRadius);
+	Vec256 negRadius = Vec256Negate(centerRadius[3]);
+	Vec256 outside = _mm256_setzero_ps();
+	for (int p = 0; p < planeCount; ++p)
+	{
+		Vec256 px = Vec256Set1(planes[p].x), py = Vec256Set1(planes[p].y), pz = Vec256Set1(planes[p].z), pw = Vec256Set1(planes[p].w);
+		Vec256 dist = Vec256Add(Vec256Add(Vec256Mul(px, centerRadius[0]), Vec256Mul(py, centerRadius[1])), Vec256Add(Vec256Mul(pz, centerRadius[2]), pw));
+		outside = Vec256Or(outside, Vec256CmpLT(dist, negRadius));
+		if (Vec256MoveMask(outside) == 0xFF)
+			break;
+	}
+	return ~(uint32_t)Vec256MoveMask(outside) & 0xFF;
+}
+
+#if CULLING_AVX512
+CULLING_TARGET_AVX512 inline uint32_t SphereIntersectFrustumBatch16(const char* centerRadiusPtr, size_t stride, const Plane* planes, int planeCount)
+{
+	__m512 centerRadius[4];
+	Vec512LoadTransposed16x4(centerRadiusPtr, stride, centerRadius);
+	__m512 negRadius = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(centerRadius[3]), _mm512_set1_epi32(0x80000000)));
+	__mmask16 outside = 0;
+	for (int p = 0; p < planeCount; ++p)
+	{
+		__m512 px = _mm512_set1_ps(planes[p].x), py = _mm512_set1_ps(planes[p].y), pz = _mm512_set1_ps(planes[p].z), pw = _mm512_set1_ps(planes[p].w);
+		__m512 dist = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(px, centerRadius[0]), _mm512_mul_ps(py, centerRadius[1])),
+			_mm512_add_ps(_mm512_mul_ps(pz, centerRadius[2]), pw));
+		outside |= _mm512_cmp_ps_mask(dist, negRadius, _CMP_LT_OQ);
+		if (outside == 0xFFFF)
+			break;
+	}
+	return ~(uint32_t)outside & 0xFFFF;
+}
+#endif
+
+// one loop per instruction set, the batch functions inline into the loop compiled for the same target
+
+inline int OBBIntersectFrustumLoop4(const char* axisCenterPtr, const char* extentPtr, size_t stride, int count, const Plane* planes, int planeCount, uint32_t* outVisibleMask)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+		outVisibleMask[i >> 5] |= OBBIntersectFrustumBatch4(axisCenterPtr + i * stride, extentPtr + i * stride, stride, planes, planeCount) << (i & 31);
+	return i;
+}
+
+CULLING_TARGET_AVX2 inline int OBBIntersectFrustumLoop8(const char* axisCenterPtr, const char* extentPtr, size_t stride, int count, const Plane* planes, int planeCount, uint32_t* outVisibleMask)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+		outVisibleMask[i >> 5] |= OBBIntersectFrustumBatch8(axisCenterPtr + i * stride, extentPtr + i * stride, stride, planes, planeCount) << (i & 31);
+	// back to SSE without the transition penalty
+	Vec256ZeroUpper();
+	return i;
+}
+
+#if CULLING_AVX512
+CULLING_TARGET_AVX512 inline int OBBIntersectFrustumLoop16(const char* axisCenterPtr, const char* extentPtr, size_t stride, int count, const Plane* planes, int planeCount, uint32_t* outVisibleMask)
+{
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+		outVisibleMask[i >> 5] |= OBBIntersectFrustumBatch16(axisCenterPtr + i * stride, extentPtr + i * stride, stride, planes, planeCount) << (i & 31);
+	Vec256ZeroUpper();
+	return i;
+}
+#endif
+
+inline int SphereIntersectFrustumLoop4(const char* centerRadiusPtr, size_t stride, int count, const Plane* planes, int planeCount, uint32_t* outVisibleMask)
+{
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+		outVisibleMask[i >> 5] |= SphereIntersectFrustumBatch4(centerRadiusPtr + i * stride, stride, planes, planeCount) << (i & 31);
+	return i;
+}
+
+CULLING_TARGET_AVX2 inline int SphereIntersectFrustumLoop8(const char* centerRadiusPtr, size_t stride, int count, const Plane* planes, int planeCount, uint32_t* outVisibleMask)
+{
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+		outVisibleMask[i >> 5] |= SphereIntersectFrustumBatch8(centerRadiusPtr + i * stride, stride, planes, planeCount) << (i & 31);
+	Vec256ZeroUpper();
+	return i;
+}
+
+#if CULLING_AVX512
+CULLING_TARGET_AVX512 inline int SphereIntersectFrustumLoop16(const char* centerRadiusPtr, size_t stride, int count, const Plane* planes, int planeCount, uint32_t* outVisibleMask)
+{
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+		outVisibleMask[i >> 5] |= SphereIntersectFrustumBatch16(centerRadiusPtr + i * stride, stride, planes, planeCount) << (i & 31);
+	Vec256ZeroUpper();
+	return i;
+}
+#endif
+
+inline int GetCullingMaskSize(int count)
+{
+	return (count + 31) / 32;
+}
+
+inline bool IsCullingMaskVisible(const uint32_t* visibleMask, int index)
+{
+	return (visibleMask[index >> 5] >> (index & 31)) & 1;
+}
+
+// outVisibleMask needs GetCullingMaskSize(count) words, they are overwritten
+// permutedAxisCenter and obbExtent of the first object, the next one is stride bytes further (sizeof(OrientedBoxBounds))
+inline void OBBIntersectFrustumBatch(const Vector4* permutedAxisCenter, const Vector4_3* obbExtent, size_t stride, int count,
+	const Plane* planes, int planeCount, uint32_t* outVisibleMask)
+{
+	for (int i = 0, ni = GetCullingMaskSize(count); i < ni; ++i)
+		outVisibleMask[i] = 0;
+	const char* axisCenterPtr = (const char*)permutedAxisCenter;
+	const char* extentPtr = (const char*)obbExtent;
+	int doneCount = 0;
+	switch (GetCullingISA())
+	{
+#if CULLING_AVX512
+	case ECullingISA::AVX512:
+		doneCount = OBBIntersectFrustumLoop16(axisCenterPtr, extentPtr, stride, count, planes, planeCount, outVisibleMask);
+		break;
+#endif
+	case ECullingISA::AVX2:
+		doneCount = OBBIntersectFrustumLoop8(axisCenterPtr, extentPtr, stride, count, planes, planeCount, outVisibleMask);
+		break;
+	default:
+		doneCount = OBBIntersectFrustumLoop4(axisCenterPtr, extentPtr, stride, count, planes, planeCount, outVisibleMask);
+		break;
+	}
+	// the rest one at a time
+	for (int i = doneCount; i < count; ++i)
+	{
+		if (IsOBBIntersectFrustum((const Vector4*)(axisCenterPtr + i * stride), *(const Vector4_3*)(extentPtr + i * stride), planes, planeCount))
+			outVisibleMask[i >> 5] |= 1u << (i & 31);
+	}
+}
+
+// centerRadius of the first sphere (SphereBounds::centerRadius), the next one is stride bytes further
+inline void SphereIntersectFrustumBatch(const Vector4* centerRadius, size_t stride, int count,
+	const Plane* planes, int planeCount, uint32_t* outVisibleMask)
+{
+	for (int i = 0, ni = GetCullingMaskSize(count); i < ni; ++i)
+		outVisibleMask[i] = 0;
+	const char* centerRadiusPtr = (const char*)centerRadius;
+	int doneCount = 0;
+	switch (GetCullingISA())
+	{
+#if CULLING_AVX512
+	case ECullingISA::AVX512:
+		doneCount = SphereIntersectFrustumLoop16(centerRadiusPtr, stride, count, planes, planeCount, outVisibleMask);
+		break;
+#endif
+	case ECullingISA::AVX2:
+		doneCount = SphereIntersectFrustumLoop8(centerRadiusPtr, stride, count, planes, planeCount, outVisibleMask);
+		break;
+	default:
+		doneCount = SphereIntersectFrustumLoop4(centerRadiusPtr, stride, count, planes, planeCount, outVisibleMask);
+		break;
+	}
+	for (int i = doneCount; i < count; ++i)
+	{
+		const Vector4& sphere = *(const Vector4*)(centerRadiusPtr + i * stride);
+		if (IsSphereIntersectFrustum(sphere, sphere.w, planes, planeCount))
+			outVisibleMask[i >> 5] |= 1u << (i & 31);
+	}
+}
\ No newline at end of file
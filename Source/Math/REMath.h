@@ -710,7 +710,7 @@ inline bool IsOBBIntersectSphere(const Vector4* permutedAxis, const Vector4_3& o
 
 // intersection between OBB (permutedAxisCenter, obbExtent) and frustum (planes, planeCount) plane normals point inside the volume
 // permutedScaledAxisCenter has 3 elements: (X.x, Y.x, Z.x, C.x), (X.y, Y.y, Z.y, C.y), (X.z, SY.z, SZ.z, C.z)
-inline bool IsOBBIntersectFrustum(const Vector4* permutedAxisCenter, const Vector4_3 obbExtent, Plane* planes, int planeCount)
+inline bool IsOBBIntersectFrustum(const Vector4* permutedAxisCenter, const Vector4_3 obbExtent, const Plane* planes, int planeCount)
 {
 	for (int i = 0; i < planeCount; ++i)
 	{
@@ -726,7 +726,7 @@ inline bool IsOBBIntersectFrustum(const Vector4* permutedAxisCenter, const Vecto
 }
 
 // intersection between sphere (center, radius) and frustum (planes, planeCount) plane normals point inside the volume
-inline bool IsSphereIntersectFrustum(const Vector4_3& center, float radius, Plane* planes, int planeCount)
+inline bool IsSphereIntersectFrustum(const Vector4_3& center, float radius, const Plane* planes, int planeCount)
 {
 	for (int i = 0; i < planeCount; ++i)
 	{
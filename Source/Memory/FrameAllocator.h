@@ -0,0 +1,258 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+
+#include "Memory.h"
+
+// linear allocator for data that only lives one frame (render lists), frameCount buffers used round robin
+// frame N writes buffer N % frameCount while the GPU may still read the buffers of the frames before,
+// the caller waits for the fence of the frame that used a buffer last, then BeginFrame resets it (offset back to 0)
+// any thread can allocate, it's one CAS, memory is never freed one by one
+class FrameAllocator
+{
+public:
+	static const int MAX_FRAME_COUNT = 4;
+	// per frame usage kept for stats
+	static const int HISTORY_COUNT = 128;
+
+	~FrameAllocator()
+	{
+		Release();
+	}
+
+	void Init(size_t frameCapacity, int inFrameCount, EMemoryTag inTag = EMemoryTag::Default)
+	{
+		assert(inFrameCount > 0 && inFrameCount <= MAX_FRAME_COUNT);
+		Release();
+		frameCount = inFrameCount;
+		tag = inTag;
+		for (int i = 0; i < frameCount; ++i)
+			AllocateFrameMemory(frames[i], frameCapacity);
+		frameIndex = -1;
+	}
+
+	void Release()
+	{
+		for (int i = 0; i < MAX_FRAME_COUNT; ++i)
+		{
+			FreeOverflow(frames[i]);
+			if (frames[i].memory)
+				FreeFrameMemory(frames[i]);
+			frames[i].memory = 0;
+			frames[i].capacity = 0;
+			frames[i].offset = 0;
+		}
+		frameCount = 0;
+	}
+
+	// buffer the next BeginFrame will reset, wait for its fence before calling BeginFrame
+	int GetNextFrameIndex() const
+	{
+		return (frameIndex + 1) % frameCount;
+	}
+
+	// nobody can allocate while this runs, returns the buffer index of the new frame
+	int BeginFrame()
+	{
+		assert(frameCount > 0);
+		if (frameIndex >= 0)
+			RecordUsage(frames[frameIndex]);
+
+		frameIndex = GetNextFrameIndex();
+		Frame& frame = frames[frameIndex];
+		// didn't fit last time, grow so everything fits in one buffer, the GPU is done with it
+		size_t requiredSize = frame.offset + frame.overflowSize;
+		FreeOverflow(frame);
+		if (requiredSize > frame.capacity)
+		{
+			FreeFrameMemory(frame);
+			AllocateFrameMemory(frame, requiredSize + requiredSize / 4);
+		}
+		frame.offset = 0;
+		return frameIndex;
+	}
+
+	void* Allocate(size_t size, size_t alignment)
+	{
+		assert(frameIndex >= 0);
+		Frame& frame = frames[frameIndex];
+		size_t offset = frame.offset.load(std::memory_order_relaxed);
+		while (true)
+		{
+			size_t alignedOffset = (offset + alignment - 1) & ~(alignment - 1);
+			if (alignedOffset + size > frame.capacity)
+				return AllocateOverflow(frame, size, alignment);
+			if (frame.offset.compare_exchange_weak(offset, alignedOffset + size, std::memory_order_relaxed))
+				return frame.memory + alignedOffset;
+		}
+	}
+
+	template<class T>
+	T* AllocateArray(int count, size_t alignment = alignof(T))
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "frame memory is dropped without calling destructors");
+		return (T*)Allocate(sizeof(T) * count, (alignment > alignof(T)) ? alignment : alignof(T));
+	}
+
+	struct Stats
+	{
+		// high-water mark of the last finished frame, all allocations of a frame stay until its buffer is reused
+		size_t lastFrameSize;
+		// biggest frame in the history
+		size_t peakFrameSize;
+		// allocations that went to the heap last frame, the buffer grows the next time it's used
+		size_t lastOverflowSize;
+		// of one buffer, the biggest one
+		size_t capacity;
+		int frameCount;
+	};
+
+	Stats GetStats() const
+	{
+		Stats stats = {};
+		stats.frameCount = frameCount;
+		for (int i = 0; i < HISTORY_COUNT; ++i)
+			stats.peakFrameSize = (usageHistory[i] > stats.peakFrameSize) ? usageHistory[i] : stats.peakFrameSize;
+		stats.lastFrameSize = usageHistory[(historyIndex + HISTORY_COUNT - 1) % HISTORY_COUNT];
+		stats.lastOverflowSize = lastOverflowSize;
+		for (int i = 0; i < frameCount; ++i)
+			stats.capacity = (frames[i].capacity > stats.capacity) ? frames[i].capacity : stats.capacity;
+		return stats;
+	}
+
+	// high-water mark of finished frames, 0 is the last one
+	size_t GetFrameUsage(int framesAgo) const
+	{
+		assert(framesAgo >= 0 && framesAgo < HISTORY_COUNT);
+		return usageHistory[(historyIndex + HISTORY_COUNT - 1 - framesAgo) % HISTORY_COUNT];
+	}
+
+protected:
+	// heap allocation for what didn't fit, linked so it can be freed with the buffer
+	struct OverflowBlock
+	{
+		OverflowBlock* next;
+		void* memory;
+		size_t size;
+	};
+
+	struct Frame
+	{
+		char* memory = 0;
+		size_t capacity = 0;
+		std::atomic<size_t> offset = 0;
+		std::atomic<OverflowBlock*> overflowList = 0;
+		std::atomic<size_t> overflowSize = 0;
+	};
+
+	static const size_t FRAME_ALIGNMENT = 64;
+
+	void AllocateFrameMemory(Frame& frame, size_t capacity)
+	{
+		frame.memory = (char*)_Aligned_Allocate(capacity, 1, FRAME_ALIGNMENT);
+		frame.capacity = capacity;
+		TrackMemoryTag(tag, (int64_t)capacity);
+	}
+
+	void FreeFrameMemory(Frame& frame)
+	{
+		TrackMemoryTag(tag, -(int64_t)frame.capacity);
+		_Aligned_Deallocate(frame.memory);
+		frame.memory = 0;
+		frame.capacity = 0;
+	}
+
+	RE_NOINLINE void* AllocateOverflow(Frame& frame, size_t size, size_t alignment)
+	{
+		OverflowBlock* block = new OverflowBlock();
+		block->memory = _Aligned_Allocate(size, 1, alignment);
+		block->size = size;
+		TrackMemoryTag(tag, (int64_t)size);
+		block->next = frame.overflowList.load(std::memory_order_relaxed);
+		while (!frame.overflowList.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+			;
+		frame.overflowSize.fetch_add(size + alignment, std::memory_order_relaxed);
+		return block->memory;
+	}
+
+	void FreeOverflow(Frame& frame)
+	{
+		OverflowBlock* block = frame.overflowList.exchange(0, std::memory_order_acquire);
+		while (block)
+		{
+			OverflowBlock* next = block->next;
+			TrackMemoryTag(tag, -(int64_t)block->size);
+			_Aligned_Deallocate(block->memory);
+			delete block;
+			block = next;
+		}
+		frame.overflowSize = 0;
+	}
+
+	void RecordUsage(const Frame& frame)
+	{
+		lastOverflowSize = frame.overflowSize;
+		usageHistory[historyIndex] = frame.offset + lastOverflowSize;
+		historyIndex = (historyIndex + 1) % HISTORY_COUNT;
+	}
+
+	Frame frames[MAX_FRAME_COUNT];
+	int frameCount = 0;
+	EMemoryTag tag = EMemoryTag::Default;
+	int frameIndex = -1;
+
+	size_t usageHistory[HISTORY_COUNT] = {};
+	int historyIndex = 0;
+	size_t lastOverflowSize = 0;
+};
+
+// fixed capacity array in frame memory, never reallocates, several jobs can append at the same time
+// capacity must be known when the frame starts (an upper bound is fine), elements are never destructed
+template<class T, int Alignment = 0>
+class FrameArray
+{
+public:
+	// new empty array for this frame, the previous contents belong to an older frame
+	void Allocate(FrameAllocator& allocator, int inCapacity)
+	{
+		dataPtr = inCapacity > 0 ? allocator.AllocateArray<T>(inCapacity, Alignment) : 0;
+		capacity = inCapacity;
+		count = 0;
+	}
+
+	// reserves a chunk of elements for the caller to fill, thread safe, returns the index of the first one
+	int AppendChunk(int chunkCount)
+	{
+		int index = count.fetch_add(chunkCount, std::memory_order_relaxed);
+		assert(index + chunkCount <= capacity);
+		return index;
+	}
+
+	// thread safe
+	void push_back(const T& value)
+	{
+		dataPtr[AppendChunk(1)] = value;
+	}
+
+	void clear() { count = 0; }
+
+	// only once every job appending is done
+	int size() const { return count.load(std::memory_order_relaxed); }
+	bool empty() const { return size() == 0; }
+	T* data() { return dataPtr; }
+	const T* data() const { return dataPtr; }
+	T* begin() { return dataPtr; }
+	T* end() { return dataPtr + size(); }
+	const T* begin() const { return dataPtr; }
+	const T* end() const { return dataPtr + size(); }
+	T& operator[](int index) { return dataPtr[index]; }
+	const T& operator[](int index) const { return dataPtr[index]; }
+
+protected:
+	T* dataPtr = 0;
+	int capacity = 0;
+	std::atomic<int> count = 0;
+};
\ No newline at end of file
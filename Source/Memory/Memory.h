@@ -1,14 +1,180 @@
 #pragma once
 
 #include <cstdint>	/* for uintptr_t */
+#include <cstddef>
 #include <cstdlib>
+#include <cstdio>
 #include <limits>
 #include <type_traits>
-#include <xutility>
+#include <memory>
+#include <new>
+#include <atomic>
+
+#include "Platform/Platform.h"
 
 // we set _SECURE_SCL=0;_HAS_ITERATOR_DEBUGGING=0; in preprocessor in Debug/X64 for performance
 
-inline __declspec(allocator) void* _Aligned_Allocate(size_t _Count, size_t _Sz, size_t _Alignment)
+// live and peak bytes for every memory tag (GetMemoryTagStats), costs two atomics per allocation
+// set MEMORY_STATS to 0 in preprocessor definitions to compile them out
+#ifndef MEMORY_STATS
+#define MEMORY_STATS 1
+#endif
+
+// who owns the memory, containers pick it with their last template parameter (REArray<Vertex, 0, EMemoryTag::Mesh>)
+// GPU tags count GL memory, the size is estimated from the format since GL doesn't tell (see GPUMemory.h)
+enum class EMemoryTag
+{
+	Default,
+	Mesh,
+	Material,
+	Profiler,
+	RenderList,
+	GPUTexture,
+	GPURenderTarget,
+	GPUShadowMap,
+	GPUVertexBuffer,
+	GPUIndexBuffer,
+	GPUBuffer,
+	Count,
+	FirstGPU = GPUTexture,
+};
+
+inline const char* GetMemoryTagName(EMemoryTag tag)
+{
+	const char* names[] = { "default", "mesh", "material", "profiler", "render list",
+		"gpu texture", "gpu render target", "gpu shadow map", "gpu vertex buffer", "gpu index buffer", "gpu buffer" };
+	static_assert(sizeof(names) / sizeof(names[0]) == (int)EMemoryTag::Count, "missing memory tag name");
+	return names[(int)tag];
+}
+
+inline bool IsGPUMemoryTag(EMemoryTag tag)
+{
+	return tag >= EMemoryTag::FirstGPU;
+}
+
+struct MemoryTagStats
+{
+	int64_t liveBytes;
+	int64_t peakBytes;
+	int64_t liveAllocationCount;
+	// every allocation since start
+	int64_t totalAllocationCount;
+	// 0 is no budget
+	int64_t budgetBytes;
+};
+
+struct MemoryTagCounters
+{
+	std::atomic<int64_t> liveBytes;
+	std::atomic<int64_t> peakBytes;
+	std::atomic<int64_t> liveAllocationCount;
+	std::atomic<int64_t> totalAllocationCount;
+	std::atomic<int64_t> budgetBytes;
+	// set by CheckMemoryBudgets so it warns once per crossing
+	std::atomic<bool> bOverBudget;
+};
+
+// zero initialized before any constructor runs, global containers can allocate during static init
+inline MemoryTagCounters* GetMemoryTagCounters()
+{
+	static MemoryTagCounters counters[(int)EMemoryTag::Count];
+	return counters;
+}
+
+// for memory that doesn't come from REAllocator (frame buffers, pools), call with the negative size when it's freed
+inline void TrackMemoryTag(EMemoryTag tag, int64_t bytes)
+{
+#if MEMORY_STATS
+	if (bytes == 0)
+		return;
+	MemoryTagCounters& counters = GetMemoryTagCounters()[(int)tag];
+	int64_t liveBytes = counters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+	if (bytes > 0)
+	{
+		counters.liveAllocationCount.fetch_add(1, std::memory_order_relaxed);
+		counters.totalAllocationCount.fetch_add(1, std::memory_order_relaxed);
+		int64_t peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+		while (liveBytes > peakBytes && !counters.peakBytes.compare_exchange_weak(peakBytes, liveBytes, std::memory_order_relaxed))
+			;
+	}
+	else
+	{
+		counters.liveAllocationCount.fetch_sub(1, std::memory_order_relaxed);
+	}
+#endif
+}
+
+inline MemoryTagStats GetMemoryTagStats(EMemoryTag tag)
+{
+	const MemoryTagCounters& counters = GetMemoryTagCounters()[(int)tag];
+	MemoryTagStats stats;
+	stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+	stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+	stats.liveAllocationCount = counters.liveAllocationCount.load(std::memory_order_relaxed);
+	stats.totalAllocationCount = counters.totalAllocationCount.load(std::memory_order_relaxed);
+	stats.budgetBytes = counters.budgetBytes.load(std::memory_order_relaxed);
+	return stats;
+}
+
+// budgets are only checked by CheckMemoryBudgets, allocations don't pay for them
+inline void SetMemoryBudget(EMemoryTag tag, int64_t budgetBytes)
+{
+	GetMemoryTagCounters()[(int)tag].budgetBytes.store(budgetBytes, std::memory_order_relaxed);
+}
+
+// once per frame, prints a warning when a tag goes over its budget and a note when it's back under
+// returns how many tags are over
+inline int CheckMemoryBudgets(FILE* file = stdout)
+{
+	int overBudgetCount = 0;
+	for (int tag = 0; tag < (int)EMemoryTag::Count; ++tag)
+	{
+		MemoryTagCounters& counters = GetMemoryTagCounters()[tag];
+		int64_t budgetBytes = counters.budgetBytes.load(std::memory_order_relaxed);
+		int64_t liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+		bool bOverBudget = budgetBytes > 0 && liveBytes > budgetBytes;
+		if (bOverBudget != counters.bOverBudget.exchange(bOverBudget, std::memory_order_relaxed))
+		{
+			if (bOverBudget)
+				fprintf(file, "warning: %s memory over budget, %.1f MB of %.1f MB\n", GetMemoryTagName((EMemoryTag)tag), liveBytes / 1048576.0, budgetBytes / 1048576.0);
+			else
+				fprintf(file, "%s memory back under budget, %.1f MB of %.1f MB\n", GetMemoryTagName((EMemoryTag)tag), liveBytes / 1048576.0, budgetBytes / 1048576.0);
+		}
+		overBudgetCount += bOverBudget;
+	}
+	return overBudgetCount;
+}
+
+inline void DumpMemoryTagStats(FILE* file = stdout)
+{
+	fprintf(file, "tag, live KB, peak KB, budget KB, live allocations, total allocations\n");
+	for (int tag = 0; tag < (int)EMemoryTag::Count; ++tag)
+	{
+		MemoryTagStats stats = GetMemoryTagStats((EMemoryTag)tag);
+		fprintf(file, "%s, %.1f, %.1f, %.1f, %lld, %lld\n", GetMemoryTagName((EMemoryTag)tag), stats.liveBytes / 1024.0, stats.peakBytes / 1024.0,
+			stats.budgetBytes / 1024.0, (long long)stats.liveAllocationCount, (long long)stats.totalAllocationCount);
+	}
+}
+
+// same as DumpMemoryTagStats in json, sizes in bytes, for scripts comparing scenes or builds
+inline void DumpMemoryTagStatsJSON(FILE* file)
+{
+	int64_t totalBytes[2] = { 0, 0 };
+	fprintf(file, "{\n\t\"tags\": [\n");
+	for (int tag = 0; tag < (int)EMemoryTag::Count; ++tag)
+	{
+		MemoryTagStats stats = GetMemoryTagStats((EMemoryTag)tag);
+		bool bGPU = IsGPUMemoryTag((EMemoryTag)tag);
+		totalBytes[bGPU] += stats.liveBytes;
+		fprintf(file, "\t\t{ \"name\": \"%s\", \"gpu\": %s, \"liveBytes\": %lld, \"peakBytes\": %lld, \"budgetBytes\": %lld, "
+			"\"liveAllocations\": %lld, \"totalAllocations\": %lld }%s\n",
+			GetMemoryTagName((EMemoryTag)tag), bGPU ? "true" : "false", (long long)stats.liveBytes, (long long)stats.peakBytes, (long long)stats.budgetBytes,
+			(long long)stats.liveAllocationCount, (long long)stats.totalAllocationCount, tag + 1 < (int)EMemoryTag::Count ? "," : "");
+	}
+	fprintf(file, "\t],\n\t\"cpuLiveBytes\": %lld,\n\t\"gpuLiveBytes\": %lld\n}\n", (long long)totalBytes[0], (long long)totalBytes[1]);
+}
+
+inline RE_DECLSPEC_ALLOCATOR void* _Aligned_Allocate(size_t _Count, size_t _Sz, size_t _Alignment)
 {
 	void *_Ptr = 0;
 
@@ -17,19 +183,30 @@ inline __declspec(allocator) void* _Aligned_Allocate(size_t _Count, size_t _Sz,
 
 	// check overflow of multiply
 	if ((size_t)(-1) / _Sz < _Count)
-		std::_Xbad_alloc();	// report no memory
+		throw std::bad_alloc();	// report no memory
 	const size_t _User_size = _Count * _Sz;
 
 	{	// allocate normal block
+#if defined(_MSC_VER)
 		_Ptr = _aligned_malloc(_User_size, _Alignment);
-		_STL_VERIFY(_Ptr != 0, "invalid argument");	// validate even in release since we're doing p[-1]
+#else
+		// posix_memalign wants at least pointer alignment
+		if (posix_memalign(&_Ptr, (_Alignment < sizeof(void*)) ? sizeof(void*) : _Alignment, _User_size) != 0)
+			_Ptr = 0;
+#endif
+		if (_Ptr == 0)
+			throw std::bad_alloc();
 	}
 	return (_Ptr);
 }
 
 inline void _Aligned_Deallocate(void * _Ptr)
 {
+#if defined(_MSC_VER)
 	_aligned_free(_Ptr);
+#else
+	free(_Ptr);
+#endif
 }
 
 template<class T>
@@ -55,22 +232,22 @@ public:
 
 	typedef std::true_type propagate_on_container_move_assignment;
 	typedef std::true_type is_always_equal;
-	
+
 	pointer address(reference _Val) const noexcept
 	{	// return address of mutable _Val
-		return (_STD addressof(_Val));
+		return (std::addressof(_Val));
 	}
 
 	const_pointer address(const_reference _Val) const noexcept
 	{	// return address of nonmutable _Val
-		return (_STD addressof(_Val));
+		return (std::addressof(_Val));
 	}
 
 	template<class _Objty,
 		class... _Types>
 		void construct(_Objty *_Ptr, _Types&&... _Args)
 	{	// construct _Objty(_Types...) at _Ptr
-		::new ((void *)_Ptr) _Objty(_STD forward<_Types>(_Args)...);
+		::new ((void *)_Ptr) _Objty(std::forward<_Types>(_Args)...);
 	}
 
 	template<class _Uty>
@@ -85,112 +262,133 @@ public:
 	}
 };
 
-template<class T, int Alignment>
+template<class T, int Alignment, EMemoryTag Tag = EMemoryTag::Default>
 class REAllocator : public REAllocatorBase<T>
 {
 public:
+	typedef typename REAllocatorBase<T>::pointer pointer;
+	typedef typename REAllocatorBase<T>::size_type size_type;
+
 	template<class _Other>
 	struct rebind
-	{	// convert this type to REAllocator<_Other, Alignment>
-		typedef REAllocator<_Other, Alignment> other;
+	{	// convert this type to REAllocator<_Other, Alignment, Tag>
+		typedef REAllocator<_Other, Alignment, Tag> other;
 	};
 
 	REAllocator() noexcept
 	{	// construct default REAllocator (do nothing)
 	}
 
-	REAllocator(const REAllocator<T, Alignment>&) noexcept
+	REAllocator(const REAllocator<T, Alignment, Tag>&) noexcept
 	{	// construct by copying (do nothing)
 	}
 
 	template<class _Other>
-	REAllocator(const REAllocator<_Other, Alignment>&) noexcept
+	REAllocator(const REAllocator<_Other, Alignment, Tag>&) noexcept
 	{	// construct from a related REAllocator (do nothing)
 	}
 
 	template<class _Other>
-	REAllocator<T, Alignment>& operator=(const REAllocator<_Other, Alignment>&)
+	REAllocator<T, Alignment, Tag>& operator=(const REAllocator<_Other, Alignment, Tag>&)
 	{	// assign from a related REAllocator (do nothing)
 		return (*this);
 	}
 
 	void deallocate(pointer _Ptr, size_type _Count)
 	{	// deallocate object at _Ptr
+		TrackMemoryTag(Tag, -(int64_t)(_Count * sizeof(T)));
 		_Aligned_Deallocate(_Ptr);
 	}
 
-	__declspec(allocator) pointer allocate(size_type _Count, const void * hint = 0)
+	RE_DECLSPEC_ALLOCATOR pointer allocate(size_type _Count, const void * hint = 0)
 	{	// allocate array of _Count elements, ignore hint
-		return (static_cast<pointer>(_Aligned_Allocate(_Count, sizeof(T), Alignment)));
+		pointer _Ptr = static_cast<pointer>(_Aligned_Allocate(_Count, sizeof(T), Alignment));
+		TrackMemoryTag(Tag, (int64_t)(_Count * sizeof(T)));
+		return (_Ptr);
 	}
 };
 
-template<class _Ty,	class _Other, int Alignment> inline
-	bool operator==(const REAllocator<_Ty, Alignment>&,
-		const REAllocator<_Other, Alignment>&) noexcept
+template<class _Ty,	class _Other, int Alignment, EMemoryTag Tag> inline
+	bool operator==(const REAllocator<_Ty, Alignment, Tag>&,
+		const REAllocator<_Other, Alignment, Tag>&) noexcept
 {	// test for allocator equality
 	return (true);
 }
 
-template<class _Ty,	class _Other, int Alignment> inline
-	bool operator!=(const REAllocator<_Ty, Alignment>& _Left,
-		const REAllocator<_Other, Alignment>& _Right) noexcept
+template<class _Ty,	class _Other, int Alignment, EMemoryTag Tag> inline
+	bool operator!=(const REAllocator<_Ty, Alignment, Tag>& _Left,
+		const REAllocator<_Other, Alignment, Tag>& _Right) noexcept
 {	// test for allocator inequality
 	return (false);
 }
 
-template<class T>
-class REAllocator<T, 0> : public REAllocatorBase<T>
+template<class T, EMemoryTag Tag>
+class REAllocator<T, 0, Tag> : public REAllocatorBase<T>
 {	// generic allocator for objects of class T
 public:
+	typedef typename REAllocatorBase<T>::value_type value_type;
+	typedef typename REAllocatorBase<T>::pointer pointer;
+	typedef typename REAllocatorBase<T>::size_type size_type;
+
 	template<class _Other>
 	struct rebind
-	{	// convert this type to REAllocator<_Other, 0>
-		typedef REAllocator<_Other, 0> other;
+	{	// convert this type to REAllocator<_Other, 0, Tag>
+		typedef REAllocator<_Other, 0, Tag> other;
 	};
 
 	REAllocator() noexcept
 	{	// construct default REAllocator (do nothing)
 	}
 
-	REAllocator(const REAllocator<T, 0>&) noexcept
+	REAllocator(const REAllocator<T, 0, Tag>&) noexcept
 	{	// construct by copying (do nothing)
 	}
 
 	template<class _Other>
-	REAllocator(const REAllocator<_Other, 0>&) noexcept
+	REAllocator(const REAllocator<_Other, 0, Tag>&) noexcept
 	{	// construct from a related REAllocator (do nothing)
 	}
 
 	template<class _Other>
-	REAllocator<T, 0>& operator=(const REAllocator<_Other, 0>&)
+	REAllocator<T, 0, Tag>& operator=(const REAllocator<_Other, 0, Tag>&)
 	{	// assign from a related REAllocator (do nothing)
 		return (*this);
 	}
 
+	// plain operator new unless the type wants more than new gives (same rule on every compiler)
+	static const bool bOverAligned = alignof(value_type) > alignof(std::max_align_t);
+
 	void deallocate(pointer _Ptr, size_type _Count)
 	{	// deallocate object at _Ptr
-		// std::_Deallocate(_Ptr, _Count * sizeof(T));
-		std::_Deallocate<std::_New_alignof<value_type>>(_Ptr, sizeof(value_type) * _Count);
+		TrackMemoryTag(Tag, -(int64_t)(_Count * sizeof(value_type)));
+		if (bOverAligned)
+			_Aligned_Deallocate(_Ptr);
+		else
+			::operator delete(_Ptr);
 	}
 
-	__declspec(allocator) pointer allocate(size_type _Count, const void * hint = 0)
+	RE_DECLSPEC_ALLOCATOR pointer allocate(size_type _Count, const void * hint = 0)
 	{	// allocate array of _Count elements, ignore hint
-		//return (static_cast<pointer>(std::_Allocate(_Count * sizeof(T))));
-		return (static_cast<pointer>(std::_Allocate<std::_New_alignof<value_type>>(std::_Get_size_of_n<sizeof(value_type)>(_Count))));
+		if ((size_t)(-1) / sizeof(value_type) < _Count)
+			throw std::bad_alloc();
+		pointer _Ptr = bOverAligned ?
+			static_cast<pointer>(_Aligned_Allocate(_Count, sizeof(value_type), alignof(value_type))) :
+			static_cast<pointer>(::operator new(_Count * sizeof(value_type)));
+		TrackMemoryTag(Tag, (int64_t)(_Count * sizeof(value_type)));
+		return (_Ptr);
 	}
 };
 
-template<class _Ty, class _Other> inline
-bool operator==(const REAllocator<_Ty, 0>&,
-	const REAllocator<_Other, 0>&) noexcept
+template<class _Ty, class _Other, EMemoryTag Tag> inline
+bool operator==(const REAllocator<_Ty, 0, Tag>&,
+	const REAllocator<_Other, 0, Tag>&) noexcept
 {	// test for allocator equality
 	return (true);
 }
 
-template<class _Ty, class _Other> inline
-bool operator!=(const REAllocator<_Ty, 0>& _Left,
-	const REAllocator<_Other, 0>& _Right) noexcept
+template<class _Ty, class _Other, EMemoryTag Tag> inline
+bool operator!=(const REAllocator<_Ty, 0, Tag>& _Left,
+	const REAllocator<_Other, 0, Tag>& _Right) noexcept
 {	// test for allocator inequality
 	return (false);
 }
\ No newline at end of file
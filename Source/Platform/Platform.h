@@ -0,0 +1,18 @@
+#pragma once
+
+// compiler portability, most of the engine is written against MSVC
+
+#if defined(_MSC_VER)
+
+#define RE_NOINLINE __declspec(noinline)
+#define RE_DECLSPEC_ALLOCATOR __declspec(allocator)
+
+#else
+
+#define __forceinline inline __attribute__((always_inline))
+#define __stdcall
+
+#define RE_NOINLINE __attribute__((noinline))
+#define RE_DECLSPEC_ALLOCATOR
+
+#endif
\ No newline at end of file
@@ -12,11 +12,15 @@
 
 // math
 #include "Math/REMath.h"
+#include "Math/MathCulling.h"
 
 // containers
 #include "Containers/Containers.h"
+#include "Memory/FrameAllocator.h"
 
 #include "JobSystem/JobSystem.h"
+#include "JobSystem/JobGraph.h"
+#include "JobSystem/JobTrace.h"
 
 // std
 #include <stdlib.h>
@@ -35,6 +39,7 @@
 #include "Engine/Texture2DArray.h"
 #include "Engine/TextureCube.h"
 #include "Engine/TextureCubeArray.h"
+#include "Engine/GPUMemory.h"
 #include "Engine/Light.h"
 #include "Engine/Viewpoint.h"
 #include "Engine/Camera.h"
@@ -69,6 +74,7 @@ SDL_Window* gWindow = NULL;
 SDL_GLContext gContext;
 
 // shader file cache
+// stays node based, the loader keeps a pointer to an entry while included files add theirs (REFlatMap would move it)
 std::unordered_map<std::string, ShaderFileInfo> gShaderFileCache;
 FileWatcher fileWatcher;
 
@@ -140,10 +146,27 @@ float* gDebugTexBuffer;
 #endif
 
 // render globals
-REArray<MeshRenderData, 16> gOpaqueMeshRenderList;
-REArray<MeshRenderData, 16> gMaskedMeshRenderList;
-REArray<MeshRenderData, 16> gAlphaBlendMeshRenderList;
-REArray<LightRenderData> gVisibleLightList;
+// per frame lists live in the frame allocator, a buffer is reused once the GPU fence of the frame that used it retired
+const int gFrameAllocatorFrameCount = 3;
+FrameAllocator gFrameAllocator;
+GLsync gFrameFences[gFrameAllocatorFrameCount];
+FrameArray<MeshRenderData, 16> gOpaqueMeshRenderList;
+FrameArray<MeshRenderData, 16> gMaskedMeshRenderList;
+FrameArray<MeshRenderData, 16> gAlphaBlendMeshRenderList;
+FrameArray<LightRenderData> gVisibleLightList;
+// what culling and the shadow passes read of every mesh component, same order as MeshComponent::gMeshComponentContainer
+// copied once at the end of the update, the camera and every shadow light then stream these arrays instead of the components
+enum EMeshCullField
+{
+	MeshCullOBB,
+	MeshCullModelMat,
+	MeshCullBounds,
+	// for shadow rendering, char so jobs can write neighbours
+	MeshCullRenderVisible,
+};
+RESoAArray<EMemoryTag::RenderList, OrientedBoxBounds, Matrix4, BoxBounds, char> gMeshCullData;
+// filled by SetupView each frame, shared by culling jobs and Render
+RenderContext gFrameRenderContext;
 
 int gShadowCubeMapCount;
 
@@ -522,9 +545,9 @@ void MakeMeshComponents(Material* defaultMaterial)
 
 	// box
 	Mesh* boxMesh = Mesh::Create(&gCubeMeshData, Material::Create(defaultMaterial));
-	boxMesh->material->SetParameter("metallic", 1.0f);
-	boxMesh->material->SetParameter("roughness", 0.3f);
-	//boxMesh->material->SetParameter("tintColor", Vector4(1.f,1.f,1.f,0.8f), 4);
+	boxMesh->material->SetParameter(STRING_ID("metallic"), 1.0f);
+	boxMesh->material->SetParameter(STRING_ID("roughness"), 0.3f);
+	//boxMesh->material->SetParameter(STRING_ID("tintColor"), Vector4(1.f,1.f,1.f,0.8f), 4);
 	for (int i = 0; i < 3; ++i)
 	{
 		MeshComponent* meshComp = MeshComponent::Create();
@@ -546,8 +569,8 @@ void MakeMeshComponents(Material* defaultMaterial)
 	for (int i = 0; i < 20; ++i)
 	{
 		Mesh* sphereMesh = Mesh::Create(&gSphereMeshData, Material::Create(defaultMaterial));
-		sphereMesh->material->SetParameter("metallic", 1.f);
-		sphereMesh->material->SetParameter("roughness", i * 0.9f / 19.f + 0.1f);
+		sphereMesh->material->SetParameter(STRING_ID("metallic"), 1.f);
+		sphereMesh->material->SetParameter(STRING_ID("roughness"), i * 0.9f / 19.f + 0.1f);
 		MeshComponent* meshComp = MeshComponent::Create();
 		meshComp->AddMesh(sphereMesh);
 		meshComp->SetPosition(Vector4_3(-20.f + i * 2.5f, -7.5f, 0.f));
@@ -556,8 +579,8 @@ void MakeMeshComponents(Material* defaultMaterial)
 	for (int i = 0; i < 20; ++i)
 	{
 		Mesh* sphereMesh = Mesh::Create(&gSphereMeshData, Material::Create(defaultMaterial));
-		sphereMesh->material->SetParameter("metallic", i * 0.05f);
-		sphereMesh->material->SetParameter("roughness", 0.4f);
+		sphereMesh->material->SetParameter(STRING_ID("metallic"), i * 0.05f);
+		sphereMesh->material->SetParameter(STRING_ID("roughness"), 0.4f);
 		MeshComponent* meshComp = MeshComponent::Create();
 		meshComp->AddMesh(sphereMesh);
 		meshComp->SetPosition(Vector4_3(-20.f + i * 2.5f, -12.5f, 0.f));
@@ -570,15 +593,15 @@ void MakeMeshComponents(Material* defaultMaterial)
 		meshComp->SetPosition(Vector4_3(5, -5, -1));
 		meshComp->SetScale(Vector4_3(0.3f, 0.3f, 0.3f));
 
-		const REArray<Mesh*>& meshList = meshComp->GetMeshList();
+		const MeshComponent::MeshList& meshList = meshComp->GetMeshList();
 		for (int i = 0; i < meshList.size(); ++i)
 		{
 			Material* material = meshList[i]->material;
 			if (!material)
 				continue;
 
-			material->SetParameter("metallic", 0.5f);
-			material->SetParameter("roughness", 0.2f);
+			material->SetParameter(STRING_ID("metallic"), 0.5f);
+			material->SetParameter(STRING_ID("roughness"), 0.2f);
 		}
 
 		//for (int i = 0; i < gNanosuitMeshes.size(); ++i)
@@ -592,8 +615,8 @@ void MakeMeshComponents(Material* defaultMaterial)
 		//	if (!material)
 		//		continue;
 
-		//	material->SetParameter("metallic", 0.f);
-		//	material->SetParameter("roughness", 0.3f);
+		//	material->SetParameter(STRING_ID("metallic"), 0.f);
+		//	material->SetParameter(STRING_ID("roughness"), 0.3f);
 		//}
 	}
 
@@ -605,15 +628,15 @@ void MakeMeshComponents(Material* defaultMaterial)
 		//meshComp->SetPosition(Vector4_3(0, -6, -1));
 		//meshComp->SetScale(Vector4_3(1.f, 1.f, 1.f) * 0.07f);
 
-		//const REArray<Mesh*>& meshList = meshComp->GetMeshList();
+		//const MeshComponent::MeshList& meshList = meshComp->GetMeshList();
 		//for (int i = 0; i < meshList.size(); ++i)
 		//{
 		//	Material* material = meshList[i]->material;
 		//	if (!material)
 		//		continue;
 
-		//	material->SetParameter("metallic", 0.f);
-		//	material->SetParameter("roughness", 1.f);
+		//	material->SetParameter(STRING_ID("metallic"), 0.f);
+		//	material->SetParameter(STRING_ID("roughness"), 1.f);
 		//}
 
 		for (int i = 0; i < gSceneMeshes.size(); ++i)
@@ -627,8 +650,8 @@ void MakeMeshComponents(Material* defaultMaterial)
 			if (!material)
 				continue;
 
-			material->SetParameter("metallic", 0.f);
-			material->SetParameter("roughness", 1.f);
+			material->SetParameter(STRING_ID("metallic"), 0.f);
+			material->SetParameter(STRING_ID("roughness"), 1.f);
 		}
 	}
 #endif
@@ -636,12 +659,12 @@ void MakeMeshComponents(Material* defaultMaterial)
 	// floor
 	{
 		Mesh* floorMesh = Mesh::Create(&gCubeMeshData, Material::Create(defaultMaterial));
-		floorMesh->material->SetParameter("diffuseTex", gFloorDiffuseMap);
-		floorMesh->material->SetParameter("normalTex", gFloorNormalMap);
-		floorMesh->material->SetParameter("tile", Vector4(32, 32, 0, 0), 4);
-		floorMesh->material->SetParameter("metallic", 0.f);
-		floorMesh->material->SetParameter("roughness", 0.3f);
-		//floorMesh->material->SetParameter("tintColor", Vector4(0.2f, 0.2f, 0.2f, 1.f), 4);
+		floorMesh->material->SetParameter(STRING_ID("diffuseTex"), gFloorDiffuseMap);
+		floorMesh->material->SetParameter(STRING_ID("normalTex"), gFloorNormalMap);
+		floorMesh->material->SetParameter(STRING_ID("tile"), Vector4(32, 32, 0, 0), 4);
+		floorMesh->material->SetParameter(STRING_ID("metallic"), 0.f);
+		floorMesh->material->SetParameter(STRING_ID("roughness"), 0.3f);
+		//floorMesh->material->SetParameter(STRING_ID("tintColor"), Vector4(0.2f, 0.2f, 0.2f, 1.f), 4);
 		MeshComponent* meshComp = MeshComponent::Create();
 		meshComp->AddMesh(floorMesh);
 		meshComp->SetPosition(Vector4_3(0.f, 0.f, -1.2f));
@@ -650,11 +673,11 @@ void MakeMeshComponents(Material* defaultMaterial)
 
 	//{
 	//	Mesh* floorMesh = Mesh::Create(&gCubeMeshData, Material::Create(defaultMaterial));
-	//	floorMesh->material->SetParameter("hasDiffuseTex", 0);
-	//	floorMesh->material->SetParameter("hasNormalTex", 0);
-	//	floorMesh->material->SetParameter("metallic", 0.f);
-	//	floorMesh->material->SetParameter("roughness", 0.f);
-	//	floorMesh->material->SetParameter("color", Vector4_3(0.2f));
+	//	floorMesh->material->SetParameter(STRING_ID("hasDiffuseTex"), 0);
+	//	floorMesh->material->SetParameter(STRING_ID("hasNormalTex"), 0);
+	//	floorMesh->material->SetParameter(STRING_ID("metallic"), 0.f);
+	//	floorMesh->material->SetParameter(STRING_ID("roughness"), 0.f);
+	//	floorMesh->material->SetParameter(STRING_ID("color"), Vector4_3(0.2f));
 	//	MeshComponent* meshComp = MeshComponent::Create();
 	//	meshComp->AddMesh(floorMesh);
 	//	meshComp->SetPosition(Vector4_3(-21.2f, 0.f, 0.f));
@@ -662,6 +685,36 @@ void MakeMeshComponents(Material* defaultMaterial)
 	//}
 }
 
+// sized for the min spec machine, 8 GB of RAM and a 2 GB GPU, CheckMemoryBudgets warns when a tag goes over
+void SetMemoryBudgets()
+{
+	const int64_t MB = 1024 * 1024;
+	SetMemoryBudget(EMemoryTag::Mesh, 512 * MB);
+	SetMemoryBudget(EMemoryTag::Material, 16 * MB);
+	SetMemoryBudget(EMemoryTag::Profiler, 4 * MB);
+	SetMemoryBudget(EMemoryTag::RenderList, 64 * MB);
+	SetMemoryBudget(EMemoryTag::GPUTexture, 768 * MB);
+	SetMemoryBudget(EMemoryTag::GPURenderTarget, 384 * MB);
+	SetMemoryBudget(EMemoryTag::GPUShadowMap, 192 * MB);
+	SetMemoryBudget(EMemoryTag::GPUVertexBuffer, 256 * MB);
+	SetMemoryBudget(EMemoryTag::GPUIndexBuffer, 128 * MB);
+	SetMemoryBudget(EMemoryTag::GPUBuffer, 64 * MB);
+}
+
+void DumpMemoryStatsFile(const char* fileName = "MemoryStats.json")
+{
+	FILE* file = 0;
+	fopen_s(&file, fileName, "w");
+	if (!file)
+	{
+		printf("failed to write %s\n", fileName);
+		return;
+	}
+	DumpMemoryTagStatsJSON(file);
+	fclose(file);
+	printf("memory stats written to %s\n", fileName);
+}
+
 void AllocateRenderTarget(bool bCreate)
 {
 	if (bCreate)
@@ -703,6 +756,7 @@ void AllocateRenderTarget(bool bCreate)
 		glBindRenderbuffer(GL_RENDERBUFFER, gSceneDepthStencilRBO);
 		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, gWindowWidth, gWindowHeight);
 		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		TrackGLRenderbuffer(gSceneDepthStencilRBO, EMemoryTag::GPURenderTarget, GetTextureBytes(GL_DEPTH24_STENCIL8, gWindowWidth, gWindowHeight));
 	}
 	else
 	{
@@ -739,6 +793,8 @@ void AllocateRenderTarget(bool bCreate)
 		glBindRenderbuffer(GL_RENDERBUFFER, gSceneDepthStencilRBO);
 		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, gWindowWidth, gWindowHeight);
 		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+		// replaces the old size
+		TrackGLRenderbuffer(gSceneDepthStencilRBO, EMemoryTag::GPURenderTarget, GetTextureBytes(GL_DEPTH24_STENCIL8, gWindowWidth, gWindowHeight));
 	}
 }
 
@@ -935,12 +991,20 @@ bool InitEngine()
 
 	gHasResetFrame = true;
 
+	// grows on its own if a frame needs more
+	gFrameAllocator.Init(1024 * 1024, gFrameAllocatorFrameCount, EMemoryTag::RenderList);
+	SetMemoryBudgets();
+	memset(gFrameFences, 0, sizeof(gFrameFences));
+
 #if JITTER_HALTON
 	InitializeHalton_2_3();
 #endif
 	InitializeLightOmniViewMat();
 
 	// frame buffers
+	gShadowTiledTex.memoryTag = EMemoryTag::GPUShadowMap;
+	gCSMTexArray.memoryTag = EMemoryTag::GPUShadowMap;
+	gShadowCubeTexArray.memoryTag = EMemoryTag::GPUShadowMap;
 	AllocateRenderTarget(true);
 	SetupFrameBuffers();
 	// scene buffer idx
@@ -956,11 +1020,13 @@ bool InitEngine()
 	glGenBuffers(1, &gUBO_Matrices);
 	glBindBuffer(GL_UNIFORM_BUFFER, gUBO_Matrices);
 	glBufferData(GL_UNIFORM_BUFFER, sizeof(RenderInfo), NULL, GL_DYNAMIC_DRAW);
+	TrackGLBuffer(gUBO_Matrices, EMemoryTag::GPUBuffer, sizeof(RenderInfo));
 	glBindBufferBase(GL_UNIFORM_BUFFER, (GLuint)EShaderBindingUBO::RenderInfo, gUBO_Matrices);
 	// global lights
 	glGenBuffers(1, &gUBO_GlobalLights);
 	glBindBuffer(GL_UNIFORM_BUFFER, gUBO_GlobalLights);
 	glBufferData(GL_UNIFORM_BUFFER, sizeof(GlobalLightsRenderInfo), NULL, GL_DYNAMIC_DRAW);
+	TrackGLBuffer(gUBO_GlobalLights, EMemoryTag::GPUBuffer, sizeof(GlobalLightsRenderInfo));
 	glBindBufferBase(GL_UNIFORM_BUFFER, (GLuint)EShaderBindingUBO::GlobalLightsRenderInfo, gUBO_GlobalLights);
 
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
@@ -1066,24 +1132,24 @@ bool InitEngine()
 	gPrepassMaskedMaterial->bMasked = true;
 	gPrepassMaskedMaterial->bBothSide = true;
 
-	defaultOpaqueMaterial->SetParameter("tintColor", Vector4(1.f), 4);
-	defaultOpaqueMaterial->SetParameter("hasDiffuseTex", 1);
-	defaultOpaqueMaterial->SetParameter("diffuseTex", gDiffuseMap);
-	defaultOpaqueMaterial->SetParameter("hasNormalTex", 1);
-	defaultOpaqueMaterial->SetParameter("normalTex", gNormalMap);
-	defaultOpaqueMaterial->SetParameter("hasRoughnessTex", 0);
-	defaultOpaqueMaterial->SetParameter("hasMaskTex", 0);
-	defaultOpaqueMaterial->SetParameter("tile", Vector4(1, 1, 0, 0), 4);
+	defaultOpaqueMaterial->SetParameter(STRING_ID("tintColor"), Vector4(1.f), 4);
+	defaultOpaqueMaterial->SetParameter(STRING_ID("hasDiffuseTex"), 1);
+	defaultOpaqueMaterial->SetParameter(STRING_ID("diffuseTex"), gDiffuseMap);
+	defaultOpaqueMaterial->SetParameter(STRING_ID("hasNormalTex"), 1);
+	defaultOpaqueMaterial->SetParameter(STRING_ID("normalTex"), gNormalMap);
+	defaultOpaqueMaterial->SetParameter(STRING_ID("hasRoughnessTex"), 0);
+	defaultOpaqueMaterial->SetParameter(STRING_ID("hasMaskTex"), 0);
+	defaultOpaqueMaterial->SetParameter(STRING_ID("tile"), Vector4(1, 1, 0, 0), 4);
 	
-	gAlphaBlendBasicMaterial->SetParameter("tintColor", Vector4(1.f), 4);
-	gAlphaBlendBasicMaterial->SetParameter("hasDiffuseTex", 1);
-	gAlphaBlendBasicMaterial->SetParameter("diffuseTex", gDiffuseMap);
-	gAlphaBlendBasicMaterial->SetParameter("hasNormalTex", 1);
-	gAlphaBlendBasicMaterial->SetParameter("normalTex", gNormalMap);
-	gAlphaBlendBasicMaterial->SetParameter("hasRoughnessTex", 0);
-	gAlphaBlendBasicMaterial->SetParameter("hasMaskTex", 0);
-	gAlphaBlendBasicMaterial->SetParameter("tile", Vector4(1, 1, 0, 0), 4);
-	gAlphaBlendBasicMaterial->SetParameter("skyTex", gSkyboxMap);
+	gAlphaBlendBasicMaterial->SetParameter(STRING_ID("tintColor"), Vector4(1.f), 4);
+	gAlphaBlendBasicMaterial->SetParameter(STRING_ID("hasDiffuseTex"), 1);
+	gAlphaBlendBasicMaterial->SetParameter(STRING_ID("diffuseTex"), gDiffuseMap);
+	gAlphaBlendBasicMaterial->SetParameter(STRING_ID("hasNormalTex"), 1);
+	gAlphaBlendBasicMaterial->SetParameter(STRING_ID("normalTex"), gNormalMap);
+	gAlphaBlendBasicMaterial->SetParameter(STRING_ID("hasRoughnessTex"), 0);
+	gAlphaBlendBasicMaterial->SetParameter(STRING_ID("hasMaskTex"), 0);
+	gAlphaBlendBasicMaterial->SetParameter(STRING_ID("tile"), Vector4(1, 1, 0, 0), 4);
+	gAlphaBlendBasicMaterial->SetParameter(STRING_ID("skyTex"), gSkyboxMap);
 	gAlphaBlendBasicMaterial->bAlphaBlend = true;
 	
 	// mesh
@@ -1127,6 +1193,22 @@ void Close()
 {
 	fileWatcher.Stop();
 
+	for (int i = 0; i < gFrameAllocatorFrameCount; ++i)
+	{
+		if (gFrameFences[i])
+			glDeleteSync(gFrameFences[i]);
+		gFrameFences[i] = 0;
+	}
+	gFrameAllocator.Release();
+
+	// while the GL context and the shaders are still there, in order of who points at whom
+	MeshComponent::gMeshComponentContainer.Clear();
+	Mesh::gMeshContainer.Clear();
+	Material::gMaterialContainer.Clear();
+	for (MeshData& meshData : MeshData::gMeshDataContainer)
+		meshData.ReleaseResource();
+	MeshData::gMeshDataContainer.Clear();
+
 	// shut down imgui
 	ImGui_Impl_Shutdown();
 
@@ -1279,8 +1361,6 @@ void UpdatePointLights(float deltaTime)
 		}
 	};
 
-	const JobEntryPoint& entryPoint = &LightMoveData::UpdateOneLight;
-
 	static REArray<LightMoveData, 16> lightMoveData;
 	if (lightMoveData.size() == 0)
 	{
@@ -1304,18 +1384,10 @@ void UpdatePointLights(float deltaTime)
 	//	UpdateOneLight(&moveData);
 	//}
 
-	int jobCount = (int)lightMoveData.size();
-	JobDescriptor* jobDescs = new JobDescriptor[jobCount];
-	for (int i = 0; i < jobCount; ++i)
+	ParallelFor(0, (int)lightMoveData.size(), 32, [](int i)
 	{
-		jobDescs[i] = JobDescriptor(entryPoint, &lightMoveData[i]);
-	}
-
-	JobWaitingCounter counter;
-	RunJobs(jobDescs, jobCount, &counter);
-	delete[] jobDescs;
-
-	WaitOnCounter(&counter, 0);
+		LightMoveData::UpdateOneLight(&lightMoveData[i]);
+	});
 }
 
 void Update(float deltaTime)
@@ -1353,9 +1425,14 @@ void Update(float deltaTime)
 	}
 
 	// end of frame
+	gMeshCullData.resize((int)MeshComponent::gMeshComponentContainer.size());
 	for (int i = 0, ni = (int)MeshComponent::gMeshComponentContainer.size(); i < ni; ++i)
 	{
-		MeshComponent::gMeshComponentContainer[i]->UpdateEndOfFrame(deltaTime);
+		MeshComponent& meshComp = MeshComponent::gMeshComponentContainer[i];
+		meshComp.UpdateEndOfFrame(deltaTime);
+		gMeshCullData.Get<MeshCullOBB>(i) = meshComp.OBB;
+		gMeshCullData.Get<MeshCullModelMat>(i) = meshComp.modelMat;
+		gMeshCullData.Get<MeshCullBounds>(i) = meshComp.bounds;
 	}
 
 	// update imgui
@@ -1410,17 +1487,25 @@ void CullLights(RenderContext& renderContext)
 	
 	// local lights
 	{
-		gVisibleLightList.clear();
+		gVisibleLightList.Allocate(gFrameAllocator, (int)(gPointLights.size() + gSpotLights.size()));
 
 		LightRenderData lightDataTmpl;
 
-		// point lights
+		// point lights, their sphere bounds are (position, radius)
 		lightDataTmpl.bSpot = false;
 		lightDataTmpl.bUseTetrahedronShadowMap = true;
-		for (int lightIdx = 0, nlightIdx = (int)gPointLights.size(); lightIdx < nlightIdx; ++lightIdx)
+		static REArray<uint32_t, 0, EMemoryTag::RenderList> pointLightVisibleMask;
+		int pointLightCount = (int)gPointLights.size();
+		pointLightVisibleMask.resize(GetCullingMaskSize(pointLightCount));
+		if (pointLightCount > 0)
+		{
+			SphereIntersectFrustumBatch(&gPointLights[0].sphereBounds.centerRadius, sizeof(Light), pointLightCount,
+				viewPoint.frustumPlanes, 6, pointLightVisibleMask.data());
+		}
+		for (int lightIdx = 0; lightIdx < pointLightCount; ++lightIdx)
 		{
 			Light& light = gPointLights[lightIdx];
-			if (IsSphereIntersectFrustum(light.position, light.radius, viewPoint.frustumPlanes, 6))
+			if (IsCullingMaskVisible(pointLightVisibleMask.data(), lightIdx))
 			{
 				lightDataTmpl.light = &light;
 				lightDataTmpl.bActualCastShadow = light.bCastShadow && gRenderSettings.bDrawShadow && gRenderSettings.bDrawShadowPoint;
@@ -1512,22 +1597,28 @@ void CullLights(RenderContext& renderContext)
 
 void SetupLightTileBuffer(int tileCount)
 {	
+	GLsizeiptr lightTileInfoSize = sizeof(GLuint) * tileCount * RenderConsts::lightTileInfoStride;
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gSSBO_LightTileInfoData);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * tileCount * RenderConsts::lightTileInfoStride, 0, GL_DYNAMIC_DRAW);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, lightTileInfoSize, 0, GL_DYNAMIC_DRAW);
+	TrackGLBuffer(gSSBO_LightTileInfoData, EMemoryTag::GPUBuffer, lightTileInfoSize);
 
 	int tileCullingResultStride = (RenderConsts::maxLightPerSlicedTile <= 16 ? 1 : 2);
 	int tileCullingResultCount = tileCount * RenderConsts::lightSlicesPerTile * RenderConsts::maxLightPerSlicedTile;
 
+	GLsizeiptr cullingResultSize = sizeof(GLuint) * tileCullingResultCount * tileCullingResultStride + RenderConsts::lightTileCullingResultOffset;
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gSSBO_LightTileCullingResultInfoData);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * tileCullingResultCount * tileCullingResultStride + RenderConsts::lightTileCullingResultOffset, 0, GL_DYNAMIC_DRAW);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, cullingResultSize, 0, GL_DYNAMIC_DRAW);
+	TrackGLBuffer(gSSBO_LightTileCullingResultInfoData, EMemoryTag::GPUBuffer, cullingResultSize);
 
+	GLsizeiptr tempCullingResultSize = sizeof(GLuint) * tileCullingResultCount * (tileCullingResultStride + 1) + RenderConsts::lightTileCullingResultOffset;
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gSSBO_TempLightTileCullingResultInfoData);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * tileCullingResultCount * (tileCullingResultStride + 1) + RenderConsts::lightTileCullingResultOffset, 0, GL_DYNAMIC_DRAW);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, tempCullingResultSize, 0, GL_DYNAMIC_DRAW);
+	TrackGLBuffer(gSSBO_TempLightTileCullingResultInfoData, EMemoryTag::GPUBuffer, tempCullingResultSize);
 
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
-void DrawMeshList(RenderContext& renderContext, const REArray<MeshRenderData, 16>& meshList, Material* overrideMaterial = 0, const REArray<char*>* copyParamNames = 0)
+void DrawMeshList(RenderContext& renderContext, const FrameArray<MeshRenderData, 16>& meshList, Material* overrideMaterial = 0, const REArray<StringID>* copyParamNames = 0)
 {
 	for (int i = 0, ni = (int)meshList.size(); i < ni; ++i)
 	{
@@ -1539,36 +1630,77 @@ void DrawMeshList(RenderContext& renderContext, const REArray<MeshRenderData, 16
 	}
 }
 
+// 0 opaque, 1 masked, 2 alpha blend
+__forceinline int GetMeshRenderListIndex(const Mesh* mesh)
+{
+	if (mesh->material->bAlphaBlend)
+		return 2;
+	if (mesh->material->bMasked)
+		return 1;
+	return 0;
+}
+
 void CullMeshes(RenderContext& renderContext)
 {
+	// every visible mesh might go to any list, size them all for the worst case
+	int meshCount = (int)MeshComponent::gMeshComponentContainer.size();
+	int maxRenderDataCount = 0;
+	for (int i = 0; i < meshCount; ++i)
+		maxRenderDataCount += (int)MeshComponent::gMeshComponentContainer[i].GetMeshList().size();
+	gOpaqueMeshRenderList.Allocate(gFrameAllocator, maxRenderDataCount);
+	gMaskedMeshRenderList.Allocate(gFrameAllocator, maxRenderDataCount);
+	gAlphaBlendMeshRenderList.Allocate(gFrameAllocator, maxRenderDataCount);
+
 	// visibility
-	// clear list
-	gOpaqueMeshRenderList.clear();
-	gMaskedMeshRenderList.clear();
-	gAlphaBlendMeshRenderList.clear();
-	for (int i = 0, ni = (int)MeshComponent::gMeshComponentContainer.size(); i < ni; ++i)
-	{
-		MeshComponent* meshComp = MeshComponent::gMeshComponentContainer[i];
-		if (IsOBBIntersectFrustum(meshComp->OBB.permutedAxisCenter, meshComp->OBB.extent, renderContext.viewPoint.frustumPlanes, 6))
+	// char not bool, vector<bool> packs bits and can't be written from different threads
+	static REArray<char, 0, EMemoryTag::RenderList> meshVisibility;
+	meshVisibility.resize(meshCount);
+	const OrientedBoxBounds* meshOBBs = gMeshCullData.Field<MeshCullOBB>();
+	const int cullBatchSize = 64;
+	ParallelForChunked(0, meshCount, cullBatchSize, [&](int chunkBegin, int chunkEnd)
+	{
+		FrameArray<MeshRenderData, 16>* lists[3] = { &gOpaqueMeshRenderList, &gMaskedMeshRenderList, &gAlphaBlendMeshRenderList };
+		int listCounts[3] = { 0, 0, 0 };
+		// 8 or 16 OBBs per iteration (MathCulling.h), chunks are only bigger than a batch without the job system
+		for (int batchBegin = chunkBegin; batchBegin < chunkEnd; batchBegin += cullBatchSize)
+		{
+			int batchCount = Min(chunkEnd - batchBegin, cullBatchSize);
+			uint32_t visibleMask[cullBatchSize / 32];
+			OBBIntersectFrustumBatch(meshOBBs[batchBegin].permutedAxisCenter, &meshOBBs[batchBegin].extent, sizeof(OrientedBoxBounds), batchCount,
+				renderContext.viewPoint.frustumPlanes, 6, visibleMask);
+			for (int i = 0; i < batchCount; ++i)
+				meshVisibility[batchBegin + i] = IsCullingMaskVisible(visibleMask, i);
+		}
+
+		// only the visible components are touched
+		for (int i = chunkBegin; i < chunkEnd; ++i)
+		{
+			if (!meshVisibility[i])
+				continue;
+			const MeshComponent::MeshList& meshList = MeshComponent::gMeshComponentContainer[i].GetMeshList();
+			for (int mi = 0, nmi = (int)meshList.size(); mi < nmi; ++mi)
+				++listCounts[GetMeshRenderListIndex(meshList[mi])];
+		}
+
+		// one chunk of each list for the whole range, jobs only share the list counts
+		int listIndices[3];
+		for (int listIdx = 0; listIdx < 3; ++listIdx)
+			listIndices[listIdx] = listCounts[listIdx] ? lists[listIdx]->AppendChunk(listCounts[listIdx]) : 0;
+
+		for (int i = chunkBegin; i < chunkEnd; ++i)
 		{
-			//meshComp->Draw(renderContext);
+			if (!meshVisibility[i])
+				continue;
 			// add mesh to render list
+			MeshComponent* meshComp = &MeshComponent::gMeshComponentContainer[i];
 			MeshRenderData renderDataTmpl;
 			renderDataTmpl.prevModelMat = meshComp->prevModelMat;
 			renderDataTmpl.modelMat = meshComp->modelMat;
-			const REArray<Mesh*>& meshList = meshComp->GetMeshList();
+			const MeshComponent::MeshList& meshList = meshComp->GetMeshList();
 			for (int mi = 0, nmi = (int)meshList.size(); mi < nmi; ++mi)
 			{
 				Mesh* mesh = meshList[mi];
 
-				REArray<MeshRenderData, 16>* listPtr = 0;
-				if (mesh->material->bAlphaBlend)
-					listPtr = &gAlphaBlendMeshRenderList;
-				else if(mesh->material->bMasked)
-					listPtr = &gMaskedMeshRenderList;
-				else
-					listPtr = &gOpaqueMeshRenderList;
-
 				renderDataTmpl.material = mesh->material;
 				renderDataTmpl.VAO = mesh->meshData->VAO;
 				renderDataTmpl.idxCount = mesh->meshData->idxCount;
@@ -1576,11 +1708,13 @@ void CullMeshes(RenderContext& renderContext)
 				renderDataTmpl.distToCamera =
 					(renderDataTmpl.modelMat.TransformPoint(mesh->meshData->bounds.GetCenter()) - renderContext.viewPoint.position).Size3();
 
-				listPtr->push_back(renderDataTmpl);
+				int listIdx = GetMeshRenderListIndex(mesh);
+				(*lists[listIdx])[listIndices[listIdx]++] = renderDataTmpl;
 			}
 		}
-	}
-	// sort
+	});
+
+	// sort, chunks were appended in whatever order the jobs finished
 	std::sort(gOpaqueMeshRenderList.begin(), gOpaqueMeshRenderList.end(), MeshRenderData::CompareOpaque);
 	std::sort(gMaskedMeshRenderList.begin(), gMaskedMeshRenderList.end(), MeshRenderData::CompareOpaque);
 	std::sort(gAlphaBlendMeshRenderList.begin(), gAlphaBlendMeshRenderList.end(), MeshRenderData::CompareAlphaBlend);
@@ -1606,9 +1740,9 @@ void PreZPass(RenderContext& renderContext)
 	// draw mesh
 	DrawMeshList(renderContext, gOpaqueMeshRenderList, gPrepassMaterial);
 
-	const REArray<char*> copyParamNames = {
-		"maskTex",
-		"tile"
+	static const REArray<StringID> copyParamNames = {
+		STRING_ID("maskTex"),
+		STRING_ID("tile")
 	};
 
 	DrawMeshList(renderContext, gMaskedMeshRenderList, gPrepassMaskedMaterial, &copyParamNames);
@@ -1718,8 +1852,8 @@ Material* SetupLightVolumeMaterial(RenderContext& renderContext, const LightRend
 	lightVolumeMaterial->SetParameter(ShaderNameBuilder("light")("attenParams").c_str(), light.attenParams, 4);
 	lightVolumeMaterial->SetParameter(ShaderNameBuilder("light")("positionInvR").c_str(), light.GetPositionVSInvR(renderContext.viewPoint.viewMat), 4);
 	lightVolumeMaterial->SetParameter(ShaderNameBuilder("light")("directionRAB").c_str(), light.GetDirectionVSRAB(renderContext.viewPoint.viewMat), 4);
-	lightVolumeMaterial->SetParameter("modelMat", light.modelMat);
-	//lightVolumeMaterial->SetParameter("lightIndex", lightIndex);
+	lightVolumeMaterial->SetParameter(STRING_ID("modelMat"), light.modelMat);
+	//lightVolumeMaterial->SetParameter(STRING_ID("lightIndex"), lightIndex);
 
 	bool bDrawShadow = gRenderSettings.bDrawShadow && lightData.bActualCastShadow;
 	if (lightData.bSpot)
@@ -1730,7 +1864,7 @@ Material* SetupLightVolumeMaterial(RenderContext& renderContext, const LightRend
 	if (bDrawShadow)
 	{
 		lightVolumeMaterial->SetParameter(ShaderNameBuilder("light")("shadowParamA").c_str(), 1);
-		lightVolumeMaterial->SetParameter("shadowMat", light.shadowMat[0]);
+		lightVolumeMaterial->SetParameter(STRING_ID("shadowMat"), light.shadowMat[0]);
 		if (lightData.bSpot)
 		{
 		}
@@ -1743,7 +1877,7 @@ Material* SetupLightVolumeMaterial(RenderContext& renderContext, const LightRend
 			}
 			else
 			{
-				lightVolumeMaterial->SetParameter("lightProjRemapMat", light.shadowMat[1]);
+				lightVolumeMaterial->SetParameter(STRING_ID("lightProjRemapMat"), light.shadowMat[1]);
 				lightVolumeMaterial->SetParameter(ShaderNameBuilder("light")("shadowParamB").c_str(), lightData.shadowMapIndex);
 			}
 		}
@@ -1812,10 +1946,9 @@ void LightVolumePass(RenderContext& renderContext)
 		s.cullFaceMode = GL_FRONT;
 	});
 
-	REArray<int> cameraInsideLight;
-	cameraInsideLight.reserve(4);
-	REArray<int> volumetricLight;
-	volumetricLight.reserve(4);
+	// per frame temporaries, a few lights at most, on the stack
+	RESmallArray<int, 8> cameraInsideLight;
+	RESmallArray<int, 8> volumetricLight;
 
 	int stencilBits = 8;
 
@@ -1876,7 +2009,7 @@ void LightVolumePass(RenderContext& renderContext)
 			glStencilFunc(prepassRenderState.stencilTestFunc, mask, mask);
 			glStencilMask(mask);
 
-			gPrepassMaterial->SetParameter("modelMat", light.modelMat);
+			gPrepassMaterial->SetParameter(STRING_ID("modelMat"), light.modelMat);
 			light.LightMesh->Draw(renderContext, gPrepassMaterial);
 		}
 
@@ -1997,12 +2130,12 @@ void TileBasedDeferredLightPass(RenderContext& renderContext)
 		Texture2D& curSceneColorTex = gSceneColorTex[gSceneColorWriteIdx];
 		curSceneColorTex.access = GL_WRITE_ONLY;
 #if 0
-		gTileBasedDeferredLightCompMaterial->SetParameter("outColor", &curSceneColorTex, true);
+		gTileBasedDeferredLightCompMaterial->SetParameter(STRING_ID("outColor"), &curSceneColorTex, true);
 		gTileBasedDeferredLightCompMaterial->DispatchCompute(renderContext, gRenderInfo.TileCountX, gRenderInfo.TileCountY);
 
 		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 #else
-		gLightTileOnePassCompMaterial->SetParameter("outColor", &curSceneColorTex, true);
+		gLightTileOnePassCompMaterial->SetParameter(STRING_ID("outColor"), &curSceneColorTex, true);
 		gLightTileOnePassCompMaterial->DispatchCompute(renderContext, gRenderInfo.TileCountX, gRenderInfo.TileCountY);
 
 		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
@@ -2012,7 +2145,7 @@ void TileBasedDeferredLightPass(RenderContext& renderContext)
 }
 
 void DrawShadowScene(RenderContext& renderContext, Texture* shadowMap, const RenderInfo& renderInfo, Material* material,
-	REArray<MeshComponent*>& involvedMeshComps)
+	MeshComponent::Container& involvedMeshComps)
 {
 	if (shadowMap)
 	{
@@ -2033,11 +2166,41 @@ void DrawShadowScene(RenderContext& renderContext, Texture* shadowMap, const Ren
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
 	// draw models
+	const char* renderVisible = gMeshCullData.Field<MeshCullRenderVisible>();
 	for (int i = 0, ni = (int)involvedMeshComps.size(); i < ni; ++i)
 	{
-		MeshComponent*& meshComp = involvedMeshComps[i];
-		if(meshComp->bRenderVisibile)
-			meshComp->Draw(renderContext, material);
+		if (renderVisible[i])
+			involvedMeshComps[i].Draw(renderContext, material);
+	}
+}
+
+// mesh bounds in each directional light space, for cascade fitting
+REArray<REArray<BoxBounds, 16, EMemoryTag::RenderList>, 0, EMemoryTag::RenderList> gCSMLightSpaceBounds;
+
+void UpdateCSMLightSpaceBounds()
+{
+	gCSMLightSpaceBounds.resize(gDirectionalLights.size());
+
+	if (!gRenderSettings.bDrawShadow || !gRenderSettings.bDrawShadowCSM)
+		return;
+
+	for (int lightIdx = 0, nlightIdx = (int)gDirectionalLights.size(); lightIdx < nlightIdx; ++lightIdx)
+	{
+		Light& light = gDirectionalLights[lightIdx];
+		if (!light.bCastShadow)
+			continue;
+
+		REArray<BoxBounds, 16, EMemoryTag::RenderList>& lightSpaceBounds = gCSMLightSpaceBounds[lightIdx];
+		lightSpaceBounds.resize(MeshComponent::gMeshComponentContainer.size());
+		ParallelForChunked(0, gMeshCullData.size(), 64, [&](int chunkBegin, int chunkEnd)
+		{
+			for (auto element : gMeshCullData.GetView(chunkBegin, chunkEnd))
+			{
+				const Matrix4& adjustMat = light.lightViewMat * element.Get<MeshCullModelMat>();
+				// tranform bounds into light space
+				lightSpaceBounds[element.GetIndex()] = element.Get<MeshCullBounds>().GetTransformedBounds(adjustMat);
+			}
+		});
 	}
 }
 
@@ -2112,9 +2275,6 @@ void ShadowPass(RenderContext& renderContext)
 		bool bFixedSize = false;
 		int csmIndex = 0;
 
-		REArray<BoxBounds, 16> lightSpaceBounds;
-		lightSpaceBounds.resize(MeshComponent::gMeshComponentContainer.size());
-		
 		int shadowIdx = 0;
 		for (int lightIdx = 0, nlightIdx = (int)gDirectionalLights.size(); lightIdx < nlightIdx; ++lightIdx)
 		{
@@ -2129,14 +2289,8 @@ void ShadowPass(RenderContext& renderContext)
 			if (!light.bCastShadow)
 				continue;
 
-			// calculate light space bounds
-			for (int i = 0, ni = (int)MeshComponent::gMeshComponentContainer.size(); i < ni; ++i)
-			{
-				MeshComponent*& meshComp = MeshComponent::gMeshComponentContainer[i];
-				const Matrix4& adjustMat = light.lightViewMat * meshComp->modelMat;
-				// tranform bounds into light space
-				lightSpaceBounds[i] = meshComp->bounds.GetTransformedBounds(adjustMat);
-			}
+			// calculated in UpdateCSMLightSpaceBounds, alongside culling
+			const REArray<BoxBounds, 16, EMemoryTag::RenderList>& lightSpaceBounds = gCSMLightSpaceBounds[lightIdx];
 
 			Matrix4 viewToLight = light.lightViewMat * viewPoint.invViewMat;
 
@@ -2171,29 +2325,46 @@ void ShadowPass(RenderContext& renderContext)
 				frustumBounds.max.z += stepBack;
 
 				// process scene bounds and do frustum culling
-				bool bHasMeshToRender = false;
-				BoxBounds sceneBounds;
-				for (int i = 0, ni = (int)MeshComponent::gMeshComponentContainer.size(); i < ni; ++i)
+				struct SceneBoundsResult
 				{
-					MeshComponent*& meshComp = MeshComponent::gMeshComponentContainer[i];
-					// overlap test
-					if (IsAABBIntersectAABB(frustumBounds.min, frustumBounds.max, 
-						lightSpaceBounds[i].min, lightSpaceBounds[i].max))
-					{
-						sceneBounds += lightSpaceBounds[i];
-						meshComp->bRenderVisibile = true;
-						bHasMeshToRender = true;
-					}
-					else
+					BoxBounds bounds;
+					bool bHasMeshToRender;
+
+					SceneBoundsResult() : bHasMeshToRender(false) {}
+				};
+
+				SceneBoundsResult sceneBoundsResult = ParallelReduce(0, (int)MeshComponent::gMeshComponentContainer.size(), 64, SceneBoundsResult(),
+					[&](int chunkBegin, int chunkEnd, SceneBoundsResult& result)
+				{
+					char* renderVisible = gMeshCullData.Field<MeshCullRenderVisible>();
+					for (int i = chunkBegin; i < chunkEnd; ++i)
 					{
-						meshComp->bRenderVisibile = false;
+						// overlap test
+						if (IsAABBIntersectAABB(frustumBounds.min, frustumBounds.max,
+							lightSpaceBounds[i].min, lightSpaceBounds[i].max))
+						{
+							result.bounds += lightSpaceBounds[i];
+							renderVisible[i] = true;
+							result.bHasMeshToRender = true;
+						}
+						else
+						{
+							renderVisible[i] = false;
+						}
 					}
-				}
+				},
+					[](SceneBoundsResult& result, const SceneBoundsResult& other)
+				{
+					result.bounds += other.bounds;
+					result.bHasMeshToRender |= other.bHasMeshToRender;
+				});
 
 				// skip if we have no mesh to render
-				if (!bHasMeshToRender)
+				if (!sceneBoundsResult.bHasMeshToRender)
 					continue;
 
+				const BoxBounds& sceneBounds = sceneBoundsResult.bounds;
+
 				// only change far plane if scene bounds are closer, don't extend it
 				frustumBounds.min.z = Max(sceneBounds.min.z, frustumBounds.min.z);
 				// for near plane simply use what scene bounds has,
@@ -2275,9 +2446,9 @@ void ShadowPass(RenderContext& renderContext)
 
 	// local light data
 	int visibleLightCount = (int)gVisibleLightList.size();
-	REArray<LightRenderInfo> localLights;
-	REArray<Vector4, 16> localLightsBounds;
-	REArray<Matrix4, 16> shadowMatrices;
+	REScratchArray<LightRenderInfo> localLights;
+	REScratchArray<Vector4, 16> localLightsBounds;
+	REScratchArray<Matrix4, 16> shadowMatrices;
 	localLights.reserve(visibleLightCount);
 	localLightsBounds.reserve(visibleLightCount);
 	shadowMatrices.reserve(gCurLocalLightShadowMatCount);
@@ -2399,7 +2570,7 @@ void ShadowPass(RenderContext& renderContext)
 				Vector4(tileSize + 2.f * offsetX - 1.f, tileSize + 2.f * offsetY - 1.f, 0.f, 1.f)
 			);
 
-			gPrepassTiledMaterial->SetParameter("clippingValue", 
+			gPrepassTiledMaterial->SetParameter(STRING_ID("clippingValue"), 
 				Vector4(offsetX, offsetX + tileSize, offsetY, offsetY + tileSize) * 2.f - 1.f,
 				4);
 
@@ -2422,17 +2593,18 @@ void ShadowPass(RenderContext& renderContext)
 				lightNearPlane, light.radius, frustumPlanes);
 
 			bool bHasMeshToRender = false;
-			for (int i = 0, ni = (int)MeshComponent::gMeshComponentContainer.size(); i < ni; ++i)
+			const OrientedBoxBounds* meshOBBs = gMeshCullData.Field<MeshCullOBB>();
+			char* renderVisible = gMeshCullData.Field<MeshCullRenderVisible>();
+			for (int i = 0, ni = gMeshCullData.size(); i < ni; ++i)
 			{
-				MeshComponent*& meshComp = MeshComponent::gMeshComponentContainer[i];
-				if (IsOBBIntersectFrustum(meshComp->OBB.permutedAxisCenter, meshComp->OBB.extent, frustumPlanes, 6))
+				if (IsOBBIntersectFrustum(meshOBBs[i].permutedAxisCenter, meshOBBs[i].extent, frustumPlanes, 6))
 				{
-					meshComp->bRenderVisibile = true;
+					renderVisible[i] = true;
 					bHasMeshToRender = true;
 				}
 				else
 				{
-					meshComp->bRenderVisibile = false;
+					renderVisible[i] = false;
 				}
 			}
 
@@ -2512,24 +2684,25 @@ void ShadowPass(RenderContext& renderContext)
 				{
 					gPrepassCubeMaterial->SetParameter(ShaderNameBuilder("lightViewProjMat")[i].c_str(), lightProjMat * gLightCubeViewMat[i]);
 				}
-				gPrepassCubeMaterial->SetParameter("cubeMapArrayIndex", lightData.shadowMapIndex);
+				gPrepassCubeMaterial->SetParameter(STRING_ID("cubeMapArrayIndex"), lightData.shadowMapIndex);
 			}
 
 			bool bHasMeshToRender = false;
 			// process scene bounds and do frustum culling
-			for (int i = 0, ni = (int)MeshComponent::gMeshComponentContainer.size(); i < ni; ++i)
+			const OrientedBoxBounds* meshOBBs = gMeshCullData.Field<MeshCullOBB>();
+			char* renderVisible = gMeshCullData.Field<MeshCullRenderVisible>();
+			for (int i = 0, ni = gMeshCullData.size(); i < ni; ++i)
 			{
-				MeshComponent*& meshComp = MeshComponent::gMeshComponentContainer[i];
 				if (IsOBBIntersectSphere(
-					meshComp->OBB.permutedAxisCenter, meshComp->OBB.center, meshComp->OBB.extent,
+					meshOBBs[i].permutedAxisCenter, meshOBBs[i].center, meshOBBs[i].extent,
 					light.position, light.radius))
 				{
 					bHasMeshToRender = true;
-					meshComp->bRenderVisibile = true;
+					renderVisible[i] = true;
 				}
 				else
 				{
-					meshComp->bRenderVisibile = false;
+					renderVisible[i] = false;
 				}
 			}
 
@@ -2575,12 +2748,18 @@ void ShadowPass(RenderContext& renderContext)
 	//glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(int), &visibleLightCount);
 	//glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(int) * 4, sizeof(LightRenderInfo) * visibleLightCount, localLights.data());
 	if (bNeedReallocate)
+	{
 		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(LightRenderInfo) * visibleLightCount, NULL, GL_DYNAMIC_DRAW);
+		TrackGLBuffer(gSSBO_LocalLights, EMemoryTag::GPUBuffer, sizeof(LightRenderInfo) * visibleLightCount);
+	}
 	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(LightRenderInfo) * visibleLightCount, localLights.data());
 
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gSSBO_LocalLightsBounds);
 	if (bNeedReallocate)
+	{
 		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Vector4) * visibleLightCount, NULL, GL_DYNAMIC_DRAW);
+		TrackGLBuffer(gSSBO_LocalLightsBounds, EMemoryTag::GPUBuffer, sizeof(Vector4) * visibleLightCount);
+	}
 	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(Vector4) * visibleLightCount, localLightsBounds.data());
 
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, gSSBO_LocalLightsShadowMatrices);
@@ -2592,6 +2771,7 @@ void ShadowPass(RenderContext& renderContext)
 	{
 		gPrevLocalLightShadowMatCapacity = gCurLocalLightShadowMatCount;
 		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(Matrix4) * gCurLocalLightShadowMatCount, shadowMatrices.data(), GL_DYNAMIC_DRAW);
+		TrackGLBuffer(gSSBO_LocalLightsShadowMatrices, EMemoryTag::GPUBuffer, sizeof(Matrix4) * gCurLocalLightShadowMatCount);
 	}
 
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
@@ -2612,8 +2792,8 @@ void SkyboxPass(RenderContext& renderContext)
 
 	renderState.Apply(renderContext);
 
-	//gSkyboxMaterial->SetParameter("cubeMap", gPointLights[1].shadowData[0].shadowMap);
-	gSkyboxMaterial->SetParameter("cubeMap", gSkyboxMap);
+	//gSkyboxMaterial->SetParameter(STRING_ID("cubeMap"), gPointLights[1].shadowData[0].shadowMap);
+	gSkyboxMaterial->SetParameter(STRING_ID("cubeMap"), gSkyboxMap);
 
 	gCubeMesh->Draw(renderContext, gSkyboxMaterial);
 }
@@ -2655,8 +2835,8 @@ void DebugForwardPass(RenderContext& renderContext)
 		Matrix4 modelMat = Matrix4::Identity();
 		modelMat.SetTranslation(gPointLights[i].position);
 		modelMat.ApplyScale(0.2f);
-		gLightDebugMaterial->SetParameter("modelMat", modelMat);
-		gLightDebugMaterial->SetParameter("color", gPointLights[i].color * 2, 3);
+		gLightDebugMaterial->SetParameter(STRING_ID("modelMat"), modelMat);
+		gLightDebugMaterial->SetParameter(STRING_ID("color"), gPointLights[i].color * 2, 3);
 
 		gIcosahedronMesh->Draw(renderContext, gLightDebugMaterial);
 	}
@@ -2666,8 +2846,8 @@ void DebugForwardPass(RenderContext& renderContext)
 		Matrix4 modelMat = MakeMatrixFromForward(gSpotLights[i].direction);
 		modelMat.SetTranslation(gSpotLights[i].position);
 		modelMat.ApplyScale(Vector4_3(gSpotLights[i].endRadius, gSpotLights[i].radius, gSpotLights[i].endRadius) * (0.4f / gSpotLights[i].radius));
-		gLightDebugMaterial->SetParameter("modelMat", modelMat);
-		gLightDebugMaterial->SetParameter("color", gSpotLights[i].color * 2, 3);
+		gLightDebugMaterial->SetParameter(STRING_ID("modelMat"), modelMat);
+		gLightDebugMaterial->SetParameter(STRING_ID("color"), gSpotLights[i].color * 2, 3);
 
 		gConeMesh->Draw(renderContext, gLightDebugMaterial);
 	}
@@ -2682,7 +2862,7 @@ void DebugForwardPass(RenderContext& renderContext)
 		for (int i = 0, ni = (int)MeshComponent::gMeshComponentContainer.size(); i < ni; ++i)
 		{
 			// draw bounds
-			MeshComponent*& meshComp = MeshComponent::gMeshComponentContainer[i];
+			MeshComponent* meshComp = &MeshComponent::gMeshComponentContainer[i];
 			Vector4_3 center = meshComp->bounds.GetCenter();
 			Vector4_3 extent = meshComp->bounds.GetExtent();
 
@@ -2692,8 +2872,8 @@ void DebugForwardPass(RenderContext& renderContext)
 
 			Matrix4 modelMat = meshComp->modelMat * boundMat;
 
-			gLightDebugMaterial->SetParameter("modelMat", modelMat);
-			gLightDebugMaterial->SetParameter("color", Vector4_3(1, 0, 0), 3);
+			gLightDebugMaterial->SetParameter(STRING_ID("modelMat"), modelMat);
+			gLightDebugMaterial->SetParameter(STRING_ID("color"), Vector4_3(1, 0, 0), 3);
 
 			gCubeMesh->Draw(renderContext, gLightDebugMaterial);
 		}
@@ -2715,7 +2895,7 @@ void DebugForwardPass(RenderContext& renderContext)
 
 	for (int i = 0, ni = (int)MeshComponent::gMeshComponentContainer.size(); i < ni; ++i)
 	{
-		MeshComponent*& meshComp = MeshComponent::gMeshComponentContainer[i];
+		MeshComponent* meshComp = &MeshComponent::gMeshComponentContainer[i];
 		if (IsOBBIntersectFrustum(meshComp->OBB.permutedAxisCenter, meshComp->OBB.extent, frustumPlanes, 6))
 		//if (IsOBBIntersectSphere(
 		//	meshComp->OBB.permutedAxisCenter, meshComp->OBB.center, meshComp->OBB.extent,
@@ -2730,8 +2910,8 @@ void DebugForwardPass(RenderContext& renderContext)
 
 			Matrix4 modelMat = meshComp->modelMat * boundMat;
 
-			gLightDebugMaterial->SetParameter("modelMat", modelMat);
-			gLightDebugMaterial->SetParameter("color", Vector4_3(1, 0, 0), 3);
+			gLightDebugMaterial->SetParameter(STRING_ID("modelMat"), modelMat);
+			gLightDebugMaterial->SetParameter(STRING_ID("color"), Vector4_3(1, 0, 0), 3);
 
 			gCubeMesh->Draw(renderContext, gLightDebugMaterial);
 		}
@@ -2747,8 +2927,8 @@ void DebugForwardPass(RenderContext& renderContext)
 			modelMat.SetTranslation(gPointLights[i].position);
 			modelMat.ApplyScale(gPointLights[i].radius);
 
-			gLightDebugMaterial->SetParameter("modelMat", modelMat);
-			gLightDebugMaterial->SetParameter("color", gPointLights[i].color * 2, 3);
+			gLightDebugMaterial->SetParameter(STRING_ID("modelMat"), modelMat);
+			gLightDebugMaterial->SetParameter(STRING_ID("color"), gPointLights[i].color * 2, 3);
 
 			gIcosahedronMesh->Draw(renderContext, gLightDebugMaterial);
 		}
@@ -2760,8 +2940,8 @@ void DebugForwardPass(RenderContext& renderContext)
 			modelMat.SetTranslation(gSpotLights[i].position);
 			modelMat.ApplyScale(gSpotLights[i].endRadius, gSpotLights[i].radius, gSpotLights[i].endRadius);
 
-			gLightDebugMaterial->SetParameter("modelMat", modelMat);
-			gLightDebugMaterial->SetParameter("color", gSpotLights[i].color * 2, 3);
+			gLightDebugMaterial->SetParameter(STRING_ID("modelMat"), modelMat);
+			gLightDebugMaterial->SetParameter(STRING_ID("color"), gSpotLights[i].color * 2, 3);
 
 			gConeMesh->Draw(renderContext, gLightDebugMaterial);
 		}
@@ -2773,8 +2953,8 @@ void DebugForwardPass(RenderContext& renderContext)
 		//	modelMat.SetTranslation(gSpotLights[i].sphereBounds.centerRadius);
 		//	modelMat.ApplyScale(gSpotLights[i].sphereBounds.centerRadius.w);
 
-		//	gLightDebugMaterial->SetParameter("modelMat", modelMat);
-		//	gLightDebugMaterial->SetParameter("color", gPointLights[i].color * 2, 3);
+		//	gLightDebugMaterial->SetParameter(STRING_ID("modelMat"), modelMat);
+		//	gLightDebugMaterial->SetParameter(STRING_ID("color"), gPointLights[i].color * 2, 3);
 
 		//	gIcosahedronMesh->Draw(renderContext, gLightDebugMaterial);
 		//}
@@ -2786,8 +2966,8 @@ void DebugForwardPass(RenderContext& renderContext)
 		//	modelMat.SetTranslation(gSpotLights[i].sphereBounds.centerRadius);
 		//	modelMat.ApplyScale(gSpotLights[i].sphereBounds.centerRadius.w);
 
-		//	gLightDebugMaterial->SetParameter("modelMat", modelMat);
-		//	gLightDebugMaterial->SetParameter("color", gSpotLights[i].color * 2, 3);
+		//	gLightDebugMaterial->SetParameter(STRING_ID("modelMat"), modelMat);
+		//	gLightDebugMaterial->SetParameter(STRING_ID("color"), gSpotLights[i].color * 2, 3);
 
 		//	gIcosahedronMesh->Draw(renderContext, gLightDebugMaterial);
 		//}
@@ -2849,10 +3029,10 @@ void PostProcessPassBeforeAlpha(RenderContext& renderContext)
 		PreparePostProcessPass();
 
 #if 1
-		gSSRMaterial->SetParameter("albedoTex", &gAlbedoTex);
-		gSSRMaterial->SetParameter("normalTex", &gNormalTex);
-		gSSRMaterial->SetParameter("materialTex", &gMaterialTex);
-		gSSRMaterial->SetParameter("skyTex", gSkyboxMap);
+		gSSRMaterial->SetParameter(STRING_ID("albedoTex"), &gAlbedoTex);
+		gSSRMaterial->SetParameter(STRING_ID("normalTex"), &gNormalTex);
+		gSSRMaterial->SetParameter(STRING_ID("materialTex"), &gMaterialTex);
+		gSSRMaterial->SetParameter(STRING_ID("skyTex"), gSkyboxMap);
 
 		// draw quad
 		gFSQuadMesh->Draw(renderContext, gSSRMaterial);
@@ -2883,17 +3063,17 @@ void PostProcessPassBeforeAlpha(RenderContext& renderContext)
 		glClearStencil(0);
 		glClear(GL_STENCIL_BUFFER_BIT);
 
-		gSSRStencilMaterial->SetParameter("materialTex", &gMaterialTex);
+		gSSRStencilMaterial->SetParameter(STRING_ID("materialTex"), &gMaterialTex);
 
 		// draw quad
 		gFSQuadMesh->Draw(renderContext, gSSRStencilMaterial);
 
 		renderStateSSR.Apply(renderContext);
 
-		gSSRMaterial->SetParameter("albedoTex", &gAlbedoTex);
-		gSSRMaterial->SetParameter("normalTex", &gNormalTex);
-		gSSRMaterial->SetParameter("materialTex", &gMaterialTex);
-		gSSRMaterial->SetParameter("skyTex", gSkyboxMap);
+		gSSRMaterial->SetParameter(STRING_ID("albedoTex"), &gAlbedoTex);
+		gSSRMaterial->SetParameter(STRING_ID("normalTex"), &gNormalTex);
+		gSSRMaterial->SetParameter(STRING_ID("materialTex"), &gMaterialTex);
+		gSSRMaterial->SetParameter(STRING_ID("skyTex"), gSkyboxMap);
 
 		// draw quad
 		gFSQuadMesh->Draw(renderContext, gSSRMaterial);
@@ -2930,15 +3110,15 @@ void PostProcessPass(RenderContext& renderContext)
 		// for the first frame, just use the same frame for history
 		if (gHasResetFrame)
 		{
-			gTAAMaterial->SetParameter("historyColorTex", &gSceneColorTex[gSceneColorReadIdx]);
-			//gTAAMaterial->SetParameter("historyDepthStencilTex", &gSceneDepthStencilTex[gSceneDepthCurrentIdx]);
+			gTAAMaterial->SetParameter(STRING_ID("historyColorTex"), &gSceneColorTex[gSceneColorReadIdx]);
+			//gTAAMaterial->SetParameter(STRING_ID("historyDepthStencilTex"), &gSceneDepthStencilTex[gSceneDepthCurrentIdx]);
 		}
 		else
 		{
-			gTAAMaterial->SetParameter("historyColorTex", &gSceneColorTex[gSceneColorHistoryIdx]);
-			//gTAAMaterial->SetParameter("historyDepthStencilTex", &gSceneDepthStencilTex[gSceneDepthHistoryIdx]);
+			gTAAMaterial->SetParameter(STRING_ID("historyColorTex"), &gSceneColorTex[gSceneColorHistoryIdx]);
+			//gTAAMaterial->SetParameter(STRING_ID("historyDepthStencilTex"), &gSceneDepthStencilTex[gSceneDepthHistoryIdx]);
 		}
-		gTAAMaterial->SetParameter("velocityTex", &gVelocityTex);
+		gTAAMaterial->SetParameter(STRING_ID("velocityTex"), &gVelocityTex);
 #if 0
 		// calculate weights
 		{
@@ -3011,12 +3191,12 @@ void VisualizeTexturePass(RenderContext& renderContext)
 	Texture2D* vTex = &gShadowTiledTex;//(Texture2D*)(gPointLights[2].shadowData[0].shadowMap);
 	//assert(gPointLights[2].shadowData[0].shadowMap->textureType == GL_TEXTURE_2D);
 	//assert(vTex->textureType == GL_TEXTURE_2D);
-	gVisualizeTextureMaterial->SetParameter("depthParams", 
+	gVisualizeTextureMaterial->SetParameter(STRING_ID("depthParams"), 
 		//Vector4_3(renderContext.viewPoint.nearPlane, renderContext.viewPoint.farPlane, 1.f), 3);
 		Vector4_3(0.01f, 40.f, 1.f), 3);
 		//Vector4_3(0.f, 0.f, 0.f), 3);
-	gVisualizeTextureMaterial->SetParameter("texSize", Vector4_2((float)vTex->width, (float)vTex->height), 2);
-	gVisualizeTextureMaterial->SetParameter("tex", vTex);
+	gVisualizeTextureMaterial->SetParameter(STRING_ID("texSize"), Vector4_2((float)vTex->width, (float)vTex->height), 2);
+	gVisualizeTextureMaterial->SetParameter(STRING_ID("tex"), vTex);
 
 	// draw quad
 	gFSQuadMesh->Draw(renderContext, gVisualizeTextureMaterial);
@@ -3061,6 +3241,78 @@ void UIPass()
 			ImGui::Text("%s \t %.3f ms %.2f%%", displayName.c_str(), it->second, timeRatio * 100);
 			ImGui::ProgressBar(timeRatio, ImVec2(0.f, 5.f));
 		}
+		// job workers, idle is time parked since start
+		ImGui::Text("Job Workers");
+		REArray<JobWorkerStats> workerStats;
+		GetJobWorkerStats(workerStats);
+		for (int i = 0; i < (int)workerStats.size(); ++i)
+		{
+			const JobWorkerStats& stats = workerStats[i];
+			float idleRatio = stats.runTimeNs > 0 ? (float)((double)stats.idleTimeNs / stats.runTimeNs) : 0.f;
+			float averageWakeLatency = stats.wakeCount > 0 ? (float)(stats.totalWakeLatencyNs / 1000.0 / stats.wakeCount) : 0.f;
+			ImGui::Text("worker %d \t idle %.1f%% \t wake %.1f us (max %.1f us)", i, idleRatio * 100, averageWakeLatency, stats.maxWakeLatencyNs / 1000.0);
+			ImGui::ProgressBar(idleRatio, ImVec2(0.f, 5.f));
+		}
+#if JOB_STATS
+		const char* priorityNames[] = { "high", "normal", "low", "render" };
+		REArray<JobPriorityStats> priorityStats;
+		GetJobPriorityStats(priorityStats);
+		for (int i = 0; i < (int)priorityStats.size(); ++i)
+		{
+			const JobPriorityStats& stats = priorityStats[i];
+			float averageWaitTime = stats.jobCount > 0 ? (float)(stats.totalWaitTimeNs / 1000.0 / stats.jobCount) : 0.f;
+			ImGui::Text("%s \t queued %d \t wait %.1f us (max %.1f us) \t cancelled %d", priorityNames[i], (int)stats.queueDepth, averageWaitTime,
+				stats.maxWaitTimeNs / 1000.0, (int)stats.cancelledCount);
+			// log2 buckets in us, see gJobStatsHistogramBucketCount
+			float waitTimeHistogram[gJobStatsHistogramBucketCount];
+			for (int bucket = 0; bucket < gJobStatsHistogramBucketCount; ++bucket)
+			{
+				waitTimeHistogram[bucket] = (float)stats.waitTimeHistogram[bucket];
+			}
+			ImGui::PushID(i);
+			ImGui::PlotHistogram("", waitTimeHistogram, gJobStatsHistogramBucketCount, 0, 0, 0.f, FLT_MAX, ImVec2(0.f, 30.f));
+			ImGui::PopID();
+		}
+#endif
+		// frame allocator, high-water mark of every frame
+		{
+			FrameAllocator::Stats frameStats = gFrameAllocator.GetStats();
+			ImGui::Text("Frame Allocator \t last %.1f KB \t peak %.1f KB \t capacity %.1f KB x %d \t overflow %.1f KB", frameStats.lastFrameSize / 1024.0,
+				frameStats.peakFrameSize / 1024.0, frameStats.capacity / 1024.0, frameStats.frameCount, frameStats.lastOverflowSize / 1024.0);
+			float frameUsage[FrameAllocator::HISTORY_COUNT];
+			for (int i = 0; i < FrameAllocator::HISTORY_COUNT; ++i)
+			{
+				// oldest first
+				frameUsage[i] = (float)(gFrameAllocator.GetFrameUsage(FrameAllocator::HISTORY_COUNT - 1 - i) / 1024.0);
+			}
+			ImGui::PlotLines("", frameUsage, FrameAllocator::HISTORY_COUNT, 0, 0, 0.f, FLT_MAX, ImVec2(0.f, 30.f));
+		}
+		// memory per tag against its budget, red when over
+		if (ImGui::CollapsingHeader("Memory"))
+		{
+			int64_t totalBytes[2] = { 0, 0 };
+			for (int tag = 0; tag < (int)EMemoryTag::Count; ++tag)
+			{
+				MemoryTagStats memoryStats = GetMemoryTagStats((EMemoryTag)tag);
+				totalBytes[IsGPUMemoryTag((EMemoryTag)tag)] += memoryStats.liveBytes;
+				float budgetRatio = memoryStats.budgetBytes > 0 ? (float)((double)memoryStats.liveBytes / memoryStats.budgetBytes) : 0.f;
+				ImColor budgetColor = budgetRatio > 1.f ? red : (budgetRatio > 0.8f ? yellow : green);
+				ImGui::TextColored(budgetColor, "%s \t %.1f MB / %.1f MB \t peak %.1f MB \t %lld allocations", GetMemoryTagName((EMemoryTag)tag),
+					memoryStats.liveBytes / 1048576.0, memoryStats.budgetBytes / 1048576.0, memoryStats.peakBytes / 1048576.0, (long long)memoryStats.liveAllocationCount);
+				ImGui::ProgressBar(Clamp(budgetRatio, 0.f, 1.f), ImVec2(0.f, 5.f));
+			}
+			ImGui::Text("CPU %.1f MB \t GPU %.1f MB", totalBytes[0] / 1048576.0, totalBytes[1] / 1048576.0);
+			if (ImGui::Button("Dump Memory Stats"))
+				DumpMemoryStatsFile();
+		}
+#if JOB_TRACE
+		// open in chrome://tracing or ui.perfetto.dev
+		if (ImGui::Button("Dump Job Trace"))
+		{
+			if (!DumpJobTrace("JobTrace.json"))
+				printf("failed to dump job trace\n");
+		}
+#endif
 
 		ImGui::End();
 	}
@@ -3120,12 +3372,8 @@ void UIPass()
 	ImGui::Render();
 }
 
-void Render()
+void SetupView()
 {
-	GPU_SCOPED_PROFILE("render");
-	CPU_SCOPED_PROFILE("render");
-
-	RenderContext renderContext;
 	float jitterX = 0, jitterY = 0;
 	if (gRenderSettings.bUseJitter)
 	{
@@ -3136,18 +3384,21 @@ void Render()
 		if (gJitterIdx >= gJitterCount)
 			gJitterIdx -= gJitterCount;
 	}
-	renderContext.viewPoint = gCamera.ProcessCamera((GLfloat)gWindowWidth, (GLfloat)gWindowHeight, 0.1f, 200.f, jitterX, jitterY);
-	
-	// cull lights
-	CullLights(renderContext);
+	gFrameRenderContext.viewPoint = gCamera.ProcessCamera((GLfloat)gWindowWidth, (GLfloat)gWindowHeight, 0.1f, 200.f, jitterX, jitterY);
+}
+
+// lights and meshes are culled by the frame graph before this
+void Render()
+{
+	GPU_SCOPED_PROFILE("render");
+	CPU_SCOPED_PROFILE("render");
+
+	RenderContext& renderContext = gFrameRenderContext;
 	
 	// bind shadow buffer
 	gDepthOnlyBuffer.Bind();
 	ShadowPass(renderContext);
 
-	// cull meshes
-	CullMeshes(renderContext);
-
 	glViewport(0, 0, gWindowWidth, gWindowHeight);
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
@@ -3289,8 +3540,8 @@ void Render()
 void ProcessShaderReload()
 {
 	static REArray<FileChangeResult> results;
-	static RESet<std::string> changedFiles;
-	static RESet<Shader*> changedShaders;
+	static REFlatSet<std::string> changedFiles;
+	static REFlatSet<Shader*> changedShaders;
 	results.clear();
 	changedFiles.clear();
 	changedShaders.clear();
@@ -3307,7 +3558,7 @@ void ProcessShaderReload()
 				auto pair = changedFiles.insert(result.fileName);
 				if (pair.second)
 				{
-					ShaderFileInfo& shaderFileInfo = gShaderFileCache[result.fileName];
+					ShaderFileInfo& shaderFileInfo = it->second;
 					for (const std::string& childFile : shaderFileInfo.childFiles)
 					{
 						changedFiles.insert(childFile);
@@ -3339,6 +3590,68 @@ void ProcessShaderReload()
 	}
 }
 
+// frame stages as jobs, GL work stays on the render processor, culling runs on the workers
+JOB_ENTRY_POINT(ShaderReloadJob)
+{
+	ProcessShaderReload();
+}
+
+JOB_ENTRY_POINT(UpdateJob)
+{
+	Update(gLastDeltaTime);
+}
+
+JOB_ENTRY_POINT(SetupViewJob)
+{
+	SetupView();
+}
+
+// only this one uses CPU_SCOPED_PROFILE among the jobs running together, the cpu profiler isn't thread safe
+JOB_ENTRY_POINT(CullLightsJob)
+{
+	CullLights(gFrameRenderContext);
+}
+
+JOB_ENTRY_POINT(CullMeshesJob)
+{
+	CullMeshes(gFrameRenderContext);
+}
+
+JOB_ENTRY_POINT(CSMBoundsJob)
+{
+	UpdateCSMLightSpaceBounds();
+}
+
+JOB_ENTRY_POINT(RenderJob)
+{
+	Render();
+}
+
+// shader reload -> update -> setup view -> (cull lights, cull meshes, csm bounds) -> render
+JobGraph gFrameGraph;
+
+void BuildFrameGraph()
+{
+	gFrameGraph.Clear();
+
+	int shaderReloadNode = gFrameGraph.AddNode(JobDescriptor(&ShaderReloadJob, 0, EJobPriority::Render, gJobLargeStackSize));
+	int updateNode = gFrameGraph.AddNode(JobDescriptor(&UpdateJob, 0, EJobPriority::Render, gJobLargeStackSize));
+	int setupViewNode = gFrameGraph.AddNode(JobDescriptor(&SetupViewJob, 0, EJobPriority::High));
+	int cullLightsNode = gFrameGraph.AddNode(JobDescriptor(&CullLightsJob, 0, EJobPriority::High));
+	int cullMeshesNode = gFrameGraph.AddNode(JobDescriptor(&CullMeshesJob, 0, EJobPriority::High));
+	int csmBoundsNode = gFrameGraph.AddNode(JobDescriptor(&CSMBoundsJob, 0, EJobPriority::High));
+	int renderNode = gFrameGraph.AddNode(JobDescriptor(&RenderJob, 0, EJobPriority::Render, gJobLargeStackSize));
+
+	gFrameGraph.AddDependency(updateNode, shaderReloadNode);
+	gFrameGraph.AddDependency(setupViewNode, updateNode);
+	gFrameGraph.AddDependency(cullLightsNode, setupViewNode);
+	gFrameGraph.AddDependency(cullMeshesNode, setupViewNode);
+	gFrameGraph.AddDependency(csmBoundsNode, setupViewNode);
+	gFrameGraph.AddDependency(renderNode, cullLightsNode);
+	gFrameGraph.AddDependency(renderNode, cullMeshesNode);
+	gFrameGraph.AddDependency(renderNode, csmBoundsNode);
+}
+
 JOB_ENTRY_POINT(MainGameLoop)
 {
 	if (!Init())
@@ -3347,6 +3660,8 @@ JOB_ENTRY_POINT(MainGameLoop)
 	}
 	else
 	{
+		BuildFrameGraph();
+
 		//Main loop flag
 		bool quit = false;
 
@@ -3371,12 +3686,18 @@ JOB_ENTRY_POINT(MainGameLoop)
 					if (event.key.keysym.sym == SDLK_r)
 					{
 						LoadShaders(true);
-						for (int i = 0, ni = (int)Material::gMaterialContainer.size(); i < ni; ++i)
-							Material::gMaterialContainer[i]->Reload();
+						for (Material& material : Material::gMaterialContainer)
+							material.Reload();
 						//Mesh** meshlContainerPtr = Mesh::gMeshContainer.data();
 						//for (int i = 0, ni = (int)Mesh::gMeshContainer.size(); i < ni; ++i)
 						//	meshlContainerPtr[i]->SetAttributes();
 					}
+					else if (event.key.keysym.sym == SDLK_m)
+					{
+						// live and peak bytes per memory tag
+						DumpMemoryTagStats();
+						DumpMemoryStatsFile();
+					}
 #if LOAD_CACHE_SIM
 					else if (event.key.keysym.sym == SDLK_c)
 					{
@@ -3402,13 +3723,24 @@ JOB_ENTRY_POINT(MainGameLoop)
 #endif
 			bool bPrevForward = gRenderSettings.bForward;
 
-			ProcessShaderReload();
-
-			Update(gLastDeltaTime);
+			// the GPU must be done with the frame that used this buffer last, usually long ago
+			int frameBufferIdx = gFrameAllocator.GetNextFrameIndex();
+			if (gFrameFences[frameBufferIdx])
+			{
+				glClientWaitSync(gFrameFences[frameBufferIdx], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+				glDeleteSync(gFrameFences[frameBufferIdx]);
+				gFrameFences[frameBufferIdx] = 0;
+			}
+			gFrameAllocator.BeginFrame();
 
-			Render();
+			{
+				JobWaitingCounter frameCounter;
+				gFrameGraph.Run(&frameCounter);
+				WaitOnCounter(&frameCounter);
+			}
 
 			SDL_GL_SwapWindow(gWindow);
+			gFrameFences[frameBufferIdx] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
 			// we changed pipeline, refresh materials
 			if (bPrevForward != gRenderSettings.bForward)
@@ -3425,11 +3757,10 @@ JOB_ENTRY_POINT(MainGameLoop)
 					prevShaderPtr = &gForwardShader;
 					newShaderPtr = &gGBufferShader;
 				}
-				for (int i = 0, ni = (int)Material::gMaterialContainer.size(); i < ni; ++i)
+				for (Material& mat : Material::gMaterialContainer)
 				{
-					Material* mat = Material::gMaterialContainer[i];
-					if(mat->shader == prevShaderPtr)
-						mat->Reload(newShaderPtr);
+					if(mat.shader == prevShaderPtr)
+						mat.Reload(newShaderPtr);
 				}
 			}
 			
@@ -3461,6 +3792,8 @@ JOB_ENTRY_POINT(MainGameLoop)
 			}
 #endif
 
+			CheckMemoryBudgets();
+
 			gHasResetFrame = false;
 
 #if LOAD_CACHE_SIM
@@ -3478,7 +3811,8 @@ JOB_ENTRY_POINT(MainGameLoop)
 
 int main(int argc, char **argv)
 {
-	JobDescriptor startJobDesc(&MainGameLoop, 0, EJobPriority::Render);
+	// main loop loads meshes (assimp, recursive ProcessNode) and runs the whole frame, give it a big stack
+	JobDescriptor startJobDesc(&MainGameLoop, 0, EJobPriority::Render, gJobLargeStackSize);
 
 	RunJobSystem(&startJobDesc);
 